@@ -0,0 +1,442 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "analytics.h"
+#include "bitboard.h"
+#include "threadpool.h"
+
+// Accumulators of one worker of analyzeRecordFile, padded so that workers
+// never share a cache line.
+typedef struct {
+    _Alignas(64) GameAnalytics analytics;
+    bool failed;
+} AnalyticsWorker;
+
+typedef struct {
+    const uint8_t *data;    // Mapped record file
+    const size_t *chunks;   // Offset of the first record of each chunk, then the end of the last one
+    AnalyticsWorker *workers;
+} AnalyticsJob;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Counters in the single block of an analytics: three heatmaps, the game
+// lengths, then the shots to win of each strategy.
+static size_t analyticsCounters(int cells) {
+    return 3 * (size_t)cells + (2 * (size_t)cells + 1) + ANALYTICS_STRATEGIES * ((size_t)cells + 1);
+}
+
+bool initializeGameAnalytics(GameAnalytics *analytics, int width, int height) {
+    memset(analytics, 0, sizeof(GameAnalytics));
+    analytics->width = width;
+    analytics->height = height;
+    analytics->cells = width * height;
+
+    long *counters = (long*)calloc(analyticsCounters(analytics->cells), sizeof(long));
+    if (counters == NULL) {
+        fprintf(stderr, "Memory allocation failed for game analytics.\n");
+        return false;
+    }
+    analytics->occupancy = counters;
+    analytics->shots = analytics->occupancy + analytics->cells;
+    analytics->hits = analytics->shots + analytics->cells;
+    analytics->gameLength = analytics->hits + analytics->cells;
+    long *shotsToWin = analytics->gameLength + 2 * analytics->cells + 1;
+    for (int i = 0; i < ANALYTICS_STRATEGIES; i++) {
+        analytics->strategies[i].shotsToWin = shotsToWin + (size_t)i * (analytics->cells + 1);
+    }
+    return true;
+}
+
+// Function to count a game once its cells are in the heatmaps: `fired` and
+// `hit` are the shots and hits of each player, `winner` 0 when nobody won.
+static void countGame(GameAnalytics *analytics, const AiStrategy strategies[2], int winner,
+                      const int fired[2], const int hit[2]) {
+    analytics->games++;
+    for (int player = 0; player < 2; player++) {
+        StrategyAnalytics *strategy = &analytics->strategies[strategies[player]];
+        strategy->sides++;
+        strategy->shots += fired[player];
+        strategy->hits += hit[player];
+    }
+    if (winner == 0) {
+        analytics->unfinished++;
+        return;
+    }
+
+    int length = fired[0] + fired[1];
+    int shots = fired[winner - 1];
+    StrategyAnalytics *strategy = &analytics->strategies[strategies[winner - 1]];
+    analytics->gameLength[length <= 2 * analytics->cells ? length : 2 * analytics->cells]++;
+    strategy->wins++;
+    strategy->shotsToWin[shots <= analytics->cells ? shots : analytics->cells]++;
+}
+
+static uint32_t packedShot(const GameRecord *record, uint32_t index) {
+    return readLe24(record->shots + (size_t)index * RECORD_SHOT_SIZE);
+}
+
+// Function to add a recorded game, straight from its fleets and shots without
+// replaying it. Records of another board size, and those whose boats or shots
+// fall off the board, are only counted as skipped.
+bool addRecordToAnalytics(GameAnalytics *analytics, const GameRecord *record) {
+    int width = analytics->width;
+    int height = analytics->height;
+
+    if (record->width != width || record->height != height || record->winner > 2
+        || (unsigned)record->strategies[0] >= ANALYTICS_STRATEGIES
+        || (unsigned)record->strategies[1] >= ANALYTICS_STRATEGIES
+        || record->boatCounts[0] > MAX_BOATS || record->boatCounts[1] > MAX_BOATS) {
+        analytics->skipped++;
+        return false;
+    }
+    for (int player = 1; player <= 2; player++) {
+        for (int i = 0; i < record->boatCounts[player - 1]; i++) {
+            Boat boat = recordedBoat(record, player, i);
+            int right = boat.orientation == HORIZONTAL ? boat.x + boat.size : boat.x + 1;
+            int bottom = boat.orientation == VERTICAL ? boat.y + boat.size : boat.y + 1;
+            if (boat.size < 1 || right > width || bottom > height) {
+                analytics->skipped++;
+                return false;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < record->shotCount; i++) {
+        if ((int)(packedShot(record, i) & 0xfffff) >= analytics->cells) {
+            analytics->skipped++;
+            return false;
+        }
+    }
+
+    // Both fleets, then every shot on the board it was fired at.
+    for (int player = 1; player <= 2; player++) {
+        for (int i = 0; i < record->boatCounts[player - 1]; i++) {
+            Boat boat = recordedBoat(record, player, i);
+            int step = boat.orientation == HORIZONTAL ? 1 : width;
+            long *cell = analytics->occupancy + boat.y * width + boat.x;
+            for (int k = 0; k < boat.size; k++) cell[k * step]++;
+        }
+    }
+    int fired[2] = { 0, 0 };
+    int hit[2] = { 0, 0 };
+    for (uint32_t i = 0; i < record->shotCount; i++) {
+        uint32_t packed = packedShot(record, i);
+        int cell = (int)(packed & 0xfffff);
+        int shooter = (int)(packed >> 23 & 1);
+        int touched = (packed >> 20 & 3) != SHOT_MISS;
+        analytics->shots[cell]++;
+        analytics->hits[cell] += touched;
+        fired[shooter]++;
+        hit[shooter] += touched;
+    }
+    countGame(analytics, record->strategies, record->winner, fired, hit);
+    return true;
+}
+
+// Adds one to `counts` at every bit set in `mask`.
+static void countBits(long *counts, const uint64_t *mask, int words) {
+    for (int w = 0; w < words; w++) {
+        for (uint64_t bits = mask[w]; bits; bits &= bits - 1) {
+            counts[w * 64 + __builtin_ctzll(bits)]++;
+        }
+    }
+}
+
+// Function to add a game that was just played, read from the masks of its
+// boards. `shots` holds the shots each player fired, `winner` is 1 or 2.
+void addGameToAnalytics(GameAnalytics *analytics, const Game *game, int winner, const int shots[2]) {
+    // Player 1 shoots at player 2's board and the other way around.
+    const GameBoard *targets[2] = { &game->player2Board, &game->player1Board };
+    AiStrategy strategies[2] = { game->player1Targeting.strategy, game->player2Targeting.strategy };
+    int hit[2];
+
+    for (int player = 0; player < 2; player++) {
+        const GameBoard *board = targets[player];
+        countBits(analytics->occupancy, board->boats, board->words);
+        countBits(analytics->shots, board->shots, board->words);
+        countBits(analytics->hits, board->wrecks, board->words);
+        hit[player] = bitCount(board->wrecks, board->words);
+    }
+    countGame(analytics, strategies, winner, shots, hit);
+}
+
+void mergeGameAnalytics(GameAnalytics *into, const GameAnalytics *from) {
+    into->games += from->games;
+    into->unfinished += from->unfinished;
+    into->skipped += from->skipped;
+    for (int i = 0; i < ANALYTICS_STRATEGIES; i++) {
+        into->strategies[i].sides += from->strategies[i].sides;
+        into->strategies[i].wins += from->strategies[i].wins;
+        into->strategies[i].shots += from->strategies[i].shots;
+        into->strategies[i].hits += from->strategies[i].hits;
+    }
+    // Every counter array lies in the one block.
+    size_t counters = analyticsCounters(into->cells);
+    for (size_t i = 0; i < counters; i++) {
+        into->occupancy[i] += from->occupancy[i];
+    }
+}
+
+static void analyzeChunks(void *context, int worker, long begin, long end) {
+    AnalyticsJob *job = (AnalyticsJob*)context;
+    GameAnalytics *mine = &job->workers[worker].analytics;
+    GameRecord record;
+
+    for (long chunk = begin; chunk < end; chunk++) {
+        RecordReader reader = { job->data, job->chunks[chunk + 1], job->chunks[chunk] };
+        while (nextGameRecord(&reader, &record)) {
+            addRecordToAnalytics(mine, &record);
+        }
+    }
+}
+
+// Function to add every game of a record file, on `threads` threads. The
+// records are first walked once by their lengths to cut the file in chunks,
+// then decoded by the workers. On a truncated or corrupt file, the records
+// before the damage are counted and false is returned.
+bool analyzeRecordFile(GameAnalytics *analytics, const char *path, int threads) {
+    RecordReader reader;
+    GameRecord record;
+    double start = nowSeconds();
+
+    if (!openRecordReader(&reader, path)) return false;
+
+    size_t *chunks = NULL;
+    long count = 0, capacity = 0, records = 0;
+    bool ok = true;
+    for (;;) {
+        if (count + 1 >= capacity) {
+            capacity = capacity ? 2 * capacity : 1024;
+            size_t *grown = (size_t*)realloc(chunks, capacity * sizeof(size_t));
+            if (grown == NULL) {
+                fprintf(stderr, "Memory allocation failed for record chunks.\n");
+                free(chunks);
+                closeRecordReader(&reader);
+                return false;
+            }
+            chunks = grown;
+        }
+        if (records % ANALYTICS_CHUNK_RECORDS == 0) chunks[count++] = reader.offset;
+        if (!nextGameRecord(&reader, &record)) break;
+        records++;
+    }
+    chunks[count] = reader.offset;
+    if (reader.offset != reader.size) ok = false;
+
+    ThreadPool *pool = createThreadPool(threads);
+    AnalyticsWorker *workers = NULL;
+    if (pool) {
+        threads = threadPoolSize(pool);
+        workers = (AnalyticsWorker*)aligned_alloc(64, threads * sizeof(AnalyticsWorker));
+        if (workers == NULL) fprintf(stderr, "Memory allocation failed for analytics workers.\n");
+    }
+    if (workers == NULL) {
+        freeThreadPool(pool);
+        free(chunks);
+        closeRecordReader(&reader);
+        return false;
+    }
+    bool ready = true;
+    for (int i = 0; i < threads; i++) {
+        workers[i].failed = !initializeGameAnalytics(&workers[i].analytics, analytics->width, analytics->height);
+        if (workers[i].failed) ready = false;
+    }
+
+    // Nothing is read unless every worker could be set up.
+    AnalyticsJob job = { reader.data, chunks, workers };
+    if (ready) {
+        runThreadPool(pool, count, 1, analyzeChunks, &job);
+    } else {
+        ok = false;
+    }
+
+    // Merge the per-worker accumulators once everything is done.
+    for (int i = 0; i < threads; i++) {
+        if (!workers[i].failed) mergeGameAnalytics(analytics, &workers[i].analytics);
+        freeGameAnalytics(&workers[i].analytics);
+    }
+    free(workers);
+    freeThreadPool(pool);
+    free(chunks);
+    closeRecordReader(&reader);
+    analytics->seconds += nowSeconds() - start;
+    return ok;
+}
+
+// Smallest value reached by at least `share` of the `total` entries of a
+// histogram of `size` bins, 0 for an empty one.
+static int histogramPercentile(const long *histogram, int size, long total, double share) {
+    long target = (long)ceil(share * total);
+    long seen = 0;
+
+    if (total == 0) return 0;
+    for (int i = 0; i < size; i++) {
+        seen += histogram[i];
+        if (seen >= target && seen > 0) return i;
+    }
+    return size - 1;
+}
+
+static double histogramMean(const long *histogram, int size, long total) {
+    double sum = 0;
+
+    for (int i = 0; i < size; i++) sum += (double)i * histogram[i];
+    return total ? sum / total : 0.0;
+}
+
+void printGameAnalytics(const GameAnalytics *analytics, FILE *out) {
+    int cells = analytics->cells;
+    long finished = analytics->games - analytics->unfinished;
+
+    fprintf(out, "Board:          %dx%d\n", analytics->width, analytics->height);
+    fprintf(out, "Games:          %ld in %.3f s (%.0f games/s), %ld unfinished, %ld skipped\n",
+            analytics->games, analytics->seconds,
+            analytics->seconds > 0 ? analytics->games / analytics->seconds : 0.0,
+            analytics->unfinished, analytics->skipped);
+    if (analytics->games == 0) return;
+    if (finished > 0) {
+        fprintf(out, "Game length:    mean %.2f shots, p10 %d, p50 %d, p90 %d\n",
+                histogramMean(analytics->gameLength, 2 * cells + 1, finished),
+                histogramPercentile(analytics->gameLength, 2 * cells + 1, finished, 0.1),
+                histogramPercentile(analytics->gameLength, 2 * cells + 1, finished, 0.5),
+                histogramPercentile(analytics->gameLength, 2 * cells + 1, finished, 0.9));
+    }
+
+    // One line per strategy that played.
+    fprintf(out, "Strategy        sides     wins    hit rate  shots to win: mean   p50   p90\n");
+    for (int i = 0; i < ANALYTICS_STRATEGIES; i++) {
+        const StrategyAnalytics *strategy = &analytics->strategies[i];
+        if (strategy->sides == 0) continue;
+        fprintf(out, "  %-12s %8ld  %6.2f%%    %6.2f%%               %6.2f %5d %5d\n",
+                aiStrategyName((AiStrategy)i), strategy->sides, 100.0 * strategy->wins / strategy->sides,
+                strategy->shots ? 100.0 * strategy->hits / strategy->shots : 0.0,
+                histogramMean(strategy->shotsToWin, cells + 1, strategy->wins),
+                histogramPercentile(strategy->shotsToWin, cells + 1, strategy->wins, 0.5),
+                histogramPercentile(strategy->shotsToWin, cells + 1, strategy->wins, 0.9));
+    }
+
+    // How far the placement is from uniform: each cell against the mean.
+    long total = 0, least = analytics->occupancy[0], most = analytics->occupancy[0];
+    for (int i = 0; i < cells; i++) {
+        total += analytics->occupancy[i];
+        if (analytics->occupancy[i] < least) least = analytics->occupancy[i];
+        if (analytics->occupancy[i] > most) most = analytics->occupancy[i];
+    }
+    double mean = (double)total / cells;
+    fprintf(out, "Occupancy:      %.2f to %.2f times the mean cell\n", mean > 0 ? least / mean : 0.0,
+            mean > 0 ? most / mean : 0.0);
+    if (analytics->width > 20) return;
+
+    // Share of the fleets with a boat on each cell, in percent.
+    double fleets = 2.0 * analytics->games;
+    fprintf(out, "   ");
+    for (int x = 0; x < analytics->width; x++) fprintf(out, " %5d", x);
+    fprintf(out, "\n");
+    for (int y = 0; y < analytics->height; y++) {
+        fprintf(out, "%3d", y);
+        for (int x = 0; x < analytics->width; x++) {
+            fprintf(out, " %5.1f", 100 * analytics->occupancy[y * analytics->width + x] / fleets);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+// Function to write the analytics as one CSV table, one count per row:
+// table,strategy,x,y,value. The heatmaps (occupancy, shots, hits) fill x and
+// y; the histograms (game_length, and shots_to_win per strategy) put the shot
+// count in x; the totals (games, unfinished, skipped, and sides, wins, shots,
+// hits per strategy) leave both empty.
+bool writeAnalyticsCsv(const GameAnalytics *analytics, FILE *out) {
+    const char *maps[3] = { "occupancy", "shots", "hits" };
+    const long *counts[3] = { analytics->occupancy, analytics->shots, analytics->hits };
+
+    fprintf(out, "table,strategy,x,y,value\n");
+    fprintf(out, "games,,,,%ld\nunfinished,,,,%ld\nskipped,,,,%ld\n",
+            analytics->games, analytics->unfinished, analytics->skipped);
+    for (int map = 0; map < 3; map++) {
+        for (int cell = 0; cell < analytics->cells; cell++) {
+            fprintf(out, "%s,,%d,%d,%ld\n", maps[map], cell % analytics->width, cell / analytics->width,
+                    counts[map][cell]);
+        }
+    }
+    for (int shots = 0; shots <= 2 * analytics->cells; shots++) {
+        if (analytics->gameLength[shots]) fprintf(out, "game_length,,%d,,%ld\n", shots, analytics->gameLength[shots]);
+    }
+    for (int i = 0; i < ANALYTICS_STRATEGIES; i++) {
+        const StrategyAnalytics *strategy = &analytics->strategies[i];
+        const char *name = aiStrategyName((AiStrategy)i);
+        if (strategy->sides == 0) continue;
+        fprintf(out, "sides,%s,,,%ld\nwins,%s,,,%ld\nshots,%s,,,%ld\nhits,%s,,,%ld\n", name, strategy->sides,
+                name, strategy->wins, name, strategy->shots, name, strategy->hits);
+        for (int shots = 0; shots <= analytics->cells; shots++) {
+            if (strategy->shotsToWin[shots]) {
+                fprintf(out, "shots_to_win,%s,%d,,%ld\n", name, shots, strategy->shotsToWin[shots]);
+            }
+        }
+    }
+    return !ferror(out);
+}
+
+// A heatmap as an array of rows.
+static void writeJsonHeatmap(const GameAnalytics *analytics, const char *name, const long *counts, FILE *out) {
+    fprintf(out, "  \"%s\": [", name);
+    for (int y = 0; y < analytics->height; y++) {
+        fprintf(out, "%s\n    [", y ? "," : "");
+        for (int x = 0; x < analytics->width; x++) {
+            fprintf(out, "%s%ld", x ? ", " : "", counts[y * analytics->width + x]);
+        }
+        fprintf(out, "]");
+    }
+    fprintf(out, "\n  ],\n");
+}
+
+static void writeJsonHistogram(const long *histogram, int size, FILE *out) {
+    fprintf(out, "[");
+    for (int i = 0; i < size; i++) fprintf(out, "%s%ld", i ? ", " : "", histogram[i]);
+    fprintf(out, "]");
+}
+
+// Function to write the analytics as one JSON object. The histograms are
+// indexed by shot count, from 0.
+bool writeAnalyticsJson(const GameAnalytics *analytics, FILE *out) {
+    int cells = analytics->cells;
+    bool first = true;
+
+    fprintf(out, "{\n  \"width\": %d,\n  \"height\": %d,\n", analytics->width, analytics->height);
+    fprintf(out, "  \"games\": %ld,\n  \"unfinished\": %ld,\n  \"skipped\": %ld,\n  \"seconds\": %.3f,\n",
+            analytics->games, analytics->unfinished, analytics->skipped, analytics->seconds);
+    writeJsonHeatmap(analytics, "occupancy", analytics->occupancy, out);
+    writeJsonHeatmap(analytics, "shots", analytics->shots, out);
+    writeJsonHeatmap(analytics, "hits", analytics->hits, out);
+    fprintf(out, "  \"gameLength\": ");
+    writeJsonHistogram(analytics->gameLength, 2 * cells + 1, out);
+    fprintf(out, ",\n  \"strategies\": {");
+    for (int i = 0; i < ANALYTICS_STRATEGIES; i++) {
+        const StrategyAnalytics *strategy = &analytics->strategies[i];
+        if (strategy->sides == 0) continue;
+        fprintf(out, "%s\n    \"%s\": {\"sides\": %ld, \"wins\": %ld, \"shots\": %ld, \"hits\": %ld, "
+                     "\"hitRate\": %.6f, \"meanShotsToWin\": %.4f,\n      \"shotsToWin\": ",
+                first ? "" : ",", aiStrategyName((AiStrategy)i), strategy->sides, strategy->wins,
+                strategy->shots, strategy->hits, strategy->shots ? (double)strategy->hits / strategy->shots : 0.0,
+                histogramMean(strategy->shotsToWin, cells + 1, strategy->wins));
+        writeJsonHistogram(strategy->shotsToWin, cells + 1, out);
+        fprintf(out, "}");
+        first = false;
+    }
+    fprintf(out, "\n  }\n}\n");
+    return !ferror(out);
+}
+
+void freeGameAnalytics(GameAnalytics *analytics) {
+    if (analytics) {
+        free(analytics->occupancy);
+        analytics->occupancy = analytics->shots = analytics->hits = analytics->gameLength = NULL;
+        for (int i = 0; i < ANALYTICS_STRATEGIES; i++) analytics->strategies[i].shotsToWin = NULL;
+    }
+}
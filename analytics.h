@@ -0,0 +1,58 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "game.h"
+#include "record.h"
+
+// Aggregates over many games of one board size, read from record files or
+// taken from games as they are simulated (see SimulationConfig):
+//   - per cell, how many fleets have a boat there (where placeRandomBoat puts
+//     them), how many shots it received and how many of them hit, both
+//     players' boards added up;
+//   - the number of shots both players fired before the game ended;
+//   - per strategy, the sides it played and won, its shots and hits, and the
+//     histogram of its shot count in the games it won.
+//
+// Everything is a count, so the accumulators of several threads add up to
+// the same result whatever the order: each worker fills its own and they are
+// merged at the end. analyzeRecordFile splits a file into chunks of
+// ANALYTICS_CHUNK_RECORDS records and reads them on every core.
+#define ANALYTICS_STRATEGIES (AI_EXACT + 1)
+#define ANALYTICS_CHUNK_RECORDS 4096
+
+typedef struct {
+    long sides;         // Sides played: a game between two players of this strategy counts twice
+    long wins;
+    long shots;         // Shots fired
+    long hits;          // Shots on a boat, the sinking ones included
+    long *shotsToWin;   // Histogram of its shot count in the games it won, cells + 1 entries
+} StrategyAnalytics;
+
+typedef struct {
+    int width;
+    int height;
+    int cells;
+    long games;         // Games counted, the unfinished ones included
+    long unfinished;    // Recorded games without a winner, left out of the histograms
+    long skipped;       // Records of another board size or with cells off the board
+    long *occupancy;    // Per cell: fleets with a boat there, two per game
+    long *shots;        // Per cell: shots received
+    long *hits;         // Per cell: shots received that hit a boat
+    long *gameLength;   // Histogram of the shots both players fired, 2 * cells + 1 entries
+    StrategyAnalytics strategies[ANALYTICS_STRATEGIES];
+    double seconds;     // Wall time spent gathering
+} GameAnalytics;
+
+bool initializeGameAnalytics(GameAnalytics *analytics, int width, int height);
+bool addRecordToAnalytics(GameAnalytics *analytics, const GameRecord *record);
+void addGameToAnalytics(GameAnalytics *analytics, const Game *game, int winner, const int shots[2]);
+void mergeGameAnalytics(GameAnalytics *into, const GameAnalytics *from);
+bool analyzeRecordFile(GameAnalytics *analytics, const char *path, int threads);
+void printGameAnalytics(const GameAnalytics *analytics, FILE *out);
+bool writeAnalyticsCsv(const GameAnalytics *analytics, FILE *out);
+bool writeAnalyticsJson(const GameAnalytics *analytics, FILE *out);
+void freeGameAnalytics(GameAnalytics *analytics);
+
+#endif // ANALYTICS_H
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "game.h"
+#include "montecarlo.h"
+#include "exact.h"
+
+// Analysis of a game: player 2 shoots at player 1's fleet with the chosen
+// strategy, and before every shot the exact probability of a boat on each box
+// is worked out from what player 2 has seen. Each shot is rated against the
+// best one available, and the grids of the requested turns are printed with
+// the true fleet alongside.
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--seed SEED] [--size N | --width W --height H] [--ai STRATEGY]\n"
+                    "          [--show TURN | --show-all] [--mc-samples N]\n"
+                    "Strategies: random, density, montecarlo, exact\n", program);
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Function to print the probabilities in percent next to the true board:
+// '.' for water, 'o' for a miss, 'B' for a boat not hit and 'X' for a hit.
+static void printGrid(const ExactAnalysis *analysis, const GameBoard *board, int shotX, int shotY) {
+    for (int y = 0; y < board->height; y++) {
+        for (int x = 0; x < board->width; x++) {
+            CaseType type = boardCase(board, x, y);
+            double p = analysis->probabilities[y * board->width + x];
+            if (type == WRECK || type == WATER_SHOT) {
+                printf("   %c", type == WRECK ? 'X' : 'o');
+            } else {
+                printf(" %3.0f", 100 * p);
+            }
+            putchar(x == shotX && y == shotY ? '<' : ' ');
+        }
+        printf("   ");
+        for (int x = 0; x < board->width; x++) {
+            static const char symbols[] = { '.', 'o', 'B', 'X' };
+            putchar(symbols[boardCase(board, x, y)]);
+        }
+        putchar('\n');
+    }
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = (uint64_t)time(NULL);
+    GameConfig config = { BOARD_SIZE, BOARD_SIZE, { AI_RANDOM, AI_DENSITY }, NULL, NULL, NULL, NULL };
+    MonteCarloConfig monteCarlo = { 1, MONTE_CARLO_SAMPLES, 0 };
+    const char *strategyName = "density";
+    int show = 0;       // Turn whose grid is printed, 0 for none, -1 for all
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            config.width = config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            config.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ai") == 0 && i + 1 < argc) {
+            strategyName = argv[++i];
+            if (!parseAiStrategy(strategyName, &config.strategies[1])) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--show") == 0 && i + 1 < argc) {
+            show = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--show-all") == 0) {
+            show = -1;
+        } else if (strcmp(argv[i], "--mc-samples") == 0 && i + 1 < argc) {
+            monteCarlo.samples = strtol(argv[++i], NULL, 10);
+        } else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    Arena arena;
+    initializeArena(&arena, 0);
+    ExactAnalysis *analysis = createExactAnalysis(config.width, config.height);
+    config.exact = analysis;
+    if (config.strategies[1] == AI_MONTE_CARLO) {
+        config.monteCarlo = createMonteCarlo(&monteCarlo, config.width, config.height);
+    }
+    Game *game = analysis ? initializeGame(&config, seed, &arena) : NULL;
+    if (game == NULL) {
+        freeMonteCarlo(config.monteCarlo);
+        freeExactAnalysis(analysis);
+        freeArena(&arena);
+        return EXIT_FAILURE;
+    }
+
+    // The analysis reads the player's own targeter, whatever its strategy:
+    // a shadow one keeps the masks when it tracks something else.
+    Targeter shadow;
+    Targeter *seen = &game->player2Targeting;
+    if (seen->strategy != AI_EXACT && seen->strategy != AI_MONTE_CARLO) {
+        seen = &shadow;
+        if (!initializeTargeter(seen, AI_EXACT, config.width, config.height, game->player1Boats, MAX_BOATS, &arena)) {
+            freeMonteCarlo(config.monteCarlo);
+            freeExactAnalysis(analysis);
+            freeArena(&arena);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("Seed %llu, %dx%d board, player 2 plays %s\n", (unsigned long long)seed, config.width, config.height,
+           strategyName);
+    printf("%5s %4s %4s %8s %8s %14s %9s %9s\n", "turn", "x", "y", "p(shot)", "p(best)", "fleets", "states", "ms");
+
+    double lost = 0;    // Hits the shots gave up against the best ones, in expectation
+    double slowest = 0, total = 0;
+    int turn = 0;
+    bool exact = true;
+    while (!isGameOver(&game->player1Board)) {
+        int x, y;
+        turn++;
+        double start = nowSeconds();
+        if (!analyzeExact(analysis, seen)) {
+            fprintf(stderr, "Turn %d is out of reach of the exact analysis.\n", turn);
+            exact = false;
+            break;
+        }
+        double elapsed = nowSeconds() - start;
+        long states = analysis->states;     // Choosing the shot may analyse the position again, from the cache
+        uint64_t configurations = analysis->configurations;
+        total += elapsed;
+        if (elapsed > slowest) slowest = elapsed;
+
+        double best = 0;
+        for (int cell = 0; cell < analysis->cells; cell++) {
+            if (!isAlreadyTargeted(&game->player1Board, cell % config.width, cell / config.width)
+                && analysis->probabilities[cell] > best) {
+                best = analysis->probabilities[cell];
+            }
+        }
+
+        chooseComputerShot(&game->player1Board, &game->player2Targeting, &game->rng, &x, &y);
+        double p = analysis->probabilities[y * config.width + x];
+        lost += best - p;
+        printf("%5d %4d %4d %8.4f %8.4f %14llu %9ld %9.3f\n", turn, x, y, p, best,
+               (unsigned long long)configurations, states, 1000 * elapsed);
+        if (show == -1 || show == turn) printGrid(analysis, &game->player1Board, x, y);
+
+        ShotResult result = shootAt(&game->player1Board, x, y);
+        observeShot(&game->player2Targeting, x, y, result);
+        if (seen == &shadow) observeShot(seen, x, y, result);
+        if (result == SHOT_SUNK) {
+            const Boat *boat = boatAt(&game->player1Board, x, y);
+            observeSunk(&game->player2Targeting, boat);
+            if (seen == &shadow) observeSunk(seen, boat);
+        }
+    }
+
+    if (exact) {
+        printf("Sunk in %d shots, %.3f hits lost to the best shots in expectation\n", turn, lost);
+        printf("Analysis: %.3f ms per turn on average, %.3f ms at worst\n", 1000 * total / turn, 1000 * slowest);
+    }
+    freeMonteCarlo(config.monteCarlo);
+    freeExactAnalysis(analysis);
+    freeArena(&arena);
+    return exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    size_t size;            // Usable bytes after the header
+    size_t used;
+    _Alignas(ARENA_ALIGNMENT) unsigned char data[];
+};
+
+static size_t alignUp(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static ArenaBlock *newBlock(size_t size) {
+    ArenaBlock *block = (ArenaBlock*)aligned_alloc(ARENA_ALIGNMENT, sizeof(ArenaBlock) + size);
+    if (block == NULL) {
+        fprintf(stderr, "Memory allocation failed for arena.\n");
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+void initializeArena(Arena *arena, size_t blockSize) {
+    memset(arena, 0, sizeof(Arena));
+    arena->blockSize = alignUp(blockSize > 0 ? blockSize : ARENA_BLOCK_SIZE);
+}
+
+// Returns `size` bytes aligned on a cache line, or NULL when memory runs out.
+void *arenaAlloc(Arena *arena, size_t size) {
+    size = alignUp(size > 0 ? size : 1);
+
+    ArenaBlock *block = arena->blocks;
+    if (block == NULL || block->size - block->used < size) {
+        // The new block goes in front; the full one stays allocated until reset.
+        block = newBlock(size > arena->blockSize ? size : arena->blockSize);
+        if (block == NULL) return NULL;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    void *memory = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    return memory;
+}
+
+// Same as arenaAlloc, with the memory set to zero.
+void *arenaCalloc(Arena *arena, size_t count, size_t size) {
+    void *memory = arenaAlloc(arena, count * size);
+    if (memory) memset(memory, 0, count * size);
+    return memory;
+}
+
+void resetArena(Arena *arena) {
+    ArenaBlock *block = arena->blocks;
+    if (block == NULL) return;
+
+    if (block->next != NULL) {
+        // Several blocks were needed: trade them for one that holds it all.
+        size_t needed = arena->used > arena->blockSize ? alignUp(arena->used) : arena->blockSize;
+        freeArena(arena);
+        arena->blockSize = needed;
+        arena->blocks = newBlock(needed); // On failure the next allocation retries
+        return;
+    }
+    block->used = 0;
+    arena->used = 0;
+}
+
+void freeArena(Arena *arena) {
+    if (arena) {
+        ArenaBlock *block = arena->blocks;
+        while (block) {
+            ArenaBlock *next = block->next;
+            free(block);
+            block = next;
+        }
+        arena->blocks = NULL;
+        arena->used = 0;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 64          // Every allocation starts on a cache line
+#define ARENA_BLOCK_SIZE (64 * 1024) // Default size of the first block
+
+// Bump allocator for objects that all die together, such as everything a game
+// owns. Allocations are carved out of a block and never freed one by one;
+// resetArena hands the whole memory back at once. When a block is full another
+// one is chained; on the next reset the chain is replaced by a single block
+// large enough for everything, so an arena reused for similar work settles into
+// one block and then resets in O(1) without calling malloc again.
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock *blocks;     // Block being filled first, older full blocks after it
+    size_t blockSize;       // Size of the next block to allocate
+    size_t used;            // Bytes handed out since the last reset, padding included
+} Arena;
+
+void initializeArena(Arena *arena, size_t blockSize);
+void *arenaAlloc(Arena *arena, size_t size);
+void *arenaCalloc(Arena *arena, size_t count, size_t size);
+void resetArena(Arena *arena);
+void freeArena(Arena *arena);
+
+#endif // ARENA_H
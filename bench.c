@@ -0,0 +1,598 @@
+// Benchmark suite of the engine's hot paths, printed as JSON on stdout.
+// Every fixture comes from a fixed seed and a fixed board size, so two builds
+// can be compared run against run. Allocations are counted by wrapping the
+// allocator at link time (see the bench rule of the Makefile).
+//
+// Usage: bench [--filter TEXT] [--min-time SECONDS]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "game.h"
+#include "placement.h"
+#include "renderer.h"
+#include "simulation.h"
+#include "environment.h"
+#include "command.h"
+#include "snapshot.h"
+#include "lanes.h"
+
+#define FIXTURES 64         // Boards or games prepared for each batch
+#define PROBES 256          // Boats tested by canPlaceBoat on each board
+#define ENVIRONMENT_GAMES 4096  // Games of the environment batch
+#define ENVIRONMENT_STEPS 16    // Steps of the batch per run
+#define OPENING_SHOTS 20        // Shots of each player before a game is forked or saved
+#define FORKS 16                // Forks of each game per run
+#define LANE_GAMES 1024         // Games shot at together, one by one or in lanes
+
+// Allocator calls made by the code under measurement.
+static long allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *memory, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *memory, size_t size) {
+    allocations++;
+    return __real_realloc(memory, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size) {
+    allocations++;
+    return __real_aligned_alloc(alignment, size);
+}
+
+// State shared by the benchmarks, rebuilt by their setup before each batch.
+typedef struct {
+    int width;
+    int height;
+    Arena arena;
+    Arena forkArena;        // Where the games are forked
+    Rng rng;
+    GameBoard boards[FIXTURES];
+    PlacementIndex indexes[FIXTURES];
+    Boat fleets[FIXTURES][MAX_BOATS];
+    Boat probes[PROBES];
+    Game *games[FIXTURES];
+    int *cellOrder;         // Every cell once, in a random order
+    uint8_t *snapshots;     // One per game
+    GameBoard *laneBoards;  // LANE_GAMES boards, then the same fleets in lanes
+    Boat *laneFleets;       // MAX_BOATS per board
+    GameLanes *lanes;
+    int *laneCells;         // Per game, the cell of the current shot
+    uint8_t *laneResults;
+    uint8_t *laneOver;
+    FleetPlacer placer;
+    Renderer renderer;
+    Environment *environment;
+    int *actions;           // Per game of the environment, then its shots so far
+    int *shotsTaken;
+    uint64_t *observations;
+    float *rewards;
+    uint8_t *dones;
+    long batch;             // Batches run so far, to vary the seeds
+} Bench;
+
+typedef struct {
+    const char *name;
+    int width;
+    int height;
+    void (*setup)(Bench *bench);    // Not timed
+    long (*run)(Bench *bench);      // Timed, returns the operations done
+} BenchCase;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static GameConfig benchConfig(const Bench *bench, AiStrategy strategy) {
+    GameConfig config = { bench->width, bench->height, { strategy, strategy }, NULL, NULL, NULL, NULL };
+    return config;
+}
+
+static void setupEmptyBoards(Bench *bench) {
+    resetArena(&bench->arena);
+    seedRng(&bench->rng, streamSeed(1, bench->batch));
+    for (int i = 0; i < FIXTURES; i++) {
+        initializeGameBoard(&bench->boards[i], bench->width, bench->height, &bench->arena);
+    }
+    initializeFleetPlacer(&bench->placer, bench->width, bench->height, MAX_BOATS, MAX_BOAT_SIZE, &bench->arena);
+}
+
+// Boards holding a random fleet, plus random probes for canPlaceBoat.
+static void setupFleets(Bench *bench) {
+    setupEmptyBoards(bench);
+    for (int i = 0; i < FIXTURES; i++) {
+        for (int b = 0; b < MAX_BOATS; b++) {
+            bench->fleets[i][b] = createBoat(MIN_BOAT_SIZE + (int)randomBelow(&bench->rng, MAX_BOAT_SIZE - MIN_BOAT_SIZE + 1),
+                                             0, 0, HORIZONTAL);
+        }
+        placeFleet(&bench->placer, &bench->boards[i], bench->fleets[i], MAX_BOATS, &bench->rng);
+    }
+    for (int i = 0; i < PROBES; i++) {
+        bench->probes[i] = createBoat(3, randomBelow(&bench->rng, bench->width), randomBelow(&bench->rng, bench->height),
+                                      randomBelow(&bench->rng, 2) ? VERTICAL : HORIZONTAL);
+    }
+
+    // Fisher-Yates shuffle of the cells, the order of the shots.
+    int cells = bench->width * bench->height;
+    for (int i = 0; i < cells; i++) bench->cellOrder[i] = i;
+    for (int i = cells - 1; i > 0; i--) {
+        int j = (int)randomBelow(&bench->rng, i + 1);
+        int cell = bench->cellOrder[i];
+        bench->cellOrder[i] = bench->cellOrder[j];
+        bench->cellOrder[j] = cell;
+    }
+}
+
+// Same boards, with their legal placements indexed.
+static void setupIndexedBoards(Bench *bench) {
+    setupEmptyBoards(bench);
+    for (int i = 0; i < FIXTURES; i++) {
+        attachPlacementIndex(&bench->indexes[i], &bench->boards[i], MAX_BOAT_SIZE, &bench->arena);
+    }
+}
+
+static void setupIndexedFleets(Bench *bench) {
+    setupFleets(bench);
+    for (int i = 0; i < FIXTURES; i++) {
+        attachPlacementIndex(&bench->indexes[i], &bench->boards[i], MAX_BOAT_SIZE, &bench->arena);
+    }
+}
+
+static void setupGames(Bench *bench, AiStrategy strategy) {
+    GameConfig config = benchConfig(bench, strategy);
+
+    resetArena(&bench->arena);
+    for (int i = 0; i < FIXTURES; i++) {
+        bench->games[i] = initializeGame(&config, streamSeed(2, bench->batch * FIXTURES + i), &bench->arena);
+    }
+}
+
+static void setupDensityGames(Bench *bench) {
+    setupGames(bench, AI_DENSITY);
+}
+
+static void setupRandomGames(Bench *bench) {
+    setupGames(bench, AI_RANDOM);
+}
+
+// Games some shots in, and their snapshots.
+static void setupPlayedGames(Bench *bench) {
+    size_t size = gameSnapshotSize(bench->width, bench->height);
+    int x, y;
+
+    setupGames(bench, AI_DENSITY);
+    bench->snapshots = (uint8_t*)realloc(bench->snapshots, FIXTURES * size);
+    if (bench->snapshots == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < FIXTURES; i++) {
+        Game *game = bench->games[i];
+        for (int s = 0; s < OPENING_SHOTS; s++) {
+            computerShoot(&game->player2Board, &game->player1Targeting, &game->rng, &x, &y);
+            computerShoot(&game->player1Board, &game->player2Targeting, &game->rng, &x, &y);
+        }
+        saveGameSnapshot(game, bench->snapshots + i * size, size);
+    }
+    resetArena(&bench->forkArena);
+}
+
+// The same LANE_GAMES fleets on boards of their own and in lanes, for the
+// kernels called `name`.
+static void setupLanes(Bench *bench, const char *name) {
+    setupFleets(bench);
+    freeGameLanes(bench->lanes);
+    bench->lanes = createGameLanes(LANE_GAMES, bench->width, bench->height, findLaneKernels(name));
+    bench->laneBoards = (GameBoard*)arenaAlloc(&bench->arena, LANE_GAMES * sizeof(GameBoard));
+    bench->laneFleets = (Boat*)arenaAlloc(&bench->arena, LANE_GAMES * MAX_BOATS * sizeof(Boat));
+    bench->laneCells = (int*)realloc(bench->laneCells, LANE_GAMES * sizeof(int));
+    bench->laneResults = (uint8_t*)realloc(bench->laneResults, LANE_GAMES);
+    bench->laneOver = (uint8_t*)realloc(bench->laneOver, LANE_GAMES);
+    if (!bench->lanes || !bench->laneBoards || !bench->laneFleets || !bench->laneCells || !bench->laneResults
+        || !bench->laneOver) {
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < LANE_GAMES; i++) {
+        Boat *fleet = bench->laneFleets + i * MAX_BOATS;
+        for (int b = 0; b < MAX_BOATS; b++) {
+            fleet[b] = createBoat(MIN_BOAT_SIZE + (int)randomBelow(&bench->rng, MAX_BOAT_SIZE - MIN_BOAT_SIZE + 1),
+                                  0, 0, HORIZONTAL);
+        }
+        initializeGameBoard(&bench->laneBoards[i], bench->width, bench->height, &bench->arena);
+        placeFleet(&bench->placer, &bench->laneBoards[i], fleet, MAX_BOATS, &bench->rng);
+        setLaneFleet(bench->lanes, i, fleet, MAX_BOATS);
+    }
+}
+
+static void setupLanesScalar(Bench *bench) {
+    setupLanes(bench, "scalar");
+}
+
+static void setupLanesAvx2(Bench *bench) {
+    setupLanes(bench, "avx2");
+}
+
+static void setupLanesAvx512(Bench *bench) {
+    setupLanes(bench, "avx512");
+}
+
+// A batch of games whose policy shoots the cells in the order of cellOrder.
+static void setupEnvironment(Bench *bench, int threads) {
+    EnvironmentConfig config = { ENVIRONMENT_GAMES, threads, bench->width, bench->height, streamSeed(5, bench->batch),
+                                 0, 0.0f, 1.0f, 1.0f, -1.0f };
+
+    setupFleets(bench);
+    freeEnvironment(bench->environment);
+    bench->environment = createEnvironment(&config);
+    if (bench->environment == NULL) exit(EXIT_FAILURE);
+    int words = environmentObservationWords(bench->environment);
+    bench->actions = (int*)realloc(bench->actions, ENVIRONMENT_GAMES * sizeof(int));
+    bench->shotsTaken = (int*)realloc(bench->shotsTaken, ENVIRONMENT_GAMES * sizeof(int));
+    bench->observations = (uint64_t*)realloc(bench->observations, ENVIRONMENT_GAMES * words * sizeof(uint64_t));
+    bench->rewards = (float*)realloc(bench->rewards, ENVIRONMENT_GAMES * sizeof(float));
+    bench->dones = (uint8_t*)realloc(bench->dones, ENVIRONMENT_GAMES);
+    if (!bench->actions || !bench->shotsTaken || !bench->observations || !bench->rewards || !bench->dones) {
+        exit(EXIT_FAILURE);
+    }
+    memset(bench->shotsTaken, 0, ENVIRONMENT_GAMES * sizeof(int));
+}
+
+static void setupEnvironmentOneThread(Bench *bench) {
+    setupEnvironment(bench, 1);
+}
+
+static void setupEnvironmentAllThreads(Bench *bench) {
+    setupEnvironment(bench, (int)sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+static void setupNothing(Bench *bench) {
+    (void)bench;
+}
+
+static long runCanPlaceBoat(Bench *bench) {
+    long legal = 0;
+    for (int i = 0; i < FIXTURES; i++) {
+        for (int p = 0; p < PROBES; p++) legal += canPlaceBoat(&bench->boards[i], &bench->probes[p]);
+    }
+    bench->batch += legal < 0; // Keeps the calls alive
+    return (long)FIXTURES * PROBES;
+}
+
+static long runPlaceRandomBoat(Bench *bench) {
+    for (int i = 0; i < FIXTURES; i++) {
+        bench->fleets[i][0] = createBoat(3, 0, 0, HORIZONTAL);
+        placeRandomBoat(&bench->boards[i], &bench->fleets[i][0], &bench->rng);
+    }
+    return FIXTURES;
+}
+
+// Takes the first boat of every fleet off its board and puts it back elsewhere.
+static long runMoveBoat(Bench *bench) {
+    for (int i = 0; i < FIXTURES; i++) {
+        removeBoatFromBoard(&bench->boards[i], &bench->fleets[i][0]);
+        placeRandomBoat(&bench->boards[i], &bench->fleets[i][0], &bench->rng);
+    }
+    return FIXTURES;
+}
+
+static long runPlaceFleet(Bench *bench) {
+    for (int i = 0; i < FIXTURES; i++) {
+        for (int b = 0; b < MAX_BOATS; b++) bench->fleets[i][b] = createBoat(MIN_BOAT_SIZE + b % 3, 0, 0, HORIZONTAL);
+        placeFleet(&bench->placer, &bench->boards[i], bench->fleets[i], MAX_BOATS, &bench->rng);
+    }
+    return FIXTURES;
+}
+
+static long runShootAt(Bench *bench) {
+    int cells = bench->width * bench->height;
+    for (int i = 0; i < FIXTURES; i++) {
+        for (int c = 0; c < cells; c++) {
+            int cell = bench->cellOrder[c];
+            shootAt(&bench->boards[i], cell % bench->width, cell / bench->width);
+        }
+    }
+    return (long)FIXTURES * cells;
+}
+
+static long runIsGameOver(Bench *bench) {
+    long over = 0;
+    for (int r = 0; r < 1000; r++) {
+        for (int i = 0; i < FIXTURES; i++) over += isGameOver(&bench->boards[i]);
+    }
+    bench->batch += over < 0;
+    return 1000L * FIXTURES;
+}
+
+// Player 1 of every game shoots until player 2's fleet is sunk.
+static long runComputerShoot(Bench *bench) {
+    long shots = 0;
+    int x, y;
+    for (int i = 0; i < FIXTURES; i++) {
+        Game *game = bench->games[i];
+        while (!isGameOver(&game->player2Board)) {
+            computerShoot(&game->player2Board, &game->player1Targeting, &game->rng, &x, &y);
+            shots++;
+        }
+    }
+    return shots;
+}
+
+static long runRenderFrame(Bench *bench) {
+    Game *game = bench->games[0];
+    for (int i = 0; i < FIXTURES; i++) {
+        renderFrame(&bench->renderer, &game->player1Board, &game->player2Board, true);
+    }
+    return FIXTURES;
+}
+
+static long runInitializeGame(Bench *bench) {
+    GameConfig config = benchConfig(bench, AI_DENSITY);
+    for (int i = 0; i < FIXTURES; i++) {
+        resetArena(&bench->arena);
+        initializeGame(&config, streamSeed(3, bench->batch * FIXTURES + i), &bench->arena);
+    }
+    return FIXTURES;
+}
+
+static long runGames(Bench *bench, AiStrategy strategy) {
+    GameConfig config = benchConfig(bench, strategy);
+    SimulatedGame result;
+    for (int i = 0; i < FIXTURES; i++) {
+        resetArena(&bench->arena);
+        Game *game = initializeGame(&config, streamSeed(4, bench->batch * FIXTURES + i), &bench->arena);
+        playSimulatedGame(game, &result, NULL);
+    }
+    return FIXTURES;
+}
+
+static long runDensityGames(Bench *bench) {
+    return runGames(bench, AI_DENSITY);
+}
+
+static long runRandomGames(Bench *bench) {
+    return runGames(bench, AI_RANDOM);
+}
+
+// A mix of the lines a player types, valid or not.
+static long runParseCommand(Bench *bench) {
+    static const char *const lines[] = { "B7", "  j10 ", "3 7", "AA1", "save game.bsrc", "undo", "quit", "z99", "hello" };
+    char line[COMMAND_LINE_MAX];
+    Command command;
+    long shots = 0;
+
+    for (int i = 0; i < 1000; i++) {
+        strcpy(line, lines[i % (sizeof(lines) / sizeof(lines[0]))]);
+        parseCommand(line, bench->width, bench->height, &command);
+        shots += command.type == COMMAND_SHOT;
+    }
+    bench->batch += shots < 0; // Keeps the calls alive
+    return 1000;
+}
+
+static long runForkGame(Bench *bench) {
+    resetArena(&bench->forkArena);
+    for (int i = 0; i < FIXTURES; i++) {
+        for (int f = 0; f < FORKS; f++) forkGame(bench->games[i], &bench->forkArena);
+    }
+    return (long)FIXTURES * FORKS;
+}
+
+// The fork then plays a shot, so that it copies the board and the targeter.
+static long runForkGameShot(Bench *bench) {
+    int x, y;
+    resetArena(&bench->forkArena);
+    for (int i = 0; i < FIXTURES; i++) {
+        for (int f = 0; f < FORKS; f++) {
+            Game *fork = forkGame(bench->games[i], &bench->forkArena);
+            computerShoot(&fork->player2Board, &fork->player1Targeting, &fork->rng, &x, &y);
+        }
+    }
+    return (long)FIXTURES * FORKS;
+}
+
+static long runSaveGameSnapshot(Bench *bench) {
+    size_t size = gameSnapshotSize(bench->width, bench->height);
+    for (int r = 0; r < FORKS; r++) {
+        for (int i = 0; i < FIXTURES; i++) saveGameSnapshot(bench->games[i], bench->snapshots + i * size, size);
+    }
+    return (long)FIXTURES * FORKS;
+}
+
+// Every game is brought back to the snapshot of the next one.
+static long runRestoreGameSnapshot(Bench *bench) {
+    size_t size = gameSnapshotSize(bench->width, bench->height);
+    for (int i = 0; i < FIXTURES; i++) {
+        restoreGameSnapshot(bench->games[i], bench->snapshots + (i + 1) % FIXTURES * size, size);
+    }
+    return FIXTURES;
+}
+
+// Every game takes a shot at each cell, in the shuffled order from its own
+// starting point, and checks whether it is over: one game at a time here,
+// all of them at once in runShootLanes. Every operation is one shot.
+static long runShootAtGames(Bench *bench) {
+    int cells = bench->width * bench->height;
+    long over = 0;
+    for (int step = 0; step < cells; step++) {
+        for (int i = 0, at = step; i < LANE_GAMES; i++, at = at + 1 == cells ? 0 : at + 1) {
+            int cell = bench->cellOrder[at];
+            shootAt(&bench->laneBoards[i], cell % bench->width, cell / bench->width);
+            over += isGameOver(&bench->laneBoards[i]);
+        }
+    }
+    bench->batch += over < 0;
+    return (long)LANE_GAMES * cells;
+}
+
+static long runShootLanes(Bench *bench) {
+    int cells = bench->width * bench->height;
+    long over = 0;
+    for (int step = 0; step < cells; step++) {
+        for (int i = 0, at = step; i < LANE_GAMES; i++, at = at + 1 == cells ? 0 : at + 1) {
+            bench->laneCells[i] = bench->cellOrder[at];
+        }
+        shootLanes(bench->lanes, bench->laneCells, bench->laneResults);
+        over += lanesGameOver(bench->lanes, bench->laneOver);
+    }
+    bench->batch += over < 0;
+    return (long)LANE_GAMES * cells;
+}
+
+// Every operation is the step of one game.
+static long runStepEnvironment(Bench *bench) {
+    int cells = bench->width * bench->height;
+    for (int step = 0; step < ENVIRONMENT_STEPS; step++) {
+        for (int i = 0; i < ENVIRONMENT_GAMES; i++) bench->actions[i] = bench->cellOrder[bench->shotsTaken[i]];
+        stepEnvironment(bench->environment, bench->actions, bench->observations, bench->rewards, bench->dones);
+        for (int i = 0; i < ENVIRONMENT_GAMES; i++) {
+            bench->shotsTaken[i] = bench->dones[i] ? 0 : (bench->shotsTaken[i] + 1) % cells;
+        }
+    }
+    return (long)ENVIRONMENT_GAMES * ENVIRONMENT_STEPS;
+}
+
+static const BenchCase cases[] = {
+    { "canPlaceBoat", 10, 10, setupFleets, runCanPlaceBoat },
+    { "canPlaceBoat", 16, 16, setupFleets, runCanPlaceBoat },
+    { "canPlaceBoat", 100, 100, setupFleets, runCanPlaceBoat },
+    { "canPlaceBoat/indexed", 10, 10, setupIndexedFleets, runCanPlaceBoat },
+    { "canPlaceBoat/indexed", 100, 100, setupIndexedFleets, runCanPlaceBoat },
+    { "placeRandomBoat", 10, 10, setupEmptyBoards, runPlaceRandomBoat },
+    { "placeRandomBoat", 100, 100, setupEmptyBoards, runPlaceRandomBoat },
+    { "placeRandomBoat/indexed", 10, 10, setupIndexedBoards, runPlaceRandomBoat },
+    { "placeRandomBoat/indexed", 100, 100, setupIndexedBoards, runPlaceRandomBoat },
+    { "moveBoat/indexed", 10, 10, setupIndexedFleets, runMoveBoat },
+    { "moveBoat/indexed", 100, 100, setupIndexedFleets, runMoveBoat },
+    { "placeFleet", 10, 10, setupEmptyBoards, runPlaceFleet },
+    { "placeFleet", 16, 16, setupEmptyBoards, runPlaceFleet },
+    { "placeFleet", 100, 100, setupEmptyBoards, runPlaceFleet },
+    { "shootAt", 10, 10, setupFleets, runShootAt },
+    { "shootAt", 100, 100, setupFleets, runShootAt },
+    { "isGameOver", 10, 10, setupFleets, runIsGameOver },
+    { "computerShoot/random", 10, 10, setupRandomGames, runComputerShoot },
+    { "computerShoot/density", 10, 10, setupDensityGames, runComputerShoot },
+    { "computerShoot/density", 30, 30, setupDensityGames, runComputerShoot },
+    { "renderFrame/plain", 10, 10, setupDensityGames, runRenderFrame },
+    { "renderFrame/plain", 30, 30, setupDensityGames, runRenderFrame },
+    { "initializeGame", 10, 10, setupNothing, runInitializeGame },
+    { "game/random", 10, 10, setupNothing, runRandomGames },
+    { "game/density", 10, 10, setupNothing, runDensityGames },
+    { "game/density", 30, 30, setupNothing, runDensityGames },
+    { "parseCommand", 10, 10, setupNothing, runParseCommand },
+    { "forkGame", 10, 10, setupPlayedGames, runForkGame },
+    { "forkGame", 100, 100, setupPlayedGames, runForkGame },
+    { "forkGame+shot", 10, 10, setupPlayedGames, runForkGameShot },
+    { "forkGame+shot", 100, 100, setupPlayedGames, runForkGameShot },
+    { "saveGameSnapshot", 10, 10, setupPlayedGames, runSaveGameSnapshot },
+    { "restoreGameSnapshot", 10, 10, setupPlayedGames, runRestoreGameSnapshot },
+    { "shootAt/games", 10, 10, setupLanesScalar, runShootAtGames },
+    { "shootAt/games", 16, 16, setupLanesScalar, runShootAtGames },
+    { "shootLanes/scalar", 10, 10, setupLanesScalar, runShootLanes },
+    { "shootLanes/scalar", 16, 16, setupLanesScalar, runShootLanes },
+    { "shootLanes/avx2", 10, 10, setupLanesAvx2, runShootLanes },
+    { "shootLanes/avx2", 16, 16, setupLanesAvx2, runShootLanes },
+    { "shootLanes/avx512", 10, 10, setupLanesAvx512, runShootLanes },
+    { "shootLanes/avx512", 16, 16, setupLanesAvx512, runShootLanes },
+    { "stepEnvironment", 10, 10, setupEnvironmentOneThread, runStepEnvironment },
+    { "stepEnvironment/threads", 10, 10, setupEnvironmentAllThreads, runStepEnvironment },
+};
+
+// Runs batches of a case until `minTime` seconds were spent in run().
+static void measure(Bench *bench, const BenchCase *c, double minTime, bool first) {
+    double seconds = 0;
+    long ops = 0, allocated = 0, batches = 0;
+
+    bench->width = c->width;
+    bench->height = c->height;
+    bench->batch = 0;
+    bench->cellOrder = (int*)realloc(bench->cellOrder, c->width * c->height * sizeof(int));
+
+    // One untimed batch first, so that the arena has grown to its working size.
+    c->setup(bench);
+    c->run(bench);
+    while (seconds < minTime) {
+        bench->batch++;
+        c->setup(bench);
+        long before = allocations;
+        double start = nowSeconds();
+        ops += c->run(bench);
+        seconds += nowSeconds() - start;
+        allocated += allocations - before;
+        batches++;
+    }
+
+    printf("%s\n    {\"name\": \"%s\", \"board\": \"%dx%d\", \"ops\": %ld, \"batches\": %ld, "
+           "\"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"allocations_per_op\": %.4f}",
+           first ? "" : ",", c->name, c->width, c->height, ops, batches,
+           seconds * 1e9 / ops, ops / seconds, (double)allocated / ops);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    const char *filter = NULL;
+    double minTime = 0.3;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minTime = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--filter TEXT] [--min-time SECONDS]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static Bench bench;
+    initializeArena(&bench.arena, 0);
+    initializeArena(&bench.forkArena, 0);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (devNull < 0 || !initializeRenderer(&bench.renderer, RENDER_PLAIN, 1, devNull)) {
+        fprintf(stderr, "Cannot set up the renderer benchmark.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("{\n  \"suite\": \"battleship\",\n  \"min_time\": %.3f,\n  \"benchmarks\": [", minTime);
+    bool first = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (filter && strstr(cases[i].name, filter) == NULL) continue;
+        // Kernels this processor cannot run are left out.
+        if (strncmp(cases[i].name, "shootLanes/", 11) == 0 && findLaneKernels(cases[i].name + 11) == NULL) continue;
+        measure(&bench, &cases[i], minTime, first);
+        first = false;
+    }
+    printf("\n  ]\n}\n");
+
+    freeRenderer(&bench.renderer);
+    close(devNull);
+    freeArena(&bench.arena);
+    freeArena(&bench.forkArena);
+    free(bench.snapshots);
+    freeGameLanes(bench.lanes);
+    free(bench.laneCells);
+    free(bench.laneResults);
+    free(bench.laneOver);
+    free(bench.cellOrder);
+    freeEnvironment(bench.environment);
+    free(bench.actions);
+    free(bench.shotsTaken);
+    free(bench.observations);
+    free(bench.rewards);
+    free(bench.dones);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+// Microbenchmark comparing a scan of the byte cells with the bitboard masks.
+// Build: make, then run build/release/bench_board
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include "gameboard.h"
+#include "boat.h"
+#include "bitboard.h"
+
+#define FIXTURES 64         // Number of random boards measured in turn
+#define ROUNDS 20000        // Number of passes over the fixtures
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Reference implementations walking the cells, as the game did before the masks.
+static bool cellsCanPlaceBoat(GameBoard *board, Boat *boat) {
+    if (boat->orientation == HORIZONTAL) {
+        if (boat->x + boat->size > board->width) return false;
+    } else {
+        if (boat->y + boat->size > board->height) return false;
+    }
+
+    for (int i = 0; i < boat->size; i++) {
+        int x = boat->x + (boat->orientation == HORIZONTAL ? i : 0);
+        int y = boat->y + (boat->orientation == VERTICAL ? i : 0);
+
+        if (boardCase(board, x, y) != WATER) return false;
+
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                int nx = x + dx, ny = y + dy;
+                if (isOnBoard(board, nx, ny)) {
+                    if (boardCase(board, nx, ny) != WATER) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool cellsIsAlreadyTargeted(GameBoard *board, int x, int y) {
+    CaseType state = boardCase(board, x, y);
+    return state == WATER_SHOT || state == WRECK;
+}
+
+static bool cellsIsGameOver(GameBoard *board) {
+    for (int i = 0; i < board->cellCount; i++) {
+        if ((board->cells[i] & CELL_STATE_MASK) == BOAT) return false;
+    }
+    return true;
+}
+
+static void report(const char *name, double cellTime, double maskTime, long ops) {
+    printf("%-18s cells %8.2f ns/op   bitboard %8.2f ns/op   x%.1f\n",
+           name, cellTime * 1e9 / ops, maskTime * 1e9 / ops, cellTime / maskTime);
+}
+
+int main(void) {
+    static GameBoard boards[FIXTURES];
+    static Boat fleets[FIXTURES][MAX_BOATS];   // Boats stay registered on their board
+    static Boat probes[FIXTURES];
+    volatile long sink = 0;
+
+    // Fixed seed so both backends see the same boards from one run to the next.
+    Rng rng;
+    Arena arena;
+    seedRng(&rng, 42);
+    initializeArena(&arena, 0);
+    for (int i = 0; i < FIXTURES; i++) {
+        initializeGameBoard(&boards[i], BOARD_SIZE, BOARD_SIZE, &arena);
+        for (int b = 0; b < MAX_BOATS; b++) {
+            fleets[i][b] = createBoat(randomBelow(&rng, 3) + 2, 0, 0, HORIZONTAL);
+            placeRandomBoat(&boards[i], &fleets[i][b], &rng);
+        }
+        // Sink every boat but leave the last cell alive, the worst case for isGameOver.
+        for (int y = 0; y < BOARD_SIZE; y++) {
+            for (int x = 0; x < BOARD_SIZE; x++) {
+                if (boardCase(&boards[i], x, y) == BOAT && !(y == BOARD_SIZE - 1 && x == BOARD_SIZE - 1)) {
+                    shootAt(&boards[i], x, y);
+                }
+            }
+        }
+        probes[i] = (Boat){ 3, randomBelow(&rng, BOARD_SIZE), randomBelow(&rng, BOARD_SIZE),
+                            randomBelow(&rng, 2) ? VERTICAL : HORIZONTAL, 0 };
+    }
+
+    long ops = (long)FIXTURES * ROUNDS;
+    double start, cellTime, maskTime;
+
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < FIXTURES; i++) sink += cellsIsGameOver(&boards[i]);
+    cellTime = nowSeconds() - start;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < FIXTURES; i++) sink += isGameOver(&boards[i]);
+    maskTime = nowSeconds() - start;
+    report("isGameOver", cellTime, maskTime, ops);
+
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < FIXTURES; i++) sink += cellsCanPlaceBoat(&boards[i], &probes[i]);
+    cellTime = nowSeconds() - start;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < FIXTURES; i++) sink += canPlaceBoat(&boards[i], &probes[i]);
+    maskTime = nowSeconds() - start;
+    report("canPlaceBoat", cellTime, maskTime, ops);
+
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < FIXTURES; i++) sink += cellsIsAlreadyTargeted(&boards[i], r % BOARD_SIZE, i % BOARD_SIZE);
+    cellTime = nowSeconds() - start;
+    start = nowSeconds();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < FIXTURES; i++) sink += isAlreadyTargeted(&boards[i], r % BOARD_SIZE, i % BOARD_SIZE);
+    maskTime = nowSeconds() - start;
+    report("isAlreadyTargeted", cellTime, maskTime, ops);
+
+    freeArena(&arena);
+    return sink == -1;
+}
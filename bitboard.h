@@ -0,0 +1,77 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Helpers on bit masks where cell (x, y) of a board is bit y * size + x.
+// A 10x10 board fits in two 64-bit words.
+
+static inline int bitboardWords(int cells) {
+    return (cells + 63) / 64;
+}
+
+static inline bool bitTest(const uint64_t *mask, int bit) {
+    return (mask[bit >> 6] >> (bit & 63)) & 1;
+}
+
+static inline void bitSet(uint64_t *mask, int bit) {
+    mask[bit >> 6] |= (uint64_t)1 << (bit & 63);
+}
+
+static inline void bitClear(uint64_t *mask, int bit) {
+    mask[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+}
+
+// Mask of the bits [from, from + count) that fall in one word, count in 1..64.
+static inline uint64_t bitSpan(int from, int count) {
+    uint64_t bits = count >= 64 ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1);
+    return bits << from;
+}
+
+// Returns true if any bit in [from, from + count) is set.
+static inline bool bitRangeAny(const uint64_t *mask, int from, int count) {
+    while (count > 0) {
+        int offset = from & 63;
+        int take = 64 - offset < count ? 64 - offset : count;
+        if (mask[from >> 6] & bitSpan(offset, take)) return true;
+        from += take;
+        count -= take;
+    }
+    return false;
+}
+
+// Sets every bit in [from, from + count).
+static inline void bitRangeSet(uint64_t *mask, int from, int count) {
+    while (count > 0) {
+        int offset = from & 63;
+        int take = 64 - offset < count ? 64 - offset : count;
+        mask[from >> 6] |= bitSpan(offset, take);
+        from += take;
+        count -= take;
+    }
+}
+
+// dst &= ~(mask >> shift), over `words` words. Bits shifted in from past the
+// end read as clear.
+static inline void bitAndNotShifted(uint64_t *dst, const uint64_t *mask, int words, int shift) {
+    int skip = shift >> 6;
+    int offset = shift & 63;
+
+    for (int i = 0; i < words; i++) {
+        uint64_t low = i + skip < words ? mask[i + skip] : 0;
+        uint64_t high = i + skip + 1 < words ? mask[i + skip + 1] : 0;
+        uint64_t shifted = offset ? (low >> offset) | (high << (64 - offset)) : low;
+        dst[i] &= ~shifted;
+    }
+}
+
+static inline int bitCount(const uint64_t *mask, int words) {
+    int count = 0;
+    for (int i = 0; i < words; i++) {
+        count += __builtin_popcountll(mask[i]);
+    }
+    return count;
+}
+
+#endif // BITBOARD_H
@@ -1,23 +1,16 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include "boat.h"
+#include "bitboard.h"
+#include "kernels.h"
+#include "placement.h"
 
 
-Boat *createBoat(int size, int x, int y, Orientation orientation) {
-    // Allocate memory for a new Boat.
-    Boat *newBoat = (Boat*)malloc(sizeof(Boat));
-    if (newBoat == NULL) {
-        fprintf(stderr, "Memory allocation failed for new boat.\n");
-        return NULL;
-    }
-
-    // Initialize the boat's properties.
-    newBoat->size = size;
-    newBoat->x = x;
-    newBoat->y = y;
-    newBoat->orientation = orientation;
-
-    return newBoat; // Return the pointer to the new boat.
+// Boats are small values: they are returned by copy and live in their fleet array.
+Boat createBoat(int size, int x, int y, Orientation orientation) {
+    Boat newBoat = { size, x, y, orientation, 0 }; // Not hit yet
+    return newBoat;
 }
 
 // Function to check if a boat is still alive
@@ -33,60 +26,123 @@ bool isBoatAlive(Boat *boat) {
 
 bool canPlaceBoat(GameBoard *board, Boat *boat) {
     // Check if the boat leaves the board
+    if (boat->x < 0 || boat->y < 0) return false;
     if (boat->orientation == HORIZONTAL) {
-        if (boat->x + boat->size > board->size) return false;
+        if (boat->x + boat->size > board->width) return false;
+        if (boat->y >= board->height) return false;
     } else { // VERTICAL
-        if (boat->y + boat->size > board->size) return false;
+        if (boat->y + boat->size > board->height) return false;
+        if (boat->x >= board->width) return false;
     }
 
-    // Check if the boat touches or overlaps another boat
-    for (int i = 0; i < boat->size; i++) {
-        int x = boat->x + (boat->orientation == HORIZONTAL ? i : 0);
-        int y = boat->y + (boat->orientation == VERTICAL ? i : 0);
-
-        // Check the actual case
-        if (board->grid[y][x] != WATER) return false;
-
-        // Check the boxes around to avoid touching another boat.
-        for (int dx = -1; dx <= 1; dx++) {
-            for (int dy = -1; dy <= 1; dy++) {
-                int nx = x + dx, ny = y + dy;
-                if (nx >= 0 && nx < board->size && ny >= 0 && ny < board->size) {
-                    if (board->grid[ny][nx] != WATER) return false;
-                }
-            }
-        }
+    // The boat and the boxes around it must only hold untargeted water.
+    if (board->placements && boat->size <= board->placements->maxLength) {
+        return isPlacementLegal(board->placements, boat->size, boat->orientation, boat->x, boat->y);
     }
-    return true;
+    return board->kernels->isClearAround(board->boats, board->shots, board->width, board->height, boat->x, boat->y,
+                                         boat->orientation == HORIZONTAL ? boat->size : 1,
+                                         boat->orientation == VERTICAL ? boat->size : 1);
 }
 
-void setBoatOnBoard(GameBoard *board, Boat *boat) {
+// Function to put a boat on the board and register it, so that shots on its
+// cells are counted on the boat. The boat must stay valid as long as the board.
+bool setBoatOnBoard(GameBoard *board, Boat *boat) {
+    if (board->fleetSize == MAX_FLEET) {
+        fprintf(stderr, "Too many boats on the board.\n");
+        return false;
+    }
+    if (!ownGameBoard(board)) return false;
+    board->fleet[board->fleetSize++] = boat;
+    uint8_t cell = BOAT | board->fleetSize << CELL_BOAT_SHIFT;
+
     for (int i = 0; i < boat->size; i++) {
         int x = boat->x + (boat->orientation == HORIZONTAL ? i : 0);
         int y = boat->y + (boat->orientation == VERTICAL ? i : 0);
 
-        board->grid[y][x] = BOAT; // Place a part of the boat on the game board
+        board->cells[y * board->width + x] = cell; // Place a part of the boat on the game board
+        bitSet(board->boats, y * board->width + x);
+    }
+    board->remainingCells += boat->size;
+    if (board->placements) {
+        updatePlacementIndex(board->placements, boat->x, boat->y,
+                             boat->orientation == HORIZONTAL ? boat->size : 1,
+                             boat->orientation == VERTICAL ? boat->size : 1, 1);
     }
+    return true;
 }
 
-// Function to place a boat on the game board randomly
+// Function to take a boat off the board, to move it while the fleet is being
+// set up. Only a boat that was not hit can leave: its cells go back to water.
+// The last boat of the fleet takes its slot, so owner indices change.
+bool removeBoatFromBoard(GameBoard *board, Boat *boat) {
+    int slot = 0;
+    while (slot < board->fleetSize && board->fleet[slot] != boat) slot++;
+    if (slot == board->fleetSize) {
+        fprintf(stderr, "The boat is not on the board.\n");
+        return false;
+    }
+    if (boat->hit_count > 0) {
+        fprintf(stderr, "A boat that was hit cannot be removed.\n");
+        return false;
+    }
+    if (!ownGameBoard(board)) return false;
 
-bool placeRandomBoat(GameBoard *board, Boat *boat) {
-    if (!board || !boat) return false; // Check if pointer no-NULL.
+    for (int i = 0; i < boat->size; i++) {
+        int cell = (boat->y + (boat->orientation == VERTICAL ? i : 0)) * board->width
+                 + boat->x + (boat->orientation == HORIZONTAL ? i : 0);
+        board->cells[cell] = WATER;
+        bitClear(board->boats, cell);
+    }
+    board->remainingCells -= boat->size;
+
+    // Move the last boat to the freed slot and renumber its cells.
+    Boat *last = board->fleet[--board->fleetSize];
+    if (last != boat) {
+        board->fleet[slot] = last;
+        for (int i = 0; i < last->size; i++) {
+            int cell = (last->y + (last->orientation == VERTICAL ? i : 0)) * board->width
+                     + last->x + (last->orientation == HORIZONTAL ? i : 0);
+            board->cells[cell] = (board->cells[cell] & CELL_STATE_MASK) | (slot + 1) << CELL_BOAT_SHIFT;
+        }
+    }
+    if (board->placements) {
+        updatePlacementIndex(board->placements, boat->x, boat->y,
+                             boat->orientation == HORIZONTAL ? boat->size : 1,
+                             boat->orientation == VERTICAL ? boat->size : 1, -1);
+    }
+    return true;
+}
 
-    // Set a maximum number of attempts to avoid an infinite loop if placement is not possible.
-    int maxTries = 100;
-    for (int tries = 0; tries < maxTries; tries++) {
-        // Generate random position and orientation
-        boat->x = rand() % board->size;
-        boat->y = rand() % board->size;
-        boat->orientation = (rand() % 2 == 0) ? HORIZONTAL : VERTICAL;
+// Function to place a boat on the game board randomly.
+// Every legal position is counted and one of them is kept with a uniform
+// probability, so the placement only fails when the boat fits nowhere.
+bool placeRandomBoat(GameBoard *board, Boat *boat, Rng *rng) {
+    if (!board || !boat || !rng) return false; // Check if pointer no-NULL.
+
+    // With an index, the legal positions are already counted: draw one of them.
+    if (board->placements && boat->size <= board->placements->maxLength) {
+        int legal = countLegalPlacements(board->placements, boat->size);
+        if (legal == 0) return false;
+        findLegalPlacement(board->placements, boat->size, (int)randomBelow(rng, legal), boat);
+        return setBoatOnBoard(board, boat);
+    }
 
-        // Check if the boat can be placed
-        if (canPlaceBoat(board, boat)) {
-            setBoatOnBoard(board, boat); // Place the boat
-            return true; // Success
+    Boat candidate = *boat;
+    uint32_t legal = 0;
+    for (int o = 0; o < 2; o++) {
+        candidate.orientation = o == 0 ? HORIZONTAL : VERTICAL;
+        for (candidate.y = 0; candidate.y < board->height; candidate.y++) {
+            for (candidate.x = 0; candidate.x < board->width; candidate.x++) {
+                // Reservoir sampling: the n-th legal position replaces the pick with probability 1/n.
+                if (canPlaceBoat(board, &candidate) && randomBelow(rng, ++legal) == 0) {
+                    boat->x = candidate.x;
+                    boat->y = candidate.y;
+                    boat->orientation = candidate.orientation;
+                }
+            }
         }
     }
-    return false; // Fail after the maxTries
-  }
+    if (legal == 0) return false;
+
+    return setBoatOnBoard(board, boat); // Place the boat
+}
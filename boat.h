@@ -1,19 +1,31 @@
 #ifndef BOAT_H
 #define BOAT_H
 
+#include <stdbool.h>
 #include "gameboard.h"
+#include "rng.h"
 
-typedef struct {
+#define MAX_BOATS 5       // Define the maximum number of boats for a player
+#define MIN_BOAT_SIZE 2   // Shortest boat of a random fleet
+#define MAX_BOAT_SIZE 4   // Longest boat of a random fleet
+
+typedef enum {
+    HORIZONTAL, // Indicates the boat is placed horizontally.
+    VERTICAL,   // Indicates the boat is placed vertically.
+} Orientation;
+
+struct Boat {
     int size;
     int x, y;
     Orientation orientation;
-    int hit_count;
-} Boat;
+    int hit_count;      // Cells of the boat hit so far, counted by shootAt
+};
 
-Boat *createBoat(int size, int x, int y, Orientation orientation);
+Boat createBoat(int size, int x, int y, Orientation orientation);
 bool isBoatAlive(Boat *boat);
 bool canPlaceBoat(GameBoard *board, Boat *boat);
-void setBoatOnBoard(GameBoard *board, Boat *boat);
-bool placeRandomBoat(GameBoard *board, Boat *boat);
+bool setBoatOnBoard(GameBoard *board, Boat *boat);
+bool removeBoatFromBoard(GameBoard *board, Boat *boat);
+bool placeRandomBoat(GameBoard *board, Boat *boat, Rng *rng);
 
 #endif // BOAT_H
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "book.h"
+#include "byteorder.h"
+
+bool openOpeningBook(OpeningBook *book, const char *path) {
+    struct stat status;
+
+    memset(book, 0, sizeof(OpeningBook));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &status) < 0) {
+        fprintf(stderr, "Cannot open opening book %s.\n", path);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    if ((size_t)status.st_size < BOOK_HEADER_SIZE) {
+        fprintf(stderr, "%s is not an opening book.\n", path);
+        close(fd);
+        return false;
+    }
+
+    // The mapping outlives the descriptor. Lookups land anywhere in the file.
+    void *data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    madvise(data, status.st_size, MADV_RANDOM);
+    book->data = (const uint8_t*)data;
+    book->size = status.st_size;
+
+    const uint8_t *header = book->data;
+    book->width = readLe16(header + 8);
+    book->height = readLe16(header + 10);
+    book->strategy = (AiStrategy)header[12];
+    book->slots = readLe32(header + 16);
+    book->positions = readLe32(header + 20);
+    size_t headerSize = readLe16(header + 6);
+    if (memcmp(header, BOOK_MAGIC, 4) != 0 || readLe16(header + 4) != BOOK_VERSION
+        || book->slots == 0 || (book->slots & (book->slots - 1)) != 0 || book->positions > book->slots / 2
+        || headerSize < BOOK_HEADER_SIZE || headerSize + (size_t)book->slots * BOOK_SLOT_SIZE != book->size) {
+        fprintf(stderr, "%s is not an opening book of version %d.\n", path, BOOK_VERSION);
+        closeOpeningBook(book);
+        return false;
+    }
+    book->table = book->data + headerSize;
+    return true;
+}
+
+void closeOpeningBook(OpeningBook *book) {
+    if (book && book->data) {
+        munmap((void*)book->data, book->size);
+        book->data = NULL;
+    }
+}
+
+// Function to find the shot of the position of key `key`. Returns false when
+// the book does not hold it. The probe stops after a lap of the table, in case
+// the file has no free slot left despite its header.
+bool lookupOpeningBook(const OpeningBook *book, uint64_t key, int *cell) {
+    uint32_t slot = (uint32_t)key & (book->slots - 1);
+    for (uint32_t probe = 0; probe < book->slots; probe++) {
+        const uint8_t *in = book->table + (size_t)slot * BOOK_SLOT_SIZE;
+        uint32_t shot = readLe32(in + 8);
+        if (shot == BOOK_EMPTY) return false;
+        if (readLe64(in) == key) {
+            *cell = (int)shot;
+            return true;
+        }
+        slot = (slot + 1) & (book->slots - 1);
+    }
+    return false;
+}
+
+// Function to write the book of `count` positions to `path`. A position met
+// twice keeps its first shot.
+bool writeOpeningBook(const char *path, int width, int height, AiStrategy strategy,
+                      const uint64_t *keys, const int *cells, long count) {
+    uint32_t slots = 1;
+    while (slots < 2 * (uint64_t)count) slots *= 2;
+    size_t size = BOOK_HEADER_SIZE + (size_t)slots * BOOK_SLOT_SIZE;
+    uint8_t *out = (uint8_t*)calloc(size, 1);
+    if (out == NULL) {
+        fprintf(stderr, "Memory allocation failed for opening book.\n");
+        return false;
+    }
+
+    uint8_t *table = out + BOOK_HEADER_SIZE;
+    for (uint32_t slot = 0; slot < slots; slot++) putLe32(table + (size_t)slot * BOOK_SLOT_SIZE + 8, BOOK_EMPTY);
+    uint32_t positions = 0;
+    for (long i = 0; i < count; i++) {
+        uint32_t slot = (uint32_t)keys[i] & (slots - 1);
+        while (readLe32(table + (size_t)slot * BOOK_SLOT_SIZE + 8) != BOOK_EMPTY
+               && readLe64(table + (size_t)slot * BOOK_SLOT_SIZE) != keys[i]) {
+            slot = (slot + 1) & (slots - 1);
+        }
+        uint8_t *entry = table + (size_t)slot * BOOK_SLOT_SIZE;
+        if (readLe32(entry + 8) != BOOK_EMPTY) continue;
+        putLe64(entry, keys[i]);
+        putLe32(entry + 8, (uint32_t)cells[i]);
+        positions++;
+    }
+
+    memcpy(out, BOOK_MAGIC, 4);
+    putLe16(out + 4, BOOK_VERSION);
+    putLe16(out + 6, BOOK_HEADER_SIZE);
+    putLe16(out + 8, (uint16_t)width);
+    putLe16(out + 10, (uint16_t)height);
+    out[12] = (uint8_t)strategy;
+    putLe32(out + 16, slots);
+    putLe32(out + 20, positions);
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file != NULL && fwrite(out, 1, size, file) == size;
+    if (file != NULL && fclose(file) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Cannot write opening book %s.\n", path);
+    free(out);
+    return ok;
+}
@@ -0,0 +1,46 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "targeting.h"
+
+// Opening books: the shot a strategy chooses in the early positions of a game,
+// computed offline by battleship-book and read through a mapping of the file.
+// Every integer is little-endian.
+//
+// Header, 32 bytes:
+//   "BSOB", u16 version, u16 header size, u16 width, u16 height,
+//   u8 strategy, 3 reserved bytes, u32 slots (a power of two), u32 positions,
+//   8 reserved bytes
+// Then the slots of an open addressing table, 16 bytes each:
+//   u64 Zobrist key of the position (see zobrist.h)
+//   u32 cell y * width + x of the shot, BOOK_EMPTY for a free slot
+//   4 reserved bytes
+// A position lives in the first free slot from its key modulo the slots, and
+// the table is at most half full, so a lookup reads one or two slots.
+#define BOOK_MAGIC "BSOB"
+#define BOOK_VERSION 1
+#define BOOK_HEADER_SIZE 32
+#define BOOK_SLOT_SIZE 16
+#define BOOK_EMPTY UINT32_MAX
+
+struct OpeningBook {
+    const uint8_t *data;    // The mapped file
+    size_t size;
+    const uint8_t *table;   // Its first slot
+    int width;
+    int height;
+    AiStrategy strategy;
+    uint32_t slots;
+    uint32_t positions;
+};
+
+bool openOpeningBook(OpeningBook *book, const char *path);
+void closeOpeningBook(OpeningBook *book);
+bool lookupOpeningBook(const OpeningBook *book, uint64_t key, int *cell);
+bool writeOpeningBook(const char *path, int width, int height, AiStrategy strategy,
+                      const uint64_t *keys, const int *cells, long count);
+
+#endif // BOOK_H
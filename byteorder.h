@@ -0,0 +1,57 @@
+#ifndef BYTEORDER_H
+#define BYTEORDER_H
+
+#include <stdint.h>
+#include "boat.h"
+
+// Little-endian integers of the file formats (record.h, snapshot.h, book.h),
+// and the 4 bytes of a boat that records and snapshots share: x in bits 0-9,
+// y in bits 10-19, vertical in bit 20, size in bits 21-30.
+
+static inline void putLe16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static inline void putLe24(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 3; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static inline void putLe32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static inline void putLe64(uint8_t *out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static inline uint16_t readLe16(const uint8_t *in) {
+    return (uint16_t)(in[0] | in[1] << 8);
+}
+
+static inline uint32_t readLe24(const uint8_t *in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16;
+}
+
+static inline uint32_t readLe32(const uint8_t *in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static inline uint64_t readLe64(const uint8_t *in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = value << 8 | in[i];
+    return value;
+}
+
+static inline uint32_t packBoat(const Boat *boat) {
+    return (uint32_t)boat->x | (uint32_t)boat->y << 10
+        | (uint32_t)(boat->orientation == VERTICAL) << 20 | (uint32_t)boat->size << 21;
+}
+
+// The boat of a packed word, not hit yet.
+static inline Boat unpackBoat(uint32_t packed) {
+    return createBoat((int)(packed >> 21 & 0x3ff), (int)(packed & 0x3ff), (int)(packed >> 10 & 0x3ff),
+                      packed >> 20 & 1 ? VERTICAL : HORIZONTAL);
+}
+
+#endif // BYTEORDER_H
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include "command.h"
+#include "gameboard.h"
+
+void initializeInputReader(InputReader *reader, int fd) {
+    memset(reader, 0, sizeof(InputReader));
+    reader->fd = fd;
+}
+
+// Function to return the next line, without its newline and NUL-terminated
+// in the reader's buffer, where it stays valid until the next call. Waits at
+// most `timeout` milliseconds for input, -1 for no limit.
+InputStatus readInputLine(InputReader *reader, int timeout, char **line) {
+    reader->length -= reader->consumed;
+    memmove(reader->buffer, reader->buffer + reader->consumed, reader->length);
+    reader->consumed = 0;
+
+    for (;;) {
+        char *newline = memchr(reader->buffer, '\n', reader->length);
+        if (newline && reader->skipping) {
+            // The end of an overlong line: drop it and look again.
+            reader->skipping = false;
+            reader->length -= (int)(newline + 1 - reader->buffer);
+            memmove(reader->buffer, newline + 1, reader->length);
+            continue;
+        }
+        bool full = reader->length == (int)sizeof(reader->buffer) - 1;
+        if (newline || (!reader->skipping && (full || (reader->closed && reader->length > 0)))) {
+            // A whole line, the last one, or the start of a line too long for
+            // the buffer, which is returned as is and fails to parse.
+            int end = newline ? (int)(newline - reader->buffer) : reader->length;
+            reader->consumed = newline ? end + 1 : end;
+            reader->skipping = !newline && !reader->closed;
+            if (end > 0 && reader->buffer[end - 1] == '\r') end--;
+            reader->buffer[end] = '\0';
+            *line = reader->buffer;
+            return INPUT_LINE;
+        }
+        if (reader->closed) return INPUT_CLOSED;
+        if (reader->skipping) reader->length = 0;
+
+        struct pollfd wait = { .fd = reader->fd, .events = POLLIN };
+        int ready = poll(&wait, 1, timeout);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            reader->closed = true;
+            continue;
+        }
+        if (ready <= 0) return INPUT_PENDING;
+
+        // The descriptor is readable, so read() returns what is there without waiting.
+        ssize_t received = read(reader->fd, reader->buffer + reader->length,
+                                sizeof(reader->buffer) - 1 - reader->length);
+        if (received < 0) {
+            if (errno == EINTR || errno == EAGAIN) return INPUT_PENDING;
+            perror("read");
+        }
+        if (received <= 0) {
+            reader->closed = true;
+        } else {
+            reader->length += (int)received;
+            timeout = 0;    // Only what already came in from now on
+        }
+    }
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static char lowerCase(char c) {
+    return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+}
+
+// Function to match `keyword` (lower case) at the start of `text`, up to a
+// space or the end. Returns what follows it, or NULL when it does not match.
+static char *matchKeyword(char *text, const char *keyword) {
+    while (*keyword && lowerCase(*text) == *keyword) {
+        text++;
+        keyword++;
+    }
+    if (*keyword || (*text && !isSpace(*text))) return NULL;
+    while (isSpace(*text)) text++;
+    return text;
+}
+
+// Function to read a decimal number, capped above MAX_BOARD_SIDE so that it
+// cannot overflow. Returns what follows it, or NULL when there is no digit.
+static char *readNumber(char *text, int *value) {
+    if (*text < '0' || *text > '9') return NULL;
+    *value = 0;
+    for (; *text >= '0' && *text <= '9'; text++) {
+        if (*value <= MAX_BOARD_SIDE) *value = *value * 10 + (*text - '0');
+    }
+    return text;
+}
+
+// Function to read a column in letters: A to Z, then AA, AB and so on.
+static char *readColumn(char *text, int *x) {
+    int value = 0;
+    if (lowerCase(*text) < 'a' || lowerCase(*text) > 'z') return NULL;
+    for (; lowerCase(*text) >= 'a' && lowerCase(*text) <= 'z'; text++) {
+        if (value <= MAX_BOARD_SIDE) value = value * 26 + (lowerCase(*text) - 'a' + 1);
+    }
+    *x = value - 1;
+    return text;
+}
+
+static void parseShot(char *text, int width, int height, Command *command) {
+    char *end;
+
+    command->type = COMMAND_INVALID;
+    if ((end = readColumn(text, &command->x)) != NULL) {
+        end = readNumber(end, &command->y);
+    } else if ((end = readNumber(text, &command->x)) != NULL && isSpace(*end)) {
+        while (isSpace(*end)) end++;
+        end = readNumber(end, &command->y);
+    } else {
+        end = NULL;
+    }
+    if (end == NULL || *end != '\0') {
+        command->error = "Unknown command, type help for the list.";
+    } else if (command->x >= width || command->y >= height) {
+        command->error = "This shot is off the board.";
+    } else {
+        command->type = COMMAND_SHOT;
+    }
+}
+
+static void bareCommand(Command *command, CommandType type, const char *rest) {
+    command->type = type;
+    if (*rest) {
+        command->type = COMMAND_INVALID;
+        command->error = "This command takes no argument.";
+    }
+}
+
+// Function to parse one line, trailing blanks removed in place.
+void parseCommand(char *line, int width, int height, Command *command) {
+    char *rest;
+    int length = (int)strlen(line);
+
+    memset(command, 0, sizeof(Command));
+    while (length > 0 && isSpace(line[length - 1])) line[--length] = '\0';
+    while (isSpace(*line)) line++;
+
+    if (*line == '\0') {
+        command->type = COMMAND_EMPTY;
+    } else if ((rest = matchKeyword(line, "save")) != NULL) {
+        command->type = COMMAND_SAVE;
+        command->path = *rest ? rest : COMMAND_DEFAULT_SAVE;
+    } else if ((rest = matchKeyword(line, "undo")) != NULL) {
+        bareCommand(command, COMMAND_UNDO, rest);
+    } else if ((rest = matchKeyword(line, "redo")) != NULL) {
+        bareCommand(command, COMMAND_REDO, rest);
+    } else if ((rest = matchKeyword(line, "quit")) != NULL) {
+        bareCommand(command, COMMAND_QUIT, rest);
+    } else if ((rest = matchKeyword(line, "help")) != NULL) {
+        bareCommand(command, COMMAND_HELP, rest);
+    } else {
+        parseShot(line, width, height, command);
+    }
+}
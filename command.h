@@ -0,0 +1,65 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdbool.h>
+
+// Commands of the interactive game, one per line:
+//
+//   B7             shoot at column B, row 7: letters count columns from A for
+//                  0, so B is the column numbered 1 on screen; columns past Z
+//                  go on with AA, AB, ...
+//   3 7            the same shot, as X Y
+//   save [FILE]    write the game so far as a record (COMMAND_DEFAULT_SAVE)
+//   undo           take back the last shot and the computer's reply
+//   redo           play again the shot taken back, and the reply
+//   quit           leave the game
+//   help           list the commands
+//
+// Keywords ignore case. A shot is checked against the board dimensions when
+// the line is parsed, so a command that comes out as COMMAND_SHOT is on the
+// board. Parsing allocates nothing: a save path points into the line.
+#define COMMAND_LINE_MAX 256            // Longest line kept, newline included
+#define COMMAND_DEFAULT_SAVE "battleship.bsrc"
+
+typedef enum {
+    COMMAND_EMPTY,      // Blank line
+    COMMAND_SHOT,
+    COMMAND_SAVE,
+    COMMAND_UNDO,
+    COMMAND_REDO,
+    COMMAND_QUIT,
+    COMMAND_HELP,
+    COMMAND_INVALID,    // See `error`
+} CommandType;
+
+typedef struct {
+    CommandType type;
+    int x, y;               // COMMAND_SHOT
+    const char *path;       // COMMAND_SAVE, NUL-terminated
+    const char *error;      // COMMAND_INVALID, why the line was refused
+} Command;
+
+typedef enum {
+    INPUT_LINE,     // A line was read
+    INPUT_PENDING,  // Nothing complete yet: the wait timed out or was interrupted
+    INPUT_CLOSED,   // End of input, every line was returned
+} InputStatus;
+
+// Reads lines from a file descriptor without blocking past its timeout.
+// Whatever is available is read in one chunk once poll() reports it, so the
+// caller keeps control while the player types. The descriptor itself is left
+// in blocking mode, since stdin usually shares it with the shell.
+typedef struct {
+    int fd;
+    int length;         // Bytes buffered
+    int consumed;       // Bytes of the line returned last, dropped at the next read
+    bool skipping;      // Dropping the rest of a line longer than the buffer
+    bool closed;        // End of file seen
+    char buffer[COMMAND_LINE_MAX];
+} InputReader;
+
+void initializeInputReader(InputReader *reader, int fd);
+InputStatus readInputLine(InputReader *reader, int timeout, char **line);
+void parseCommand(char *line, int width, int height, Command *command);
+
+#endif // COMMAND_H
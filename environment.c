@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "environment.h"
+#include "gameboard.h"
+#include "boat.h"
+#include "bitboard.h"
+#include "placement.h"
+#include "threadpool.h"
+#include "arena.h"
+#include "rng.h"
+
+#define ENVIRONMENT_GRAIN 64    // Games per chunk of a parallel step
+
+// What a thread needs to deal a new fleet: the placer works on a board of its
+// own, rebuilt in the worker's arena for every new game, whose masks are then
+// copied to the game's slots.
+typedef struct {
+    _Alignas(64) Arena arena;
+    bool failed;
+} EnvironmentWorker;
+
+struct Environment {
+    EnvironmentConfig config;
+    int cells;
+    int words;              // Words of a board mask
+    ThreadPool *pool;
+    EnvironmentWorker *workers;
+    Arena arena;            // Every array below, for the lifetime of the batch
+
+    // One entry (or one mask, or one row of MAX_BOATS) per game.
+    uint64_t *boats;        // Boxes holding a boat
+    uint64_t *shots;        // Boxes already targeted
+    uint64_t *sunk;         // Boxes of the boats sunk
+    uint8_t *owners;        // Per box, index of its boat plus one, zero for water
+    uint8_t *sizes;         // Per boat, its length
+    uint8_t *intact;        // Per boat, boxes not hit yet
+    int *firsts;            // Per boat, its first box
+    int *strides;           // Per boat, cells from one box to the next: 1 or width
+    int *remaining;         // Boat boxes not hit yet
+    int *steps;             // Shots taken in the current game
+    Rng *rngs;
+};
+
+typedef struct {
+    Environment *environment;
+    const int *actions;     // NULL to reset every game
+    uint64_t *observations; // NULL when nobody looks
+    float *rewards;
+    uint8_t *dones;
+} EnvironmentJob;
+
+static int randomBoatSize(Rng *rng) {
+    return MIN_BOAT_SIZE + (int)randomBelow(rng, MAX_BOAT_SIZE - MIN_BOAT_SIZE + 1);
+}
+
+// Function to deal a new fleet to `game`, drawn from its own stream.
+static bool resetGame(Environment *environment, EnvironmentWorker *worker, long game) {
+    const EnvironmentConfig *config = &environment->config;
+    int words = environment->words;
+    GameBoard board;
+    FleetPlacer placer;
+    Boat fleet[MAX_BOATS];
+
+    resetArena(&worker->arena);
+    for (int b = 0; b < MAX_BOATS; b++) {
+        fleet[b] = createBoat(randomBoatSize(&environment->rngs[game]), 0, 0, HORIZONTAL);
+    }
+    if (!initializeGameBoard(&board, config->width, config->height, &worker->arena)
+        || !initializeFleetPlacer(&placer, config->width, config->height, MAX_BOATS, MAX_BOAT_SIZE, &worker->arena)
+        || !placeFleet(&placer, &board, fleet, MAX_BOATS, &environment->rngs[game])) {
+        return false;
+    }
+
+    // The board registered the boats in fleet order, so its owner indices are
+    // the ones of the game's boat rows.
+    memcpy(environment->boats + game * words, board.boats, words * sizeof(uint64_t));
+    memset(environment->shots + game * words, 0, words * sizeof(uint64_t));
+    memset(environment->sunk + game * words, 0, words * sizeof(uint64_t));
+    uint8_t *owners = environment->owners + game * environment->cells;
+    for (int cell = 0; cell < environment->cells; cell++) owners[cell] = board.cells[cell] >> CELL_BOAT_SHIFT;
+    for (int b = 0; b < MAX_BOATS; b++) {
+        environment->sizes[game * MAX_BOATS + b] = (uint8_t)fleet[b].size;
+        environment->intact[game * MAX_BOATS + b] = (uint8_t)fleet[b].size;
+        environment->firsts[game * MAX_BOATS + b] = fleet[b].y * config->width + fleet[b].x;
+        environment->strides[game * MAX_BOATS + b] = fleet[b].orientation == HORIZONTAL ? 1 : config->width;
+    }
+    environment->remaining[game] = board.remainingCells;
+    environment->steps[game] = 0;
+    return true;
+}
+
+// Function to take the shot of `action` in `game`. Returns the reward and
+// sets `done` when the game ends.
+static float shootGame(Environment *environment, long game, int action, uint8_t *done) {
+    const EnvironmentConfig *config = &environment->config;
+    uint64_t *shots = environment->shots + game * environment->words;
+    float reward;
+
+    *done = ENVIRONMENT_RUNNING;
+    environment->steps[game]++;
+    if (action < 0 || action >= environment->cells || bitTest(shots, action)) {
+        reward = config->invalidReward;
+    } else {
+        bitSet(shots, action);
+        int owner = environment->owners[game * environment->cells + action];
+        if (owner == 0) {
+            reward = config->missReward;
+        } else {
+            int boat = game * MAX_BOATS + owner - 1;
+            reward = config->hitReward;
+            if (--environment->intact[boat] == 0) {
+                // The boat was hit on each of its boxes: all of them go to the sunk plane.
+                uint64_t *sunk = environment->sunk + game * environment->words;
+                for (int i = 0, cell = environment->firsts[boat]; i < environment->sizes[boat];
+                     i++, cell += environment->strides[boat]) {
+                    bitSet(sunk, cell);
+                }
+                reward = config->sunkReward;
+            }
+            if (--environment->remaining[game] == 0) *done = ENVIRONMENT_SUNK;
+        }
+    }
+    if (*done == ENVIRONMENT_RUNNING && environment->steps[game] >= config->maxSteps) *done = ENVIRONMENT_TRUNCATED;
+    return reward;
+}
+
+// Function to write the planes of `game`: the misses and the hits come from
+// the shots and the boats, one word at a time.
+static void observeGame(const Environment *environment, long game, uint64_t *observation) {
+    int words = environment->words;
+    const uint64_t *boats = environment->boats + game * words;
+    const uint64_t *shots = environment->shots + game * words;
+    const uint64_t *sunk = environment->sunk + game * words;
+
+    for (int i = 0; i < words; i++) {
+        observation[i] = shots[i] & ~boats[i];
+        observation[words + i] = shots[i] & boats[i];
+        observation[2 * words + i] = sunk[i];
+    }
+}
+
+static void stepRange(void *context, int worker, long begin, long end) {
+    EnvironmentJob *job = (EnvironmentJob*)context;
+    Environment *environment = job->environment;
+    EnvironmentWorker *mine = &environment->workers[worker];
+    int planeWords = ENVIRONMENT_PLANES * environment->words;
+
+    for (long game = begin; game < end; game++) {
+        bool reset = true;
+        if (job->actions) {
+            job->rewards[game] = shootGame(environment, game, job->actions[game], &job->dones[game]);
+            reset = job->dones[game] != ENVIRONMENT_RUNNING;
+        }
+        if (reset && !resetGame(environment, mine, game)) mine->failed = true;
+        if (job->observations) observeGame(environment, game, job->observations + game * planeWords);
+    }
+}
+
+// Function to run one job over the whole batch. Returns false when a fleet
+// could not be placed, in which case the game is left as it was.
+static bool runEnvironmentJob(Environment *environment, EnvironmentJob *job) {
+    bool ok = true;
+    runThreadPool(environment->pool, environment->config.games, ENVIRONMENT_GRAIN, stepRange, job);
+    for (int i = 0; i < threadPoolSize(environment->pool); i++) {
+        if (environment->workers[i].failed) ok = false;
+        environment->workers[i].failed = false;
+    }
+    if (!ok) fprintf(stderr, "Failed to place a fleet on a %dx%d board.\n",
+                     environment->config.width, environment->config.height);
+    return ok;
+}
+
+// Function to create a batch of games, each with its first fleet dealt.
+Environment *createEnvironment(const EnvironmentConfig *config) {
+    if (config->games < 1 || config->width < 1 || config->height < 1
+        || config->width > MAX_BOARD_SIDE || config->height > MAX_BOARD_SIDE) {
+        fprintf(stderr, "Invalid environment of %d games on a %dx%d board.\n",
+                config->games, config->width, config->height);
+        return NULL;
+    }
+    Environment *environment = (Environment*)calloc(1, sizeof(Environment));
+    if (environment == NULL) {
+        fprintf(stderr, "Memory allocation failed for environment.\n");
+        return NULL;
+    }
+    environment->config = *config;
+    environment->cells = config->width * config->height;
+    environment->words = bitboardWords(environment->cells);
+    if (environment->config.maxSteps <= 0) environment->config.maxSteps = 2 * environment->cells;
+    initializeArena(&environment->arena, 0);
+    environment->pool = createThreadPool(config->threads);
+    if (environment->pool == NULL) {
+        free(environment);
+        return NULL;
+    }
+
+    int threads = threadPoolSize(environment->pool);
+    size_t games = config->games;
+    size_t masks = games * environment->words * sizeof(uint64_t);
+    environment->workers = (EnvironmentWorker*)aligned_alloc(64, threads * sizeof(EnvironmentWorker));
+    environment->boats = (uint64_t*)arenaAlloc(&environment->arena, masks);
+    environment->shots = (uint64_t*)arenaAlloc(&environment->arena, masks);
+    environment->sunk = (uint64_t*)arenaAlloc(&environment->arena, masks);
+    environment->owners = (uint8_t*)arenaAlloc(&environment->arena, games * environment->cells);
+    environment->sizes = (uint8_t*)arenaAlloc(&environment->arena, games * MAX_BOATS);
+    environment->intact = (uint8_t*)arenaAlloc(&environment->arena, games * MAX_BOATS);
+    environment->firsts = (int*)arenaAlloc(&environment->arena, games * MAX_BOATS * sizeof(int));
+    environment->strides = (int*)arenaAlloc(&environment->arena, games * MAX_BOATS * sizeof(int));
+    environment->remaining = (int*)arenaAlloc(&environment->arena, games * sizeof(int));
+    environment->steps = (int*)arenaAlloc(&environment->arena, games * sizeof(int));
+    environment->rngs = (Rng*)arenaAlloc(&environment->arena, games * sizeof(Rng));
+    if (!environment->workers || !environment->boats || !environment->shots || !environment->sunk
+        || !environment->owners || !environment->sizes || !environment->intact
+        || !environment->firsts || !environment->strides
+        || !environment->remaining || !environment->steps || !environment->rngs) {
+        fprintf(stderr, "Memory allocation failed for environment.\n");
+        free(environment->workers);
+        environment->workers = NULL;
+        freeEnvironment(environment);
+        return NULL;
+    }
+    for (int i = 0; i < threads; i++) {
+        initializeArena(&environment->workers[i].arena, 0);
+        environment->workers[i].failed = false;
+    }
+    for (long i = 0; i < config->games; i++) seedRng(&environment->rngs[i], streamSeed(config->seed, i));
+
+    // Deal the first fleets.
+    EnvironmentJob job = { environment, NULL, NULL, NULL, NULL };
+    if (!runEnvironmentJob(environment, &job)) {
+        freeEnvironment(environment);
+        return NULL;
+    }
+    return environment;
+}
+
+void freeEnvironment(Environment *environment) {
+    if (environment) {
+        for (int i = 0; environment->workers && i < threadPoolSize(environment->pool); i++) {
+            freeArena(&environment->workers[i].arena);
+        }
+        free(environment->workers);
+        freeThreadPool(environment->pool);
+        freeArena(&environment->arena);
+        free(environment);
+    }
+}
+
+// Words of the observation of one game.
+int environmentObservationWords(const Environment *environment) {
+    return ENVIRONMENT_PLANES * environment->words;
+}
+
+// Function to deal a new fleet to every game and write their observations.
+bool resetEnvironment(Environment *environment, uint64_t *observations) {
+    EnvironmentJob job = { environment, NULL, observations, NULL, NULL };
+    return runEnvironmentJob(environment, &job);
+}
+
+// Function to take one shot in every game, game i shooting at cell actions[i].
+bool stepEnvironment(Environment *environment, const int *actions, uint64_t *observations,
+                     float *rewards, uint8_t *dones) {
+    EnvironmentJob job = { environment, actions, observations, rewards, dones };
+    return runEnvironmentJob(environment, &job);
+}
@@ -0,0 +1,54 @@
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Batch of independent one-player games for training a policy: every step
+// takes one shot per game and hands back what the shooter sees, the reward of
+// the shot and whether the game ended. A game that ends is replaced at once by
+// a new one, with a fleet drawn from its own random stream, so that the batch
+// always holds `games` games in play.
+//
+// The games are kept as a structure of arrays (the masks of every game one
+// after the other, then the boat of every cell, ...) and a step runs over
+// slices of the batch on every thread. Buffers belong to the caller:
+//   actions       games ints, the cell y * width + x to shoot in each game
+//   observations  games * environmentObservationWords() words: for each game
+//                 ENVIRONMENT_PLANES bit planes of the board, each
+//                 bitboardWords(width * height) words long, cell c at bit c
+//   rewards       games floats
+//   dones         games bytes, an EnvironmentDone
+// The observation of a game that just ended is the first one of its next game.
+
+#define ENVIRONMENT_PLANES 3    // Misses, hits, boxes of sunk boats
+
+typedef enum {
+    ENVIRONMENT_RUNNING,    // The game goes on
+    ENVIRONMENT_SUNK,       // The whole fleet was sunk by this shot
+    ENVIRONMENT_TRUNCATED,  // The game reached maxSteps, its fleet still afloat
+} EnvironmentDone;
+
+typedef struct {
+    int games;          // Games stepped together
+    int threads;        // Worker threads, the calling thread included
+    int width;
+    int height;
+    uint64_t seed;      // Game i draws its fleets from streamSeed(seed, i)
+    int maxSteps;       // Steps after which a game is cut short, 0 for twice the cells
+    float missReward;
+    float hitReward;    // Shot on a boat that stays afloat
+    float sunkReward;   // Shot on the last intact box of a boat
+    float invalidReward;    // Shot off the board or at a box already targeted, which changes nothing
+} EnvironmentConfig;
+
+typedef struct Environment Environment;
+
+Environment *createEnvironment(const EnvironmentConfig *config);
+void freeEnvironment(Environment *environment);
+int environmentObservationWords(const Environment *environment);
+bool resetEnvironment(Environment *environment, uint64_t *observations);
+bool stepEnvironment(Environment *environment, const int *actions, uint64_t *observations,
+                     float *rewards, uint8_t *dones);
+
+#endif // ENVIRONMENT_H
@@ -0,0 +1,638 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "exact.h"
+#include "bitboard.h"
+
+// Column contents in a profile, 3 bits each: water, end of a boat, or a
+// vertical boat with `r` boxes still to come below (1 to 3) and a flag set
+// while all its boxes are hits.
+#define COLUMN_WATER 0
+#define COLUMN_END 1
+#define COLUMN_GROWING(r, allHits) (2 + ((r) - 1) * 2 + (allHits))
+#define GROWING_LEFT(value) (((value) - 2) / 2 + 1)
+#define GROWING_ALL_HITS(value) (((value) - 2) & 1)
+
+#define MAX_SUCCESSORS (2 + 2 * MAX_BOATS)
+
+// The profiles reaching one box, stored densely in the order they were found
+// and looked up through an open addressing table of their indices. Each
+// profile keeps the counts of the sub-fleets left that some prefix reaches it
+// with, in order of sub-fleet, and the links to its successors in the next
+// layer. A layer keeps the profiles of the earlier positions too: those no
+// prefix reaches any more have no counts, and are skipped.
+struct ExactLayer {
+    uint64_t *profiles;
+    uint32_t *reached;      // Per profile: bit f set when some prefix reaches it with sub-fleet f left
+    uint32_t *pending;      // Per profile: the sub-fleets whose completions are still to count
+    uint32_t *first;        // Per profile: index of its first count
+    uint32_t *firstLink;    // Per profile: index of its first link, then one past the last link
+    uint32_t *slots;        // Index of a profile plus one, 0 when free
+    uint32_t capacity;      // Slots, a power of two
+    uint32_t count;         // Profiles
+    uint32_t reserved;      // Profiles that fit before the arrays grow
+    int shift;              // 64 - log2(capacity)
+    uint64_t *forward;      // Per count: prefixes reaching the profile with that sub-fleet left
+    uint64_t *completions;  // Per count: ways to decide the boxes from here on with it
+    uint32_t counts;
+    uint32_t countCapacity;
+    uint32_t *links;        // Per link: index of the successor in the next layer << 3 | boat started + 1
+    uint32_t linkCount;
+    uint32_t linkCapacity;
+};
+
+// Layout of a profile, from the lowest bit: the columns, the horizontal boat
+// being laid (boxes still to lay, all hits flag), then the box up-left.
+// Sub-fleets are numbered in the mixed radix of `radix`, boats of length
+// index l weighing `stride[l]`. MAX_BOATS boats make at most 2^5 sub-fleets,
+// so a set of them fits in 32 bits.
+typedef struct {
+    const Targeter *targeter;
+    int width;
+    int height;
+    int horizontalShift;
+    int upLeftShift;
+    int fleets;             // Sub-fleets, the numbers 0 to fleets - 1
+    int stride[MAX_BOATS];
+    int radix[MAX_BOATS];
+    uint32_t withBoat[MAX_BOATS];   // Sub-fleets holding a boat of length index l
+} Layout;
+
+typedef struct {
+    uint64_t profile;
+    int boat;               // Length index of the boat started on the box, -1 for none
+} Successor;
+
+// A cache entry is its key, the configurations (0 for a free entry, since a
+// position the player reached always has some) and the covering counts.
+static int cacheEntryWords(const ExactAnalysis *analysis) {
+    return analysis->keyWords + 1 + analysis->cells;
+}
+
+// Writes the key of the position `targeter` saw: its masks, then the count
+// of each length left in 4 bits per length. Returns its hash.
+static uint64_t positionKey(const ExactAnalysis *analysis, const Targeter *targeter, uint64_t *key) {
+    int words = bitboardWords(analysis->cells);
+    memcpy(key, targeter->misses, words * sizeof(uint64_t));
+    memcpy(key + words, targeter->openHits, words * sizeof(uint64_t));
+    memcpy(key + 2 * words, targeter->sunkZone, words * sizeof(uint64_t));
+    uint64_t fleet = 0;
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        fleet |= (uint64_t)(targeter->lengths[l] | targeter->boatsOfLength[l] << 4) << (8 * l);
+    }
+    key[3 * words] = fleet;
+
+    uint64_t hash = 0;
+    for (int i = 0; i < analysis->keyWords; i++) hash = (hash ^ key[i]) * 0x9e3779b97f4a7c15u;
+    return hash ^ hash >> 32;
+}
+
+// Function to create the engine of the boards of `width` by `height` boxes
+ExactAnalysis *createExactAnalysis(int width, int height) {
+    if (width > EXACT_MAX_WIDTH) {
+        fprintf(stderr, "The exact analysis handles boards up to %d boxes wide.\n", EXACT_MAX_WIDTH);
+        return NULL;
+    }
+    if (height > EXACT_MAX_HEIGHT) {
+        fprintf(stderr, "The exact analysis handles boards up to %d boxes high.\n", EXACT_MAX_HEIGHT);
+        return NULL;
+    }
+    ExactAnalysis *analysis = (ExactAnalysis*)calloc(1, sizeof(ExactAnalysis));
+    if (analysis == NULL) {
+        fprintf(stderr, "Memory allocation failed for exact analysis.\n");
+        return NULL;
+    }
+    analysis->width = width;
+    analysis->height = height;
+    analysis->cells = width * height;
+    analysis->keyWords = 3 * bitboardWords(analysis->cells) + 1;
+    analysis->layers = (ExactLayer*)calloc(analysis->cells + 1, sizeof(ExactLayer));
+    analysis->held = (uint64_t*)calloc(analysis->keyWords, sizeof(uint64_t));
+    analysis->covering = (uint64_t*)calloc(analysis->cells, sizeof(uint64_t));
+    analysis->probabilities = (double*)calloc(analysis->cells, sizeof(double));
+    analysis->cache = (uint64_t*)calloc((size_t)(EXACT_CACHE_ENTRIES + 1) * cacheEntryWords(analysis),
+                                        sizeof(uint64_t));
+    if (analysis->layers == NULL || analysis->held == NULL || analysis->covering == NULL || analysis->probabilities == NULL
+        || analysis->cache == NULL) {
+        fprintf(stderr, "Memory allocation failed for exact analysis.\n");
+        freeExactAnalysis(analysis);
+        return NULL;
+    }
+    return analysis;
+}
+
+void freeExactAnalysis(ExactAnalysis *analysis) {
+    if (analysis) {
+        for (int cell = 0; analysis->layers && cell <= analysis->cells; cell++) {
+            ExactLayer *layer = &analysis->layers[cell];
+            free(layer->profiles);
+            free(layer->reached);
+            free(layer->pending);
+            free(layer->first);
+            free(layer->firstLink);
+            free(layer->slots);
+            free(layer->forward);
+            free(layer->completions);
+            free(layer->links);
+        }
+        free(analysis->layers);
+        free(analysis->spareForward);
+        free(analysis->spareCompletions);
+        free(analysis->scratch);
+        free(analysis->held);
+        free(analysis->covering);
+        free(analysis->probabilities);
+        free(analysis->cache);
+        free(analysis);
+    }
+}
+
+// The top bits of the product depend on every bit of the profile.
+static uint32_t slotOf(const ExactLayer *layer, uint64_t profile) {
+    return (uint32_t)((profile * 0x9e3779b97f4a7c15u) >> layer->shift);
+}
+
+// Bits set in `bits`, without relying on a popcount instruction.
+static inline int countBits(uint32_t bits) {
+    bits -= (bits >> 1) & 0x55555555u;
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    return (int)((((bits + (bits >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24);
+}
+
+// Returns the capacity, doubled from `capacity`, that holds `needed` items.
+static uint32_t grownCapacity(uint32_t capacity, uint32_t needed) {
+    if (capacity == 0) capacity = 64;
+    while (capacity < needed) capacity *= 2;
+    return capacity;
+}
+
+// Function to reallocate `*array` to `items` items of `size` bytes. Leaves it
+// as it was when the memory is missing.
+static bool resize(void *array, size_t items, size_t size) {
+    void *resized = realloc(*(void**)array, items * size);
+    if (resized == NULL) {
+        fprintf(stderr, "Memory allocation failed for exact analysis.\n");
+        return false;
+    }
+    *(void**)array = resized;
+    return true;
+}
+
+// Function to make room for `needed` counts in the arrays `forward` and
+// `completions` of `capacity` counts.
+static bool reserveCounts(uint64_t **forward, uint64_t **completions, uint32_t *capacity, uint32_t needed) {
+    if (needed <= *capacity) return true;
+    uint32_t grown = grownCapacity(*capacity, needed);
+    if (!resize(forward, grown, sizeof(uint64_t)) || !resize(completions, grown, sizeof(uint64_t))) return false;
+    *capacity = grown;
+    return true;
+}
+
+// Returns the slot holding `profile`, or the free slot where it goes.
+static uint32_t findSlot(const ExactLayer *layer, uint64_t profile) {
+    uint32_t slot = slotOf(layer, profile);
+    while (layer->slots[slot] && layer->profiles[layer->slots[slot] - 1] != profile) {
+        slot = (slot + 1) & (layer->capacity - 1);
+    }
+    return slot;
+}
+
+// Function to double the profiles the layer holds, and index them again.
+static bool growLayer(ExactLayer *layer) {
+    uint32_t reserved = layer->reserved ? 2 * layer->reserved : 16;
+    if (!resize(&layer->profiles, reserved, sizeof(uint64_t))
+        || !resize(&layer->reached, reserved, sizeof(uint32_t))
+        || !resize(&layer->pending, reserved, sizeof(uint32_t))
+        || !resize(&layer->first, reserved, sizeof(uint32_t))
+        || !resize(&layer->firstLink, reserved + 1, sizeof(uint32_t))) {
+        return false;
+    }
+    uint32_t *slots = (uint32_t*)calloc(2 * (size_t)reserved, sizeof(uint32_t));
+    if (slots == NULL) {
+        fprintf(stderr, "Memory allocation failed for exact analysis.\n");
+        return false;
+    }
+    free(layer->slots);
+    layer->slots = slots;
+    layer->reserved = reserved;
+    layer->capacity = 2 * reserved;
+    layer->shift = 64 - __builtin_ctz(layer->capacity);
+    for (uint32_t i = 0; i < layer->count; i++) layer->slots[findSlot(layer, layer->profiles[i])] = i + 1;
+    return true;
+}
+
+// Function to empty the layer, keeping its memory.
+static void clearLayer(ExactLayer *layer) {
+    if (layer->slots) memset(layer->slots, 0, layer->capacity * sizeof(uint32_t));
+    layer->count = 0;
+    layer->counts = 0;
+    layer->linkCount = 0;
+}
+
+// Returns the index of `profile` in the layer, adding it with no counts when
+// new, or -1 when the layer cannot grow.
+static long addProfile(ExactLayer *layer, uint64_t profile) {
+    uint32_t slot = layer->capacity ? findSlot(layer, profile) : 0;
+    if (layer->capacity && layer->slots[slot]) return layer->slots[slot] - 1;
+
+    if (layer->count == layer->reserved) {
+        if (layer->count >= EXACT_MAX_STATES || !growLayer(layer)) return -1;
+        slot = findSlot(layer, profile);
+    }
+    uint32_t index = layer->count++;
+    layer->profiles[index] = profile;
+    layer->reached[index] = 0;
+    layer->pending[index] = 0;
+    layer->first[index] = 0;
+    layer->slots[slot] = index + 1;
+    return index;
+}
+
+static int column(uint64_t profile, int x) {
+    return (int)(profile >> (3 * x)) & 7;
+}
+
+// Lists the ways to decide box `cell` from `profile`. Boats of every length
+// of the fleet may start; the sub-fleets lacking one are dropped by the caller.
+static int successors(const Layout *layout, int cell, uint64_t profile, Successor *next) {
+    const Targeter *targeter = layout->targeter;
+    int width = layout->width;
+    int x = cell % width;
+    int y = cell / width;
+    int up = column(profile, x);                                // Box above, row y - 1
+    int left = x > 0 ? column(profile, x - 1) : COLUMN_WATER;   // Row y
+    int upRight = x + 1 < width ? column(profile, x + 1) : COLUMN_WATER;
+    bool upLeft = (profile >> layout->upLeftShift) & 1;
+    int laying = (int)(profile >> layout->horizontalShift) & 3;
+    int layingAllHits = (int)(profile >> (layout->horizontalShift + 2)) & 1;
+    bool water = bitTest(targeter->misses, cell) || bitTest(targeter->sunkZone, cell);
+    bool hit = bitTest(targeter->openHits, cell);
+    int count = 0;
+
+    // The other columns carry over; the next box's up-left is the box above
+    // this one. It only matters to a boat starting on the next box, so it is
+    // left out when its up or left neighbour already forbids one: profiles
+    // differing only there then merge.
+    uint64_t base = profile & (((uint64_t)1 << layout->horizontalShift) - 1) & ~((uint64_t)7 << (3 * x));
+    bool nextMayStart = x + 1 < width && upRight == COLUMN_WATER;
+    uint64_t upLeftBit = nextMayStart && up != COLUMN_WATER ? (uint64_t)1 << layout->upLeftShift : 0;
+
+#define EMIT(value, lay, layHits, boatIndex)                                                           \
+    do {                                                                                             \
+        if ((lay) == 0 || x + 1 < width) {                                                           \
+            next[count].profile = base | (uint64_t)(value) << (3 * x)                                \
+                | (uint64_t)((lay) | (layHits) << 2) << layout->horizontalShift                      \
+                | ((value) == COLUMN_WATER ? upLeftBit : 0);                                         \
+            next[count++].boat = (boatIndex);                                                        \
+        }                                                                                            \
+    } while (0)
+
+    if (laying > 0) {
+        // The horizontal boat goes on: nothing above or up-right may touch it.
+        if (water || up != COLUMN_WATER || upRight != COLUMN_WATER) return 0;
+        int allHits = layingAllHits && hit;
+        if (laying == 1 && allHits) return 0;   // It would have been announced sunk
+        EMIT(COLUMN_END, laying - 1, laying > 1 ? allHits : 0, -1);
+        return count;
+    }
+
+    if (up >= 2) {
+        // The vertical boat above goes on, with water on its left.
+        if (water || left != COLUMN_WATER) return 0;
+        int remaining = GROWING_LEFT(up) - 1;
+        int allHits = GROWING_ALL_HITS(up) && hit;
+        if (remaining == 0) {
+            if (allHits) return 0;
+            EMIT(COLUMN_END, 0, 0, -1);
+        } else {
+            EMIT(COLUMN_GROWING(remaining, allHits), 0, 0, -1);
+        }
+        return count;
+    }
+
+    if (!hit) EMIT(COLUMN_WATER, 0, 0, -1);
+
+    // A new boat starts here when no box around is taken yet.
+    if (water || up != COLUMN_WATER || left != COLUMN_WATER || upRight != COLUMN_WATER || upLeft) return count;
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        int length = targeter->lengths[l];
+        if (targeter->boatsOfLength[l] == 0) continue;
+        if (length == 1) {
+            if (!hit) EMIT(COLUMN_END, 0, 0, l);
+            continue;
+        }
+        if (x + length <= width) EMIT(COLUMN_END, length - 1, hit, l);
+        if (y + length <= layout->height) EMIT(COLUMN_GROWING(length - 1, hit), 0, 0, l);
+    }
+#undef EMIT
+    return count;
+}
+
+// A complete profile is valid when no vertical boat is left unfinished.
+static bool isComplete(const Layout *layout, uint64_t profile) {
+    for (int x = 0; x < layout->width; x++) {
+        if (column(profile, x) >= 2) return false;
+    }
+    return true;
+}
+
+// Function to follow the profiles of layer `cell` some prefix reaches to the
+// next layer: links them to their successors and adds their prefixes to the
+// scratch rows of those, one count per sub-fleet left.
+static bool expandLayer(ExactAnalysis *analysis, const Layout *layout, int cell) {
+    ExactLayer *layer = &analysis->layers[cell];
+    ExactLayer *following = &analysis->layers[cell + 1];
+    int fleets = layout->fleets;
+    Successor next[MAX_SUCCESSORS];
+    uint32_t links = 0;
+
+    for (uint32_t i = 0; i < layer->count; i++) {
+        layer->firstLink[i] = links;
+        uint32_t reached = layer->reached[i];
+        if (reached == 0) continue;
+        analysis->states++;
+        const uint64_t *prefixes = layer->forward + layer->first[i];
+        int count = successors(layout, cell, layer->profiles[i], next);
+        for (int s = 0; s < count; s++) {
+            int l = next[s].boat;
+            uint32_t moved = l < 0 ? reached : reached & layout->withBoat[l];
+            if (moved == 0) continue;
+            long j = addProfile(following, next[s].profile);
+            if (j < 0) return false;
+            if ((size_t)following->count * fleets > analysis->scratchWords) {
+                // The new rows start empty, like the rows gathered. Rows are
+                // as wide as the sub-fleets, which change with the fleet.
+                size_t words = (size_t)following->reserved * fleets;
+                if (!resize(&analysis->scratch, words, sizeof(uint64_t))) return false;
+                memset(analysis->scratch + analysis->scratchWords, 0,
+                       (words - analysis->scratchWords) * sizeof(uint64_t));
+                analysis->scratchWords = words;
+            }
+            if (links == layer->linkCapacity) {
+                uint32_t grown = grownCapacity(layer->linkCapacity, links + 1);
+                if (!resize(&layer->links, grown, sizeof(uint32_t))) return false;
+                layer->linkCapacity = grown;
+            }
+            layer->links[links++] = (uint32_t)j << 3 | (uint32_t)(l + 1);
+
+            // Starting a boat of length index l takes it from the sub-fleet.
+            uint64_t *row = analysis->scratch + (size_t)j * fleets;
+            int placed = l < 0 ? 0 : layout->stride[l];
+            uint32_t k = 0;
+            for (uint32_t bits = reached; bits; bits &= bits - 1, k++) {
+                int f = __builtin_ctz(bits);
+                if (moved >> f & 1) row[f - placed] += prefixes[k];
+            }
+        }
+    }
+    layer->firstLink[layer->count] = links;
+    layer->linkCount = links;
+    return true;
+}
+
+// Function to take the prefixes of the layer out of the scratch rows, which
+// it leaves empty. The completions of the sub-fleets a profile was already
+// reached with are kept; the others are pending. The counts are written to
+// the spare arrays, then copied back.
+static bool gatherLayer(ExactAnalysis *analysis, const Layout *layout, ExactLayer *layer) {
+    int fleets = layout->fleets;
+    uint32_t counts = 0;
+
+    for (uint32_t i = 0; i < layer->count; i++) {
+        if (counts + fleets > analysis->spareCapacity
+            && !reserveCounts(&analysis->spareForward, &analysis->spareCompletions, &analysis->spareCapacity,
+                              counts + fleets)) {
+            return false;
+        }
+        uint64_t *row = analysis->scratch + (size_t)i * fleets;
+        uint32_t before = layer->reached[i];
+        uint32_t k = layer->first[i];
+        uint32_t reached = 0;
+        layer->first[i] = counts;
+        for (int f = 0; f < fleets; f++) {
+            bool known = before >> f & 1;
+            if (row[f]) {
+                analysis->spareForward[counts] = row[f];
+                analysis->spareCompletions[counts++] = known ? layer->completions[k] : 0;
+                reached |= (uint32_t)1 << f;
+                row[f] = 0;
+            }
+            k += known;
+        }
+        layer->reached[i] = reached;
+        layer->pending[i] = reached & ~before;
+    }
+
+    if (!reserveCounts(&layer->forward, &layer->completions, &layer->countCapacity, counts)) return false;
+    memcpy(layer->forward, analysis->spareForward, counts * sizeof(uint64_t));
+    memcpy(layer->completions, analysis->spareCompletions, counts * sizeof(uint64_t));
+    layer->counts = counts;
+    return true;
+}
+
+// Function to count the completions of the sub-fleets `todo` of profile `i`
+// of layer `cell`, from those of its successors.
+static void completeProfile(ExactAnalysis *analysis, const Layout *layout, int cell, uint32_t i, uint32_t todo) {
+    ExactLayer *layer = &analysis->layers[cell];
+    uint64_t *completions = layer->completions + layer->first[i];
+    uint32_t reached = layer->reached[i];
+    uint32_t k = 0;
+
+    analysis->states++;
+    if (cell == analysis->cells) {
+        // Every boat must have been placed: only the empty sub-fleet completes.
+        for (uint32_t bits = reached; bits; bits &= bits - 1, k++) {
+            completions[k] = __builtin_ctz(bits) == 0 && isComplete(layout, layer->profiles[i]);
+        }
+        return;
+    }
+    const ExactLayer *following = &analysis->layers[cell + 1];
+    for (uint32_t bits = reached; bits; bits &= bits - 1, k++) {
+        int f = __builtin_ctz(bits);
+        if (!(todo >> f & 1)) continue;
+        uint64_t ways = 0;
+        for (uint32_t e = layer->firstLink[i]; e < layer->firstLink[i + 1]; e++) {
+            uint32_t j = layer->links[e] >> 3;
+            int l = (int)(layer->links[e] & 7) - 1;
+            int g = f;
+            if (l >= 0) {
+                if (!(layout->withBoat[l] >> f & 1)) continue;
+                g -= layout->stride[l];
+            }
+            // The successor is reached with g left, since this profile is with f.
+            uint32_t lower = following->reached[j] & (((uint32_t)1 << g) - 1);
+            ways += following->completions[following->first[j] + countBits(lower)];
+        }
+        completions[k] = ways;
+    }
+}
+
+// Function that brings the layers to the position `key` describes, from the
+// sub-fleet `fleet`, and fills the covering counts and the configurations of
+// `analysis`. When the layers hold an earlier position with the same boats
+// left, whose shots are all still there, only the boxes shot since are
+// counted again: the prefixes of the layers up to the first of them and the
+// completions of the layers after the last one still hold. Anything else
+// starts over.
+static bool countFleets(ExactAnalysis *analysis, const Layout *layout, int fleet, const uint64_t *key) {
+    int cells = analysis->cells;
+    int words = bitboardWords(cells);
+    int first = cells, last = -1;   // Boxes shot since
+
+    if (analysis->holding && key[3 * words] == analysis->held[3 * words]) {
+        for (int w = 0; w < words && first >= 0; w++) {
+            uint64_t shot = 0;
+            for (int m = 0; m < 3; m++) {
+                uint64_t held = analysis->held[m * words + w];
+                if (held & ~key[m * words + w]) first = -1;
+                shot |= key[m * words + w] & ~held;
+            }
+            if (shot == 0 || first < 0) continue;
+            if (first == cells) first = w * 64 + __builtin_ctzll(shot);
+            last = w * 64 + 63 - __builtin_clzll(shot);
+        }
+    }
+
+    // The layers are only whole again once both passes are through.
+    analysis->holding = false;
+    analysis->states = 0;
+    if (first < 0 || last < 0) {
+        // Nothing to start from, or the covering was not kept: count it all.
+        for (int cell = 0; cell <= cells; cell++) clearLayer(&analysis->layers[cell]);
+        ExactLayer *start = &analysis->layers[0];
+        if (addProfile(start, 0) < 0
+            || !reserveCounts(&start->forward, &start->completions, &start->countCapacity, 1)) {
+            return false;
+        }
+        start->reached[0] = start->pending[0] = (uint32_t)1 << fleet;
+        start->forward[0] = 1;
+        start->counts = 1;
+        first = 0;
+        last = cells - 1;
+    }
+
+    // Forward: prefixes reaching the layers after `first`.
+    for (int cell = first; cell < cells; cell++) {
+        if (!expandLayer(analysis, layout, cell) || !gatherLayer(analysis, layout, &analysis->layers[cell + 1])) {
+            return false;
+        }
+    }
+
+    // Backward: completions up to `last` and those pending after it. A box
+    // is covered by the fleets through the profiles of the next layer whose
+    // column holds a boat on it.
+    for (int cell = cells; cell >= 0; cell--) {
+        ExactLayer *layer = &analysis->layers[cell];
+        int x = (cell + analysis->width - 1) % analysis->width;
+        uint64_t covering = 0;
+        analysis->configurations = 0;
+        for (uint32_t i = 0; i < layer->count; i++) {
+            uint32_t todo = cell <= last ? layer->reached[i] : layer->pending[i];
+            if (todo) completeProfile(analysis, layout, cell, i, todo);
+            layer->pending[i] = 0;
+
+            const uint64_t *forward = layer->forward + layer->first[i];
+            const uint64_t *completions = layer->completions + layer->first[i];
+            uint64_t through = 0;
+            for (int k = countBits(layer->reached[i]) - 1; k >= 0; k--) through += forward[k] * completions[k];
+            analysis->configurations += through;
+            if (column(layer->profiles[i], x) != COLUMN_WATER) covering += through;
+        }
+        if (cell > 0) analysis->covering[cell - 1] = covering;
+    }
+
+    memcpy(analysis->held, key, analysis->keyWords * sizeof(uint64_t));
+    analysis->holding = true;
+    return true;
+}
+
+// Function to count the fleets agreeing with what `targeter` saw, and the
+// probability of a boat on every box. Returns false when the board or the
+// fleet is out of reach of the method, or when a layer grows too large.
+bool analyzeExact(ExactAnalysis *analysis, const Targeter *targeter) {
+    Layout layout;
+    int cells = analysis->cells;
+
+    if (targeter->misses == NULL || targeter->width != analysis->width || targeter->height != analysis->height) {
+        return false;
+    }
+    memset(&layout, 0, sizeof(Layout));
+    layout.targeter = targeter;
+    layout.width = analysis->width;
+    layout.height = analysis->height;
+    layout.horizontalShift = 3 * analysis->width;
+    layout.upLeftShift = layout.horizontalShift + 3;
+
+    int fleet = 0;  // The sub-fleet still to find
+    layout.fleets = 1;
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        if (targeter->lengths[l] > MAX_BOAT_SIZE) return false;
+        layout.stride[l] = layout.fleets;
+        layout.radix[l] = targeter->boatsOfLength[l] + 1;
+        fleet += layout.fleets * targeter->boatsOfLength[l];
+        layout.fleets *= layout.radix[l];
+    }
+    for (int f = 0; f < layout.fleets; f++) {
+        for (int l = 0; l < targeter->lengthCount; l++) {
+            if (f / layout.stride[l] % layout.radix[l]) layout.withBoat[l] |= (uint32_t)1 << f;
+        }
+    }
+
+    // The entry after the last one holds the key being looked up.
+    int words = cacheEntryWords(analysis);
+    uint64_t *key = analysis->cache + (size_t)EXACT_CACHE_ENTRIES * words;
+    uint64_t *entry = analysis->cache + (positionKey(analysis, targeter, key) % EXACT_CACHE_ENTRIES) * words;
+    uint64_t *configurations = entry + analysis->keyWords;
+    if (*configurations && memcmp(entry, key, analysis->keyWords * sizeof(uint64_t)) == 0) {
+        analysis->configurations = *configurations;
+        memcpy(analysis->covering, configurations + 1, cells * sizeof(uint64_t));
+        analysis->states = 0;
+        analysis->cacheHits++;
+    } else if (!countFleets(analysis, &layout, fleet, key)) {
+        return false;
+    } else if (analysis->configurations) {
+        memcpy(entry, key, analysis->keyWords * sizeof(uint64_t));
+        *configurations = analysis->configurations;
+        memcpy(configurations + 1, analysis->covering, cells * sizeof(uint64_t));
+    }
+
+    for (int cell = 0; cell < cells; cell++) {
+        analysis->probabilities[cell] = analysis->configurations
+            ? (double)analysis->covering[cell] / analysis->configurations : 0;
+    }
+    return true;
+}
+
+// Function to pick the untargeted box most likely to hold a boat, ties broken
+// at random. Returns false when the analysis failed and any untargeted box
+// was picked instead.
+bool chooseExactShot(ExactAnalysis *analysis, const Targeter *targeter, Rng *rng, int *x, int *y) {
+    bool exact = analyzeExact(analysis, targeter);
+    uint64_t best = 0;
+    uint32_t ties = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t k = pass == 0 ? 0 : randomBelow(rng, ties);
+        for (int cell = 0; cell < analysis->cells; cell++) {
+            if (bitTest(targeter->misses, cell) || bitTest(targeter->openHits, cell)
+                || bitTest(targeter->sunkZone, cell)) {
+                continue;
+            }
+            uint64_t weight = exact ? analysis->covering[cell] : 0;
+            if (pass == 0) {
+                if (ties == 0 || weight > best) {
+                    best = weight;
+                    ties = 0;
+                }
+                ties += weight == best;
+            } else if (weight == best && k-- == 0) {
+                *x = cell % analysis->width;
+                *y = cell / analysis->width;
+                return exact;
+            }
+        }
+        if (ties == 0) break;
+    }
+    *x = *y = 0; // Every box was targeted
+    return exact;
+}
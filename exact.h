@@ -0,0 +1,75 @@
+#ifndef EXACT_H
+#define EXACT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "targeting.h"
+
+// Exact hit probabilities of the boxes of a partially shot board, used by
+// AI_EXACT and by battleship-analyze.
+//
+// The fleets that agree with the shots (the rules of canPlaceBoat, every open
+// hit covered, no boat entirely hit unless announced sunk) are counted by a
+// dynamic programming over the boxes in reading order. A profile holds, for
+// every column, what the last box visited in it contains (water, the end of
+// a boat, or a vertical boat still growing by 1 to 3 boxes and whether it is
+// all hits so far), the horizontal boat being laid on the current row and the
+// box up and to the left. Equal profiles are merged, so each layer keeps one
+// count per profile and sub-fleet still to place, for the sub-fleets that
+// reach it only. A forward pass counts the prefixes, a backward pass the
+// completions; covering a box is the sum of their products over the profiles
+// that follow it with a boat in its column.
+//
+// The layers are kept from one analysis to the next. A shot only removes
+// placements, so when the new position is the held one with more boxes shot
+// and the same boats left, the prefixes before the first new shot and the
+// completions after the last one are still right: the forward pass starts
+// again at the first new shot, and the backward pass redoes the layers up to
+// the last one and, after it, only the sub-fleets the forward pass brought
+// there. Any other position (a boat sunk, another game, or the two exact
+// players of one game sharing an engine and taking turns) counts every
+// layer again.
+//
+// Boards up to EXACT_MAX_WIDTH columns and EXACT_MAX_HEIGHT rows, and boats
+// up to MAX_BOAT_SIZE long, are supported. The counts are 64-bit: each of the
+// MAX_BOATS boats has at most 2 * 16 * 128 = 2^12 placements, so no count
+// exceeds 2^60. The results of the last positions are also kept, keyed by
+// the shot masks and the boats left, so that a position seen again (the empty
+// board of every game with the same fleet, or the same turn analysed twice)
+// costs a copy.
+#define EXACT_MAX_WIDTH 16
+#define EXACT_MAX_HEIGHT 128
+#define EXACT_MAX_STATES (1L << 22)     // Profiles of the largest layer before the analysis gives up
+#define EXACT_CACHE_ENTRIES 64          // Positions whose results are kept
+
+typedef struct ExactLayer ExactLayer;
+
+// Declared as ExactAnalysis in targeting.h.
+struct ExactAnalysis {
+    int width;
+    int height;
+    int cells;
+    ExactLayer *layers;         // cells + 1 layers, layer i before box i is decided
+    uint64_t *scratch;          // Prefixes of the layer being reached, one row of every sub-fleet per profile
+    size_t scratchWords;
+    uint64_t *spareForward;     // Counts the next gathered layer is written to
+    uint64_t *spareCompletions;
+    uint32_t spareCapacity;
+    uint64_t *held;             // Key of the position the layers were counted for
+    bool holding;               // The layers hold that position
+    uint64_t *covering;         // Per box: fleets with a boat on it
+    double *probabilities;      // Per box: covering / configurations
+    uint64_t configurations;    // Fleets agreeing with the shots
+    long states;                // Profiles expanded plus profiles completed, 0 when the result was cached
+    int keyWords;               // Words of a cache key: the three masks, then the boats left
+    uint64_t *cache;            // Per entry: key, configurations, covering; one more for lookups
+    long cacheHits;
+};
+
+ExactAnalysis *createExactAnalysis(int width, int height);
+bool analyzeExact(ExactAnalysis *analysis, const Targeter *targeter);
+void freeExactAnalysis(ExactAnalysis *analysis);
+bool chooseExactShot(ExactAnalysis *analysis, const Targeter *targeter, Rng *rng, int *x, int *y);
+
+#endif // EXACT_H
@@ -1,42 +1,242 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include "game.h"
+#include "placement.h"
+#include "montecarlo.h"
+#include "exact.h"
+#include "book.h"
+#include "transposition.h"
+#include "instrument.h"
 
 
-Game *initializeGame() {
-    Game *newGame = (Game*)malloc(sizeof(Game));
+static int randomBoatSize(Rng *rng) {
+    return MIN_BOAT_SIZE + (int)randomBelow(rng, MAX_BOAT_SIZE - MIN_BOAT_SIZE + 1);
+}
+
+// Function to create a game and everything it needs from `arena`. On failure
+// NULL is returned and the memory already taken stays in the arena until reset.
+Game *initializeGame(const GameConfig *config, uint64_t seed, Arena *arena) {
+    INSTRUMENT_START(setupStart);
+    if ((config->strategies[0] == AI_MONTE_CARLO || config->strategies[1] == AI_MONTE_CARLO)
+        && config->monteCarlo == NULL) {
+        fprintf(stderr, "The montecarlo strategy needs an engine.\n");
+        return NULL;
+    }
+    if ((config->strategies[0] == AI_EXACT || config->strategies[1] == AI_EXACT) && config->exact == NULL) {
+        fprintf(stderr, "The exact strategy needs an engine.\n");
+        return NULL;
+    }
+    Game *newGame = (Game*)arenaCalloc(arena, 1, sizeof(Game));
     if (newGame == NULL) {
         fprintf(stderr, "Memory allocation failed for new game.\n");
         return NULL;
     }
 
-    // Initialize the game board for the two players
-    initializeGameBoard(&newGame->player1Board, BOARD_SIZE);
-    initializeGameBoard(&newGame->player2Board, BOARD_SIZE);
+    newGame->seed = seed;
+    newGame->arena = arena;
+    seedRng(&newGame->rng, seed);
 
-    srand(time(NULL)); // Initialization to use random number
+    // Initialize the game board for the two players
+    if (!initializeGameBoard(&newGame->player1Board, config->width, config->height, arena)
+        || !initializeGameBoard(&newGame->player2Board, config->width, config->height, arena)) {
+        return NULL;
+    }
 
-    // Initialize and place boat for each player
+    // Draw the size of every boat, then place each fleet as a whole.
     for (int i = 0; i < MAX_BOATS; i++) {
-        newGame->player1Boats[i] = *createBoat(rand() % 3 + 2, 0, 0, HORIZONTAL); 
-        if (!placeRandomBoat(&newGame->player1Board, &newGame->player1Boats[i])) {
-            fprintf(stderr, "Failed to place a boat for player 1.\n");
+        newGame->player1Boats[i] = createBoat(randomBoatSize(&newGame->rng), 0, 0, HORIZONTAL);
+        newGame->player2Boats[i] = createBoat(randomBoatSize(&newGame->rng), 0, 0, HORIZONTAL);
+    }
+
+    FleetPlacer placer;
+    bool placed = initializeFleetPlacer(&placer, config->width, config->height, MAX_BOATS, MAX_BOAT_SIZE, arena)
+        && placeFleet(&placer, &newGame->player1Board, newGame->player1Boats, MAX_BOATS, &newGame->rng)
+        && placeFleet(&placer, &newGame->player2Board, newGame->player2Boats, MAX_BOATS, &newGame->rng);
+    if (!placed) {
+        fprintf(stderr, "Failed to place the fleets.\n");
+        return NULL;
+    }
+
+    // Each side aims at the other's fleet, whose boat sizes are public.
+    if (!initializeTargeter(&newGame->player1Targeting, config->strategies[0], config->width, config->height,
+                            newGame->player2Boats, MAX_BOATS, arena)
+        || !initializeTargeter(&newGame->player2Targeting, config->strategies[1], config->width, config->height,
+                               newGame->player1Boats, MAX_BOATS, arena)) {
+        return NULL;
+    }
+    newGame->player1Targeting.monteCarlo = config->monteCarlo;
+    newGame->player2Targeting.monteCarlo = config->monteCarlo;
+    newGame->player1Targeting.exact = config->exact;
+    newGame->player2Targeting.exact = config->exact;
+    newGame->player1Targeting.book = newGame->player2Targeting.book = config->book;
+    newGame->player1Targeting.transpositions = newGame->player2Targeting.transpositions = config->transpositions;
+
+    INSTRUMENT_STOP(PHASE_SETUP, setupStart);
+    return newGame; // Return a pointer towards the new game
+}
+
+// Function to point the fleet of a forked board at the boats of its fork.
+static void adoptFleet(GameBoard *board, const Boat *original, Boat *boats) {
+    for (int i = 0; i < board->fleetSize; i++) {
+        for (int b = 0; b < MAX_BOATS; b++) {
+            if (board->fleet[i] == &original[b]) board->fleet[i] = &boats[b];
         }
+    }
+}
 
-        newGame->player2Boats[i] = *createBoat(rand() % 3 + 2, 0, 0, HORIZONTAL);
-        if (!placeRandomBoat(&newGame->player2Board, &newGame->player2Boats[i])) {
-            fprintf(stderr, "Failed to place a boat for player 2.\n");
+// Function to branch a game off into `arena`, sharing its boards and
+// targeters copy-on-write. Placement indexes are not shared: the fork has
+// none. Returns NULL when the fork cannot be made.
+Game *forkGame(Game *game, Arena *arena) {
+    if (game->arena == NULL) {
+        fprintf(stderr, "The game has no arena to fork from.\n");
+        return NULL;
+    }
+    if (game->player1Targeting.strategy >= AI_MONTE_CARLO || game->player2Targeting.strategy >= AI_MONTE_CARLO) {
+        fprintf(stderr, "Games of the Monte Carlo and exact strategies cannot be forked.\n");
+        return NULL;
+    }
+    Game *fork = (Game*)arenaAlloc(arena, sizeof(Game));
+    if (fork == NULL) {
+        fprintf(stderr, "Memory allocation failed for forked game.\n");
+        return NULL;
+    }
+    *fork = *game;
+    fork->arena = arena;
+
+    // The boats hold their hit counts, so every fork has its own.
+    adoptFleet(&fork->player1Board, game->player1Boats, fork->player1Boats);
+    adoptFleet(&fork->player2Board, game->player2Boats, fork->player2Boats);
+    GameBoard *boards[2] = { &game->player1Board, &game->player2Board };
+    GameBoard *forkBoards[2] = { &fork->player1Board, &fork->player2Board };
+    for (int i = 0; i < 2; i++) {
+        forkBoards[i]->placements = NULL;
+        forkBoards[i]->copyOnWrite = arena;
+        if (boards[i]->copyOnWrite == NULL) boards[i]->copyOnWrite = game->arena;
+    }
+    if (!shareTargeter(&fork->player1Targeting, &game->player1Targeting, arena, game->arena)
+        || !shareTargeter(&fork->player2Targeting, &game->player2Targeting, arena, game->arena)) {
+        return NULL;
+    }
+    return fork;
+}
+
+// Function to fire a shot of player `shooter` (1 or 2) at the other player's
+// board and let the shooter's targeter learn from it.
+ShotResult fireShot(Game *game, int shooter, int x, int y) {
+    if (shooter == 1) return applyComputerShot(&game->player2Board, &game->player1Targeting, x, y);
+    return applyComputerShot(&game->player1Board, &game->player2Targeting, x, y);
+}
+
+// Function to tell the player what a shot did
+void printShotResult(ShotResult result, const GameBoard *board) {
+    switch (result) {
+        case SHOT_MISS:
+            printf("Missed! You hit the water.\n");
+            break;
+        case SHOT_HIT:
+            printf("Hit! You've touched a boat.\n");
+            break;
+        case SHOT_SUNK:
+            printf("Hit and sunk! The whole boat is down.\n");
+            break;
+        case SHOT_ALREADY_TARGETED:
+            printf("This location has already been targeted.\n");
+            break;
+        case SHOT_INVALID:
+            printf("Invalid coordinates. Choose X within 0 and %d, Y within 0 and %d.\n",
+                   board->width - 1, board->height - 1);
+            break;
+    }
+}
+
+// Function to look the position up in the opening book, then in the
+// transposition table. A shot found there is checked against the board, in
+// case two positions shared a key.
+static bool rememberedShot(GameBoard *playerBoard, Targeter *targeting, int *x, int *y) {
+    int cell;
+    bool found = false;
+    if (targeting->book && targeting->book->strategy == targeting->strategy
+        && lookupOpeningBook(targeting->book, targeting->hash, &cell)) {
+        INSTRUMENT_COUNT(COUNT_BOOK_HITS, 1);
+        found = true;
+    } else if (targeting->transpositions) {
+        found = probeTransposition(targeting->transpositions, targeting->hash, &cell);
+        INSTRUMENT_COUNT(found ? COUNT_CACHE_HITS : COUNT_CACHE_MISSES, 1);
+    }
+    if (!found || cell < 0 || cell >= targeting->cells) return false;
+    *x = cell % targeting->width;
+    *y = cell / targeting->width;
+    return !isAlreadyTargeted(playerBoard, *x, *y);
+}
+
+// Function that picks the computer's next target without shooting
+void chooseComputerShot(GameBoard *playerBoard, Targeter *targeting, Rng *rng, int *x, int *y) {
+    INSTRUMENT_START(aiStart);
+    if (targeting->strategy != AI_RANDOM) {
+        if (!rememberedShot(playerBoard, targeting, x, y)) {
+            // With a table, the shot of a position must not depend on which
+            // game stored it first: ties are broken by a stream of the
+            // position instead of the game's, so a hit gives the shot a miss
+            // would have computed, and the game's stream draws the same.
+            Rng positionRng;
+            if (targeting->transpositions) {
+                seedRng(&positionRng, streamSeed(TRANSPOSITION_SEED, targeting->hash));
+                rng = &positionRng;
+            }
+            if (targeting->strategy == AI_DENSITY) {
+                chooseTargetedShot(targeting, rng, x, y);
+            } else if (targeting->strategy == AI_MONTE_CARLO) {
+                chooseMonteCarloShot(targeting->monteCarlo, targeting, rng, x, y);
+            } else {
+                chooseExactShot(targeting->exact, targeting, rng, x, y);
+            }
+            if (targeting->transpositions) {
+                storeTransposition(targeting->transpositions, targeting->hash, *y * targeting->width + *x);
+            }
         }
+        INSTRUMENT_STOP(PHASE_AI, aiStart);
+        return;
     }
 
-    return newGame; // Return a pointer towards the new game
+    // Continue to generate random coordinates until an untargeted box is found
+    *x = randomBelow(rng, playerBoard->width);
+    *y = randomBelow(rng, playerBoard->height);
+    while (isAlreadyTargeted(playerBoard, *x, *y)) {
+        INSTRUMENT_COUNT(COUNT_AI_REROLLS, 1);
+        *x = randomBelow(rng, playerBoard->width);
+        *y = randomBelow(rng, playerBoard->height);
+    }
+    INSTRUMENT_STOP(PHASE_AI, aiStart);
 }
 
-void freeGame(Game *game) {
-    if (game) {
-        // Free the two gameboard
-        freeGameBoard(&game->player1Board);
-        freeGameBoard(&game->player2Board);
+// Function that fires a shot chosen for the computer and learns from the result
+ShotResult applyComputerShot(GameBoard *playerBoard, Targeter *targeting, int x, int y) {
+    ShotResult result = shootAt(playerBoard, x, y);
+    observeShot(targeting, x, y, result);
+    if (result == SHOT_SUNK) observeSunk(targeting, boatAt(playerBoard, x, y));
+    return result;
+}
+
+// Function that makes the computer shoot and learn from the result, without output
+ShotResult computerShoot(GameBoard *playerBoard, Targeter *targeting, Rng *rng, int *x, int *y) {
+    chooseComputerShot(playerBoard, targeting, rng, x, y);
+    return applyComputerShot(playerBoard, targeting, *x, *y);
+}
+
+// Function that sequences a game round for the computer
+void computerTurn(GameBoard *playerBoard, Targeter *targeting, Rng *rng) {
+    int x, y;
+
+    ShotResult result = computerShoot(playerBoard, targeting, rng, &x, &y);
+    printShotResult(result, playerBoard);  // Shoot and make the changes
+    printf("Computer shot at (%d, %d).\n", x, y);
+}
 
-        free(game);
+void announceWinner(bool playerWon) {
+    if (playerWon) {
+        printf("You've won, you're a true Amiral !\n");
+    } else {
+        printf("Computer wins. It doesn't matter, sailor\n");
     }
 }
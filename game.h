@@ -3,15 +3,51 @@
 
 #include "gameboard.h"
 #include "boat.h"
+#include "targeting.h"
+#include "arena.h"
 
+// Everything a new game is built from, besides its seed.
+typedef struct {
+    int width;                  // Board dimensions, shared by both players
+    int height;
+    AiStrategy strategies[2];   // Strategy of each player when the computer plays it
+    MonteCarlo *monteCarlo;     // Engine of the AI_MONTE_CARLO players, owned by the caller
+    ExactAnalysis *exact;       // Engine of the AI_EXACT players, owned by the caller
+    const OpeningBook *book;    // Shots of the early positions for one strategy, NULL for none
+    TranspositionTable *transpositions; // Shots of the positions met lately, NULL for none
+} GameConfig;
+
+// A game and everything it points to live in the arena it was created from,
+// and are released by resetting or freeing that arena.
+//
+// forkGame branches a game off for what-if analysis, in an arena of its own.
+// The fork shares the boards and the targeters' arrays of the game instead of
+// copying them: whichever side writes first, the game or any fork, copies what
+// it writes into its own arena, so a fork costs the Game structure until it
+// plays. Forks are made from one thread, but can then play on any thread. A
+// game must outlive its forks, which may still read its memory. Only games of
+// AI_RANDOM and AI_DENSITY players can be forked: the Monte Carlo and exact
+// engines keep state of their own, which forks playing at once would share.
 typedef struct {
     GameBoard player1Board;
     GameBoard player2Board;
     Boat player1Boats[MAX_BOATS];
     Boat player2Boats[MAX_BOATS];
+    Targeter player1Targeting;         // What player 1 knows about player 2's board
+    Targeter player2Targeting;         // What player 2 knows about player 1's board
+    uint64_t seed;          // Seed the game was created from, enough to replay its setup
+    Rng rng;                // Random stream of this game only
+    Arena *arena;           // Arena the game lives in, where it copies what it shares with its forks
 } Game;
 
-Game *initializeGame();
-void freeGame(Game *game);
+Game *initializeGame(const GameConfig *config, uint64_t seed, Arena *arena);
+Game *forkGame(Game *game, Arena *arena);
+ShotResult fireShot(Game *game, int shooter, int x, int y);
+void printShotResult(ShotResult result, const GameBoard *board);
+void chooseComputerShot(GameBoard *playerBoard, Targeter *targeting, Rng *rng, int *x, int *y);
+ShotResult applyComputerShot(GameBoard *playerBoard, Targeter *targeting, int x, int y);
+ShotResult computerShoot(GameBoard *playerBoard, Targeter *targeting, Rng *rng, int *x, int *y);
+void computerTurn(GameBoard *playerBoard, Targeter *targeting, Rng *rng);
+void announceWinner(bool playerWon);
 
 #endif // GAME_H
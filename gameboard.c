@@ -1,99 +1,122 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "gameboard.h"
+#include "bitboard.h"
+#include "boat.h"
+#include "kernels.h"
+#include "placement.h"
+#include "instrument.h"
 
-void initializeGameBoard(GameBoard *board, int size) {
-    board->size = size;
-    board->grid = (CaseType**)malloc(sizeof(CaseType*) * size);
-    for (int i = 0; i < size; i++) {
-        board->grid[i] = (CaseType*)malloc(sizeof(CaseType) * size);
-        for (int j = 0; j < size; j++) {
-            board->grid[i][j] = WATER; // Initializes each case to WATER.
-        }
-    }
+// Rounds a byte count up to a whole number of cache lines.
+static size_t cacheLines(size_t bytes) {
+    return (bytes + 63) & ~(size_t)63;
 }
 
-void freeGameBoard(GameBoard *board) {
-    if (board && board->grid) {
-        for (int i = 0; i < board->size; i++) {
-            free(board->grid[i]);  // Free each line of the table.
-        }
-        free(board->grid);  // Clear the table of lines
-    }
+// Bytes of the block of a board: the cells, then the boats, shots and wrecks
+// masks, each starting on its own cache line.
+static size_t blockBytes(const GameBoard *board, size_t *cellBytes, size_t *maskBytes) {
+    *cellBytes = cacheLines(board->cellCount);
+    *maskBytes = cacheLines(board->words * sizeof(uint64_t));
+    return *cellBytes + 3 * *maskBytes;
+}
+
+static void pointIntoBlock(GameBoard *board, uint8_t *block, size_t cellBytes, size_t maskBytes) {
+    board->cells = block;
+    board->boats = (uint64_t*)(block + cellBytes);
+    board->shots = (uint64_t*)(block + cellBytes + maskBytes);
+    board->wrecks = (uint64_t*)(block + cellBytes + 2 * maskBytes);
 }
 
-void printPlayerView(GameBoard *board) {
-    if (board == NULL || board->grid == NULL) {
-        printf("Invalid game board.\n");
-        return;
+bool initializeGameBoard(GameBoard *board, int width, int height, Arena *arena) {
+    memset(board, 0, sizeof(GameBoard));
+    if (width < 1 || height < 1 || width > MAX_BOARD_SIDE || height > MAX_BOARD_SIDE) {
+        fprintf(stderr, "Invalid board size %dx%d.\n", width, height);
+        return false;
     }
 
-    // Header for the columns
-    printf("  ");
-    for (int x = 0; x < board->size; x++) {
-        printf("%d ", x);
+    board->width = width;
+    board->height = height;
+    board->cellCount = width * height;
+    board->words = bitboardWords(board->cellCount);
+    board->kernels = selectBoardKernels(width, height);
+
+    size_t cellBytes, maskBytes;
+    uint8_t *block = (uint8_t*)arenaCalloc(arena, 1, blockBytes(board, &cellBytes, &maskBytes));
+    if (block == NULL) {
+        fprintf(stderr, "Memory allocation failed for game board.\n");
+        return false;
     }
-    printf("\n");
 
-    // Browse the gameboard and display the status of each box
-    for (int y = 0; y < board->size; y++) {
-        // Line number on the left
-        printf("%d ", y);
+    // Every case starts as WATER, the zero value.
+    pointIntoBlock(board, block, cellBytes, maskBytes);
+    return true;
+}
+
+// Function to give the board a block of its own before it is written, when
+// it shares one with the boards it was forked from or into.
+bool ownGameBoard(GameBoard *board) {
+    if (board->copyOnWrite == NULL) return true;
 
-        for (int x = 0; x < board->size; x++) {
-            switch (board->grid[y][x]) {
-                case WATER:
-                    printf("~ "); // Water not targeted
-                    break;
-                case WATER_SHOT:
-                    printf("o "); // Water targeted by a shot
-                    break;
-                case BOAT:
-                    printf("B "); // Part of a boat not touched
-                    break;
-                case WRECK:
-                    printf("X "); // Part of a boat hit
-                    break;
-                default:
-                    printf("? "); // Unknown
-            }
-        }
-        printf("\n");
+    size_t cellBytes, maskBytes;
+    size_t bytes = blockBytes(board, &cellBytes, &maskBytes);
+    uint8_t *block = (uint8_t*)arenaAlloc(board->copyOnWrite, bytes);
+    if (block == NULL) {
+        fprintf(stderr, "Memory allocation failed for game board.\n");
+        return false;
     }
+    memcpy(block, board->cells, bytes);
+    pointIntoBlock(board, block, cellBytes, maskBytes);
+    board->copyOnWrite = NULL;
+    return true;
 }
 
-void printComputerView(GameBoard *board) {
-    if (board == NULL || board->grid == NULL) {
-        printf("Invalid game board.\n");
-        return;
+// Function to take every boat and every shot off the board. An attached
+// placement index is detached, since it no longer matches.
+bool clearGameBoard(GameBoard *board) {
+    if (!ownGameBoard(board)) return false;
+
+    size_t cellBytes, maskBytes;
+    memset(board->cells, 0, blockBytes(board, &cellBytes, &maskBytes));
+    board->placements = NULL;
+    board->fleetSize = 0;
+    board->remainingCells = 0;
+    return true;
+}
+
+// Function to make a shot on a given square of the board.
+// Nothing is printed here so that headless games stay free of I/O.
+ShotResult shootAt(GameBoard *board, int x, int y) {
+    if (!isOnBoard(board, x, y)) {
+        return SHOT_INVALID;
     }
 
-    // En-tête pour les colonnes.
-    printf("  ");
-    for (int x = 0; x < board->size; x++) {
-        printf("%d ", x);
+    INSTRUMENT_COUNT(COUNT_SHOTS, 1);
+    int bit = y * board->width + x;
+    if (bitTest(board->shots, bit)) {
+        return SHOT_ALREADY_TARGETED;
+    }
+    if (!ownGameBoard(board)) return SHOT_INVALID;
+    bitSet(board->shots, bit);
+    if (board->placements) updatePlacementIndex(board->placements, x, y, 1, 1, 1);
+    if (bitTest(board->boats, bit)) {
+        // The owner index stays in the cell, only the state changes.
+        Boat *boat = board->fleet[(board->cells[bit] >> CELL_BOAT_SHIFT) - 1];
+        bitSet(board->wrecks, bit);
+        board->cells[bit] = (board->cells[bit] & ~CELL_STATE_MASK) | WRECK;
+        board->remainingCells--;
+        boat->hit_count++;
+        return boat->hit_count == boat->size ? SHOT_SUNK : SHOT_HIT;
     }
-    printf("\n");
+    board->cells[bit] = WATER_SHOT;
+    return SHOT_MISS;
+}
 
-    // Parcourir le plateau et afficher l'état de chaque case.
-    for (int y = 0; y < board->size; y++) {
-        // Numéro de la ligne à gauche.
-        printf("%d ", y);
+// Function to check if a box has already been targeted
+bool isAlreadyTargeted(GameBoard *board, int x, int y) {
+    return bitTest(board->shots, y * board->width + x);
+}
 
-        for (int x = 0; x < board->size; x++) {
-            switch (board->grid[y][x]) {
-                case WATER_SHOT:
-                    printf("o "); // Eau ciblée par un tir.
-                    break;
-                case WRECK:
-                    printf("X "); // Partie d'un bateau touchée.
-                    break;
-                case WATER: // Cache les cases d'eau et de bateaux non touchés.
-                case BOAT:
-                default:
-                    printf("~ "); // Affiche comme de l'eau non ciblée.
-            }
-        }
-        printf("\n");
-    }
+bool isGameOver(GameBoard *board) {
+    return board->remainingCells == 0; // All boats have been touched
 }
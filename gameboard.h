@@ -1,16 +1,79 @@
 #ifndef GAMEBOARD_H
 #define GAMEBOARD_H
 
-#include "boat.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "arena.h"
 
+#define BOARD_SIZE 10       // Define the default size of the board
+#define MAX_BOARD_SIDE 1000 // Largest width or height accepted
+#define MAX_FLEET 63        // Boats a board can index, bounded by the cell encoding
+
+// A cell byte holds its CaseType in the low bits and, for boat cells, the index
+// of the boat plus one above them (zero for water).
+#define CELL_STATE_MASK 0x3
+#define CELL_BOAT_SHIFT 2
+
+typedef enum {
+    WATER,      // Water case
+    WATER_SHOT, // Water case where a shot has been made
+    BOAT,       // Case where a boat's part has not been hitten yet
+    WRECK,      // Case where a boat's part has been hitten
+} CaseType;
+
+typedef enum {
+    SHOT_MISS,              // The shot fell in the water
+    SHOT_HIT,               // The shot touched a boat
+    SHOT_SUNK,              // The shot touched the last intact part of a boat
+    SHOT_ALREADY_TARGETED,  // The case had already been targeted, nothing changes
+    SHOT_INVALID,           // The coordinates are outside the board
+} ShotResult;
+
+typedef struct Boat Boat;
+typedef struct BoardKernels BoardKernels;
+typedef struct PlacementIndex PlacementIndex;
+
+// Cell (x, y) is entry y * width + x of `cells` and bit y * width + x of the masks.
+// Everything lives in one cache-line aligned block that initializeGameBoard takes
+// from an arena; the board is released along with the arena. Boards forked from
+// one another share that block until one of them writes to it: the writer first
+// copies the block into its `copyOnWrite` arena (see forkGame in game.h).
 typedef struct {
-    CaseType **grid;
-    int size;
+    int width;
+    int height;
+    int cellCount;      // width * height
+    int words;          // Number of 64-bit words in each mask.
+    uint8_t *cells;     // One encoded cell per cell, kept in sync with the masks.
+    uint64_t *boats;    // Occupancy: cells holding a part of a boat.
+    uint64_t *shots;    // Cells already targeted by a shot.
+    uint64_t *wrecks;   // Boat cells that have been hit.
+    const BoardKernels *kernels;    // Mask loops compiled for this size, see kernels.h
+    PlacementIndex *placements;     // Legal placements kept up to date, NULL for none (see placement.h)
+    Arena *copyOnWrite;             // Arena to copy the block into before the next write, NULL when it is owned
+    int fleetSize;
+    Boat *fleet[MAX_FLEET]; // Boats set on the board, in the order they were set
+    int remainingCells; // Boat cells not hit yet, the game is over at zero
 } GameBoard;
 
-void initializeGameBoard(GameBoard *board, int size);
-void freeGameBoard(GameBoard *board);
-void printPlayerView(GameBoard *board);
-void printComputerView(GameBoard *board);
+static inline CaseType boardCase(const GameBoard *board, int x, int y) {
+    return (CaseType)(board->cells[y * board->width + x] & CELL_STATE_MASK);
+}
+
+// Boat covering cell (x, y), or NULL for water.
+static inline Boat *boatAt(const GameBoard *board, int x, int y) {
+    int owner = board->cells[y * board->width + x] >> CELL_BOAT_SHIFT;
+    return owner ? board->fleet[owner - 1] : NULL;
+}
+
+static inline bool isOnBoard(const GameBoard *board, int x, int y) {
+    return x >= 0 && x < board->width && y >= 0 && y < board->height;
+}
+
+bool initializeGameBoard(GameBoard *board, int width, int height, Arena *arena);
+bool ownGameBoard(GameBoard *board);
+bool clearGameBoard(GameBoard *board);
+ShotResult shootAt(GameBoard *board, int x, int y);
+bool isAlreadyTargeted(GameBoard *board, int x, int y);
+bool isGameOver(GameBoard *board);
 
 #endif // GAMEBOARD_H
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "instrument.h"
+
+// Only built with BATTLESHIP_INSTRUMENT, see the Makefile.
+
+// The last block is shared from the start, so that its first owner already
+// adds atomically when more threads join it.
+static InstrumentBlock blocks[INSTRUMENT_MAX_THREADS] = { [INSTRUMENT_MAX_THREADS - 1].shared = true };
+static int blocksClaimed;
+static volatile sig_atomic_t reportRequested;
+
+_Thread_local InstrumentBlock *instrumentLocal;
+
+static const char *counterNames[COUNTER_COUNT] = {
+    "placement retries", "ai rerolls", "shots", "cells scanned", "book hits", "cache hits", "cache misses"
+};
+
+static const char *phaseNames[PHASE_COUNT] = {
+    "setup", "ai", "render", "input"
+};
+
+// Function to give the calling thread its block, on its first event.
+InstrumentBlock *claimInstrumentBlock(void) {
+    int index = __atomic_fetch_add(&blocksClaimed, 1, __ATOMIC_RELAXED);
+    return &blocks[index < INSTRUMENT_MAX_THREADS ? index : INSTRUMENT_MAX_THREADS - 1];
+}
+
+// Lower bound in ns of the latencies of the bucket holding the q-th quantile.
+static uint64_t quantile(const uint64_t *histogram, uint64_t count, double q) {
+    uint64_t rank = (uint64_t)(q * (count - 1));
+    for (int b = 0; b < INSTRUMENT_BUCKETS; b++) {
+        if (rank < histogram[b]) return b == 0 ? 0 : (uint64_t)1 << (b - 1);
+        rank -= histogram[b];
+    }
+    return (uint64_t)1 << (INSTRUMENT_BUCKETS - 2);
+}
+
+// Function to print the counters and histograms of every thread, summed.
+void printInstrumentation(FILE *out) {
+    uint64_t counters[COUNTER_COUNT] = { 0 };
+    uint64_t histograms[PHASE_COUNT][INSTRUMENT_BUCKETS] = { { 0 } };
+    uint64_t totals[PHASE_COUNT] = { 0 };
+    int used = blocksClaimed < INSTRUMENT_MAX_THREADS ? blocksClaimed : INSTRUMENT_MAX_THREADS;
+
+    for (int t = 0; t < used; t++) {
+        for (int c = 0; c < COUNTER_COUNT; c++) counters[c] += __atomic_load_n(&blocks[t].counters[c], __ATOMIC_RELAXED);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            totals[p] += __atomic_load_n(&blocks[t].totals[p], __ATOMIC_RELAXED);
+            for (int b = 0; b < INSTRUMENT_BUCKETS; b++) {
+                histograms[p][b] += __atomic_load_n(&blocks[t].histograms[p][b], __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    fprintf(out, "Instrumentation (%d thread%s):\n", used, used == 1 ? "" : "s");
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        fprintf(out, "  %-18s %llu\n", counterNames[c], (unsigned long long)counters[c]);
+    }
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        uint64_t count = 0;
+        for (int b = 0; b < INSTRUMENT_BUCKETS; b++) count += histograms[p][b];
+        if (count == 0) continue;
+
+        fprintf(out, "  %-6s %llu calls, mean %.0f ns, p50 >= %llu ns, p99 >= %llu ns\n", phaseNames[p],
+                (unsigned long long)count, (double)totals[p] / count,
+                (unsigned long long)quantile(histograms[p], count, 0.5),
+                (unsigned long long)quantile(histograms[p], count, 0.99));
+        for (int b = 0; b < INSTRUMENT_BUCKETS; b++) {
+            if (histograms[p][b] == 0) continue;
+            fprintf(out, "    < %-12llu %llu\n", (unsigned long long)1 << b, (unsigned long long)histograms[p][b]);
+        }
+    }
+    fflush(out);
+}
+
+static void printAtExit(void) {
+    printInstrumentation(stderr);
+}
+
+// Only sets a flag: printing from a signal handler is not safe.
+static void requestReport(int signal) {
+    (void)signal;
+    reportRequested = 1;
+}
+
+// Function to print the report at exit and when SIGUSR1 is received.
+void installInstrumentation(void) {
+    struct sigaction action = { 0 };
+
+    action.sa_handler = requestReport;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+    atexit(printAtExit);
+}
+
+// Function to print the report if SIGUSR1 arrived since the last call.
+void pollInstrumentation(void) {
+    // Several workers may poll, only the first one to see the flag prints.
+    if (reportRequested && __atomic_exchange_n(&reportRequested, 0, __ATOMIC_RELAXED)) {
+        printInstrumentation(stderr);
+    }
+}
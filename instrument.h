@@ -0,0 +1,109 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdint.h>
+
+// Counters and per-phase latency histograms of the hot paths, compiled in
+// with -DBATTLESHIP_INSTRUMENT (make INSTRUMENT=1). Without it every macro
+// below expands to nothing and the engine is built exactly as before.
+//
+// Each thread updates its own block, so recording costs a thread-local add
+// and no lock. Past INSTRUMENT_MAX_THREADS, the threads share the last block,
+// which takes atomic adds instead. The blocks are summed when the report is printed: at exit,
+// or after SIGUSR1 at the next pollInstrumentation() of the program.
+
+typedef enum {
+    COUNT_PLACEMENT_RETRIES,    // Fleet slots abandoned after a dead end
+    COUNT_AI_REROLLS,           // Random shots drawn again on a targeted box
+    COUNT_SHOTS,                // Calls to shootAt
+    COUNT_CELLS_SCANNED,        // Densities read while choosing a shot
+    COUNT_BOOK_HITS,            // Shots read from the opening book
+    COUNT_CACHE_HITS,           // Shots found in the transposition table
+    COUNT_CACHE_MISSES,         // Shots looked up there in vain, then computed
+    COUNTER_COUNT
+} InstrumentCounter;
+
+typedef enum {
+    PHASE_SETUP,                // initializeGame
+    PHASE_AI,                   // chooseComputerShot
+    PHASE_RENDER,               // renderFrame
+    PHASE_INPUT,                // Reading a command, waiting for the player included
+    PHASE_COUNT
+} InstrumentPhase;
+
+#ifdef BATTLESHIP_INSTRUMENT
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define INSTRUMENT_BUCKETS 40       // Bucket b holds latencies in [2^(b-1), 2^b) ns
+#define INSTRUMENT_MAX_THREADS 64   // Threads beyond share the last block
+
+typedef struct {
+    _Alignas(64) uint64_t counters[COUNTER_COUNT];
+    uint64_t histograms[PHASE_COUNT][INSTRUMENT_BUCKETS];
+    uint64_t totals[PHASE_COUNT];   // Sum of the latencies in ns
+    bool shared;                    // Written by several threads: the last block
+} InstrumentBlock;
+
+extern _Thread_local InstrumentBlock *instrumentLocal;
+InstrumentBlock *claimInstrumentBlock(void);
+
+static inline InstrumentBlock *instrumentBlock(void) {
+    if (__builtin_expect(instrumentLocal == NULL, 0)) instrumentLocal = claimInstrumentBlock();
+    return instrumentLocal;
+}
+
+static inline uint64_t instrumentNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Relaxed stores when only the owner writes the block, relaxed adds on the
+// shared one; the report may read a block at any time.
+static inline void instrumentAdd(InstrumentBlock *block, uint64_t *slot, uint64_t amount) {
+    if (__builtin_expect(block->shared, 0)) {
+        __atomic_fetch_add(slot, amount, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(slot, *slot + amount, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void instrumentCount(InstrumentCounter counter, uint64_t amount) {
+    InstrumentBlock *block = instrumentBlock();
+    instrumentAdd(block, &block->counters[counter], amount);
+}
+
+static inline void instrumentLatency(InstrumentPhase phase, uint64_t start) {
+    uint64_t elapsed = instrumentNow() - start;
+    int bucket = elapsed == 0 ? 0 : 64 - __builtin_clzll(elapsed);
+    if (bucket >= INSTRUMENT_BUCKETS) bucket = INSTRUMENT_BUCKETS - 1;
+
+    InstrumentBlock *block = instrumentBlock();
+    instrumentAdd(block, &block->histograms[phase][bucket], 1);
+    instrumentAdd(block, &block->totals[phase], elapsed);
+}
+
+void installInstrumentation(void);
+void pollInstrumentation(void);
+void printInstrumentation(FILE *out);
+
+#define INSTRUMENT_COUNT(counter, amount) instrumentCount(counter, amount)
+#define INSTRUMENT_START(timer) uint64_t timer = instrumentNow()
+#define INSTRUMENT_STOP(phase, timer) instrumentLatency(phase, timer)
+#define INSTRUMENT_INSTALL() installInstrumentation()
+#define INSTRUMENT_POLL() pollInstrumentation()
+
+#else
+
+#define INSTRUMENT_COUNT(counter, amount) ((void)0)
+#define INSTRUMENT_START(timer) ((void)0)
+#define INSTRUMENT_STOP(phase, timer) ((void)0)
+#define INSTRUMENT_INSTALL() ((void)0)
+#define INSTRUMENT_POLL() ((void)0)
+
+#endif // BATTLESHIP_INSTRUMENT
+
+#endif // INSTRUMENT_H
@@ -0,0 +1,134 @@
+#include <string.h>
+#include "kernels.h"
+#include "bitboard.h"
+
+// Body shared by the kernels of every size: inlined into each of them, so
+// that the sized ones see their width and word count as constants.
+#define KERNEL static inline __attribute__((always_inline))
+
+#define KERNEL_MAX_WORDS 4  // Words of the largest sized board, 16x16
+
+// Clips the box grown by one cell on every side to the board: columns
+// [*x0, *x1] and rows [*y0, *y1].
+KERNEL void growBox(int width, int height, int left, int top, int boxWidth, int boxHeight,
+                    int *x0, int *x1, int *y0, int *y1) {
+    *x0 = left > 0 ? left - 1 : 0;
+    *x1 = left + boxWidth < width ? left + boxWidth : width - 1;
+    *y0 = top > 0 ? top - 1 : 0;
+    *y1 = top + boxHeight < height ? top + boxHeight : height - 1;
+}
+
+KERNEL int collectSlotsOn(const uint64_t *anchors, const uint64_t *forbidden, int length, uint64_t *slots,
+                          int width, int words) {
+    uint64_t *horizontal = slots;
+    uint64_t *vertical = slots + words;
+
+    memcpy(horizontal, anchors + (length - 1) * 2 * words, words * sizeof(uint64_t));
+    memcpy(vertical, anchors + ((length - 1) * 2 + 1) * words, words * sizeof(uint64_t));
+    for (int i = 0; i < length; i++) {
+        bitAndNotShifted(horizontal, forbidden, words, i);
+        bitAndNotShifted(vertical, forbidden, words, i * width);
+    }
+    return bitCount(slots, 2 * words);
+}
+
+// Generic kernels: one row of the grown box at a time, as a bit range, so
+// that the cost follows the box and not the board.
+static bool isClearAroundAny(const uint64_t *a, const uint64_t *b, int width, int height,
+                             int left, int top, int boxWidth, int boxHeight) {
+    int x0, x1, y0, y1;
+    growBox(width, height, left, top, boxWidth, boxHeight, &x0, &x1, &y0, &y1);
+    for (int y = y0; y <= y1; y++) {
+        int from = y * width + x0;
+        if (bitRangeAny(a, from, x1 - x0 + 1) || bitRangeAny(b, from, x1 - x0 + 1)) return false;
+    }
+    return true;
+}
+
+static void forbidAroundAny(uint64_t *forbidden, int width, int height, int left, int top, int boxWidth, int boxHeight) {
+    int x0, x1, y0, y1;
+    growBox(width, height, left, top, boxWidth, boxHeight, &x0, &x1, &y0, &y1);
+    for (int y = y0; y <= y1; y++) {
+        bitRangeSet(forbidden, y * width + x0, x1 - x0 + 1);
+    }
+}
+
+static int collectSlotsAny(const uint64_t *anchors, const uint64_t *forbidden, int length, uint64_t *slots,
+                           int width, int words) {
+    return collectSlotsOn(anchors, forbidden, length, slots, width, words);
+}
+
+static const BoardKernels anyKernels = { 0, 0, isClearAroundAny, forbidAroundAny, collectSlotsAny };
+
+// Sized kernels: the whole grown box as a mask of `words` words plus one,
+// which only catches the bits of the last row that spill past the board.
+// A row is 16 cells at most, so it straddles two words at most.
+KERNEL void boxMask(uint64_t *zone, int width, int height, int words, int left, int top, int boxWidth, int boxHeight) {
+    int x0, x1, y0, y1;
+    growBox(width, height, left, top, boxWidth, boxHeight, &x0, &x1, &y0, &y1);
+    uint64_t span = ((uint64_t)1 << (x1 - x0 + 1)) - 1;
+
+    for (int i = 0; i <= words; i++) zone[i] = 0;
+    for (int y = y0; y <= y1; y++) {
+        int from = y * width + x0;
+        zone[from >> 6] |= span << (from & 63);
+        zone[(from >> 6) + 1] |= (span >> 1) >> (63 - (from & 63));
+    }
+}
+
+KERNEL bool isClearAroundSized(const uint64_t *a, const uint64_t *b, int width, int height, int words,
+                               int left, int top, int boxWidth, int boxHeight) {
+    uint64_t zone[KERNEL_MAX_WORDS + 1];
+    uint64_t met = 0;
+
+    boxMask(zone, width, height, words, left, top, boxWidth, boxHeight);
+    for (int i = 0; i < words; i++) met |= (a[i] | b[i]) & zone[i];
+    return met == 0;
+}
+
+KERNEL void forbidAroundSized(uint64_t *forbidden, int width, int height, int words,
+                              int left, int top, int boxWidth, int boxHeight) {
+    uint64_t zone[KERNEL_MAX_WORDS + 1];
+
+    boxMask(zone, width, height, words, left, top, boxWidth, boxHeight);
+    for (int i = 0; i < words; i++) forbidden[i] |= zone[i];
+}
+
+// Kernels of the W x H boards, the dimensions passed in being ignored.
+#define SIZED_KERNELS(W, H)                                                                                     \
+    static bool isClearAround##W##x##H(const uint64_t *a, const uint64_t *b, int width, int height,             \
+                                       int left, int top, int boxWidth, int boxHeight) {                        \
+        (void)width;                                                                                            \
+        (void)height;                                                                                           \
+        return isClearAroundSized(a, b, W, H, bitboardWords(W * H), left, top, boxWidth, boxHeight);            \
+    }                                                                                                           \
+    static void forbidAround##W##x##H(uint64_t *forbidden, int width, int height,                               \
+                                      int left, int top, int boxWidth, int boxHeight) {                         \
+        (void)width;                                                                                            \
+        (void)height;                                                                                           \
+        forbidAroundSized(forbidden, W, H, bitboardWords(W * H), left, top, boxWidth, boxHeight);               \
+    }                                                                                                           \
+    static int collectSlots##W##x##H(const uint64_t *anchors, const uint64_t *forbidden, int length,            \
+                                     uint64_t *slots, int width, int words) {                                   \
+        (void)width;                                                                                            \
+        (void)words;                                                                                            \
+        return collectSlotsOn(anchors, forbidden, length, slots, W, bitboardWords(W * H));                      \
+    }                                                                                                           \
+    static const BoardKernels kernels##W##x##H = { W, H, isClearAround##W##x##H, forbidAround##W##x##H,         \
+                                                   collectSlots##W##x##H };
+
+SIZED_KERNELS(8, 8)
+SIZED_KERNELS(10, 10)
+SIZED_KERNELS(16, 16)
+
+_Static_assert((16 * 16 + 63) / 64 <= KERNEL_MAX_WORDS, "Sized boards must fit in KERNEL_MAX_WORDS words");
+
+// Function to pick the kernels of the boards of `width` x `height`.
+const BoardKernels *selectBoardKernels(int width, int height) {
+    static const BoardKernels *const sized[] = { &kernels8x8, &kernels10x10, &kernels16x16 };
+
+    for (size_t i = 0; i < sizeof(sized) / sizeof(sized[0]); i++) {
+        if (sized[i]->width == width && sized[i]->height == height) return sized[i];
+    }
+    return &anyKernels;
+}
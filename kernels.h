@@ -0,0 +1,37 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gameboard.h"
+
+// Inner loops over the masks of a board, compiled once for any size and once
+// for each of the common sizes: 8x8, 10x10 (BOARD_SIZE) and 16x16. In the
+// sized kernels the width and the number of words are constants, so the loops
+// over the words of a mask are unrolled and the rectangle around a boat is
+// built branch-free in a few registers. The kernels of a size are picked once,
+// when a board, a fleet placer or a Monte Carlo engine is set up, and called
+// through its `kernels` pointer; the dimensions they take are the ones of
+// that board, which the sized kernels ignore.
+//
+// A box is the rectangle of boxWidth x boxHeight cells at (left, top), lying
+// on the board. Masks hold bitboardWords(width * height) words, as in
+// bitboard.h, and the anchors follow the layout of the fleet placer: per
+// length then orientation, the first cells that keep a boat on the board.
+struct BoardKernels {
+    int width;      // Board the kernels were compiled for, 0 for any size
+    int height;
+    // True when the box grown by one cell on every side meets no bit of `a` or `b`.
+    bool (*isClearAround)(const uint64_t *a, const uint64_t *b, int width, int height,
+                          int left, int top, int boxWidth, int boxHeight);
+    // Sets the bits of the box grown by one cell on every side, clipped to the board.
+    void (*forbidAround)(uint64_t *forbidden, int width, int height, int left, int top, int boxWidth, int boxHeight);
+    // Writes the horizontal then the vertical first cells of a boat of
+    // `length` that meets no forbidden cell, and returns their number.
+    int (*collectSlots)(const uint64_t *anchors, const uint64_t *forbidden, int length, uint64_t *slots,
+                        int width, int words);
+};
+
+const BoardKernels *selectBoardKernels(int width, int height);
+
+#endif // KERNELS_H
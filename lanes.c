@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lanes.h"
+#include "arena.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LANES_X86
+#endif
+
+struct GameLanes {
+    int games;
+    int lanes;          // Games rounded up to LANE_BLOCK
+    int width;
+    int height;
+    int cells;
+    int words;          // 32-bit words of a shot mask
+    const LaneKernels *kernels;
+    Arena arena;        // Every array below
+
+    // Lane g of every array is game g.
+    uint32_t *shots;    // Cells already targeted: word w of game g at w * lanes + g
+    uint8_t *owners;    // Per game then cell: its boat plus one, zero for water
+    int32_t *intact;    // Per boat then game: its cells not hit yet
+    int32_t *afloat;    // Per game: boat cells not hit yet
+};
+
+// Scalar kernels: one lane after the other, as shootAt does. The vector ones
+// finish with them the lanes from `first` that do not fill a vector.
+static void shootScalarFrom(GameLanes *lanes, const int *cells, uint8_t *results, int first) {
+    int stride = lanes->lanes;
+
+    for (int g = first; g < lanes->games; g++) {
+        int cell = cells[g];
+        if (cell < 0 || cell >= lanes->cells) {
+            results[g] = SHOT_INVALID;
+            continue;
+        }
+        uint32_t *word = &lanes->shots[(size_t)(cell >> 5) * stride + g];
+        uint32_t bit = (uint32_t)1 << (cell & 31);
+        if (*word & bit) {
+            results[g] = SHOT_ALREADY_TARGETED;
+            continue;
+        }
+        *word |= bit;
+        int owner = lanes->owners[(size_t)g * lanes->cells + cell];
+        if (owner == 0) {
+            results[g] = SHOT_MISS;
+            continue;
+        }
+        lanes->afloat[g]--;
+        results[g] = --lanes->intact[(owner - 1) * stride + g] == 0 ? SHOT_SUNK : SHOT_HIT;
+    }
+}
+
+static int gameOverScalarFrom(const GameLanes *lanes, uint8_t *over, int first) {
+    int count = 0;
+    for (int g = first; g < lanes->games; g++) {
+        over[g] = lanes->afloat[g] == 0;
+        count += over[g];
+    }
+    return count;
+}
+
+static void shootScalar(GameLanes *lanes, const int *cells, uint8_t *results) {
+    shootScalarFrom(lanes, cells, results, 0);
+}
+
+static int gameOverScalar(const GameLanes *lanes, uint8_t *over) {
+    return gameOverScalarFrom(lanes, over, 0);
+}
+
+static const LaneKernels scalarKernels = { "scalar", shootScalar, gameOverScalar };
+
+#ifdef LANES_X86
+// Vector kernels. Each word of the shot masks is visited for a group of
+// lanes, and only the lanes whose shot falls in that word see a bit; the
+// owner of every new shot is gathered, then the count of each boat is
+// decremented in the lanes that hit it.
+__attribute__((target("avx2")))
+static void shootAvx2(GameLanes *lanes, const int *cells, uint8_t *results) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i cellCount = _mm256_set1_epi32(lanes->cells);
+    const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int stride = lanes->lanes;
+    int g = 0;
+
+    for (; g + 8 <= lanes->games; g += 8) {
+        __m256i cell = _mm256_loadu_si256((const __m256i*)(cells + g));
+        __m256i valid = _mm256_and_si256(_mm256_cmpgt_epi32(cell, _mm256_set1_epi32(-1)),
+                                         _mm256_cmpgt_epi32(cellCount, cell));
+        __m256i word = _mm256_srai_epi32(cell, 5);
+        __m256i bit = _mm256_and_si256(_mm256_sllv_epi32(one, _mm256_and_si256(cell, _mm256_set1_epi32(31))), valid);
+        __m256i already = zero;
+
+        for (int w = 0; w < lanes->words; w++) {
+            __m256i own = _mm256_and_si256(bit, _mm256_cmpeq_epi32(word, _mm256_set1_epi32(w)));
+            __m256i *shots = (__m256i*)(lanes->shots + (size_t)w * stride + g);
+            __m256i before = _mm256_load_si256(shots);
+            already = _mm256_or_si256(already, _mm256_and_si256(before, own));
+            _mm256_store_si256(shots, _mm256_or_si256(before, own));
+        }
+        __m256i unseen = _mm256_cmpeq_epi32(already, zero);     // All ones where the cell was not targeted yet
+        __m256i fresh = _mm256_and_si256(valid, unseen);
+        __m256i at = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32(g), laneIndex), cellCount),
+                                      cell);
+        __m256i owner = _mm256_and_si256(_mm256_mask_i32gather_epi32(zero, (const int*)lanes->owners, at, fresh, 1),
+                                         _mm256_set1_epi32(0xff));
+        __m256i hit = _mm256_andnot_si256(_mm256_cmpeq_epi32(owner, zero), fresh);
+        __m256i sunk = zero;
+
+        // A mask is -1 in the lanes it selects, so adding it takes one off.
+        if (!_mm256_testz_si256(hit, hit)) {
+            __m256i *afloat = (__m256i*)(lanes->afloat + g);
+            _mm256_store_si256(afloat, _mm256_add_epi32(_mm256_load_si256(afloat), hit));
+            for (int b = 0; b < MAX_BOATS; b++) {
+                __m256i mine = _mm256_and_si256(hit, _mm256_cmpeq_epi32(owner, _mm256_set1_epi32(b + 1)));
+                __m256i *intact = (__m256i*)(lanes->intact + b * stride + g);
+                __m256i left = _mm256_add_epi32(_mm256_load_si256(intact), mine);
+                _mm256_store_si256(intact, left);
+                sunk = _mm256_or_si256(sunk, _mm256_and_si256(mine, _mm256_cmpeq_epi32(left, zero)));
+            }
+        }
+
+        __m256i result = _mm256_blendv_epi8(_mm256_set1_epi32(SHOT_MISS), _mm256_set1_epi32(SHOT_HIT), hit);
+        result = _mm256_blendv_epi8(result, _mm256_set1_epi32(SHOT_SUNK), sunk);
+        result = _mm256_blendv_epi8(_mm256_set1_epi32(SHOT_ALREADY_TARGETED), result, unseen);
+        result = _mm256_blendv_epi8(_mm256_set1_epi32(SHOT_INVALID), result, valid);
+        __m128i half = _mm_packs_epi32(_mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1));
+        _mm_storel_epi64((__m128i*)(results + g), _mm_packus_epi16(half, half));
+    }
+    shootScalarFrom(lanes, cells, results, g);
+}
+
+__attribute__((target("avx2")))
+static int gameOverAvx2(const GameLanes *lanes, uint8_t *over) {
+    int count = 0;
+    int g = 0;
+
+    for (; g + 8 <= lanes->games; g += 8) {
+        __m256i afloat = _mm256_load_si256((const __m256i*)(lanes->afloat + g));
+        int sunk = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(afloat, _mm256_setzero_si256())));
+        for (int i = 0; i < 8; i++) over[g + i] = sunk >> i & 1;
+        count += __builtin_popcount(sunk);
+    }
+    return count + gameOverScalarFrom(lanes, over, g);
+}
+
+// Same kernels on 16 lanes, with mask registers for the lanes selected.
+__attribute__((target("avx512f")))
+static void shootAvx512(GameLanes *lanes, const int *cells, uint8_t *results) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i cellCount = _mm512_set1_epi32(lanes->cells);
+    const __m512i laneIndex = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    int stride = lanes->lanes;
+    int g = 0;
+
+    for (; g + 16 <= lanes->games; g += 16) {
+        __m512i cell = _mm512_loadu_si512(cells + g);
+        __mmask16 valid = _mm512_cmpge_epi32_mask(cell, zero) & _mm512_cmplt_epi32_mask(cell, cellCount);
+        __m512i word = _mm512_srai_epi32(cell, 5);
+        __m512i bit = _mm512_maskz_sllv_epi32(valid, one, _mm512_and_si512(cell, _mm512_set1_epi32(31)));
+        __mmask16 already = 0, sunk = 0;
+
+        for (int w = 0; w < lanes->words; w++) {
+            __m512i own = _mm512_maskz_mov_epi32(_mm512_cmpeq_epi32_mask(word, _mm512_set1_epi32(w)), bit);
+            uint32_t *shots = lanes->shots + (size_t)w * stride + g;
+            __m512i before = _mm512_load_si512(shots);
+            already |= _mm512_test_epi32_mask(before, own);
+            _mm512_store_si512(shots, _mm512_or_si512(before, own));
+        }
+        __mmask16 fresh = valid & (__mmask16)~already;
+        __m512i at = _mm512_add_epi32(_mm512_mullo_epi32(_mm512_add_epi32(_mm512_set1_epi32(g), laneIndex), cellCount),
+                                      cell);
+        __m512i owner = _mm512_and_si512(_mm512_mask_i32gather_epi32(zero, fresh, at, lanes->owners, 1),
+                                         _mm512_set1_epi32(0xff));
+        __mmask16 hit = _mm512_test_epi32_mask(owner, owner);
+
+        if (hit) {
+            int32_t *afloat = lanes->afloat + g;
+            _mm512_store_si512(afloat, _mm512_mask_sub_epi32(_mm512_load_si512(afloat), hit, _mm512_load_si512(afloat), one));
+            for (int b = 0; b < MAX_BOATS; b++) {
+                __mmask16 mine = hit & _mm512_cmpeq_epi32_mask(owner, _mm512_set1_epi32(b + 1));
+                int32_t *intact = lanes->intact + b * stride + g;
+                __m512i left = _mm512_mask_sub_epi32(_mm512_load_si512(intact), mine, _mm512_load_si512(intact), one);
+                _mm512_store_si512(intact, left);
+                sunk |= mine & _mm512_testn_epi32_mask(left, left);
+            }
+        }
+
+        __m512i result = _mm512_set1_epi32(SHOT_MISS);
+        result = _mm512_mask_mov_epi32(result, hit, _mm512_set1_epi32(SHOT_HIT));
+        result = _mm512_mask_mov_epi32(result, sunk, _mm512_set1_epi32(SHOT_SUNK));
+        result = _mm512_mask_mov_epi32(result, already, _mm512_set1_epi32(SHOT_ALREADY_TARGETED));
+        result = _mm512_mask_mov_epi32(result, (__mmask16)~valid, _mm512_set1_epi32(SHOT_INVALID));
+        _mm_storeu_si128((__m128i*)(results + g), _mm512_cvtepi32_epi8(result));
+    }
+    shootScalarFrom(lanes, cells, results, g);
+}
+
+__attribute__((target("avx512f")))
+static int gameOverAvx512(const GameLanes *lanes, uint8_t *over) {
+    int count = 0;
+    int g = 0;
+
+    for (; g + 16 <= lanes->games; g += 16) {
+        __m512i afloat = _mm512_load_si512(lanes->afloat + g);
+        __mmask16 sunk = _mm512_testn_epi32_mask(afloat, afloat);
+        _mm_storeu_si128((__m128i*)(over + g), _mm512_cvtepi32_epi8(_mm512_maskz_mov_epi32(sunk, _mm512_set1_epi32(1))));
+        count += __builtin_popcount(sunk);
+    }
+    return count + gameOverScalarFrom(lanes, over, g);
+}
+
+static const LaneKernels avx2Kernels = { "avx2", shootAvx2, gameOverAvx2 };
+static const LaneKernels avx512Kernels = { "avx512", shootAvx512, gameOverAvx512 };
+#endif
+
+// Every set of kernels, the widest first.
+static const LaneKernels *const laneKernels[] = {
+#ifdef LANES_X86
+    &avx512Kernels,
+    &avx2Kernels,
+#endif
+    &scalarKernels,
+};
+
+static bool isSupported(const LaneKernels *kernels) {
+#ifdef LANES_X86
+    if (kernels == &avx512Kernels) return __builtin_cpu_supports("avx512f");
+    if (kernels == &avx2Kernels) return __builtin_cpu_supports("avx2");
+#endif
+    return true;
+}
+
+// Function to pick the widest kernels this processor runs.
+const LaneKernels *selectLaneKernels(void) {
+    for (size_t i = 0; i < sizeof(laneKernels) / sizeof(laneKernels[0]); i++) {
+        if (isSupported(laneKernels[i])) return laneKernels[i];
+    }
+    return &scalarKernels;
+}
+
+// Function to find the kernels called `name`. Returns NULL when they were not
+// built or the processor lacks their instructions.
+const LaneKernels *findLaneKernels(const char *name) {
+    for (size_t i = 0; i < sizeof(laneKernels) / sizeof(laneKernels[0]); i++) {
+        if (strcmp(laneKernels[i]->name, name) == 0) return isSupported(laneKernels[i]) ? laneKernels[i] : NULL;
+    }
+    return NULL;
+}
+
+// Function to create a store of `games` games with empty boards. `kernels`
+// may be NULL for the ones of selectLaneKernels.
+GameLanes *createGameLanes(int games, int width, int height, const LaneKernels *kernels) {
+    // The kernels index the owners of every game with 32-bit offsets.
+    if (games <= 0 || width <= 0 || height <= 0 || (int64_t)(games + LANE_BLOCK) * width * height > INT32_MAX) {
+        fprintf(stderr, "Invalid game lanes: %d games of %dx%d.\n", games, width, height);
+        return NULL;
+    }
+    GameLanes *lanes = (GameLanes*)calloc(1, sizeof(GameLanes));
+    if (lanes == NULL) {
+        fprintf(stderr, "Memory allocation failed for game lanes.\n");
+        return NULL;
+    }
+    lanes->games = games;
+    lanes->lanes = (games + LANE_BLOCK - 1) / LANE_BLOCK * LANE_BLOCK;
+    lanes->width = width;
+    lanes->height = height;
+    lanes->cells = width * height;
+    lanes->words = (lanes->cells + 31) / 32;
+    lanes->kernels = kernels ? kernels : selectLaneKernels();
+    initializeArena(&lanes->arena, 0);
+
+    // The owners are gathered 4 bytes at a time, so 3 bytes of slack end them.
+    size_t mask = (size_t)lanes->words * lanes->lanes;
+    lanes->shots = (uint32_t*)arenaCalloc(&lanes->arena, mask, sizeof(uint32_t));
+    lanes->owners = (uint8_t*)arenaCalloc(&lanes->arena, (size_t)lanes->lanes * lanes->cells + 3, 1);
+    lanes->intact = (int32_t*)arenaCalloc(&lanes->arena, (size_t)MAX_BOATS * lanes->lanes, sizeof(int32_t));
+    lanes->afloat = (int32_t*)arenaCalloc(&lanes->arena, lanes->lanes, sizeof(int32_t));
+    if (!lanes->shots || !lanes->owners || !lanes->intact || !lanes->afloat) {
+        fprintf(stderr, "Memory allocation failed for game lanes.\n");
+        freeGameLanes(lanes);
+        return NULL;
+    }
+    return lanes;
+}
+
+void freeGameLanes(GameLanes *lanes) {
+    if (lanes) {
+        freeArena(&lanes->arena);
+        free(lanes);
+    }
+}
+
+const LaneKernels *gameLanesKernels(const GameLanes *lanes) {
+    return lanes->kernels;
+}
+
+// Function to give `game` a new fleet, on a board never shot at. The boats
+// must lie on the board without overlapping, as a placer leaves them.
+bool setLaneFleet(GameLanes *lanes, int game, const Boat *fleet, int count) {
+    int stride = lanes->lanes;
+    uint8_t *owners = lanes->owners + (size_t)game * lanes->cells;
+
+    if (game < 0 || game >= lanes->games || count < 0 || count > MAX_BOATS) {
+        fprintf(stderr, "Invalid fleet of %d boats for lane %d.\n", count, game);
+        return false;
+    }
+    for (int w = 0; w < lanes->words; w++) lanes->shots[w * stride + game] = 0;
+    memset(owners, 0, lanes->cells);
+    for (int b = 0; b < MAX_BOATS; b++) lanes->intact[b * stride + game] = 0;
+    lanes->afloat[game] = 0;
+
+    for (int b = 0; b < count; b++) {
+        const Boat *boat = &fleet[b];
+        int dx = boat->orientation == HORIZONTAL, dy = !dx;
+        if (boat->size < 1 || boat->x < 0 || boat->y < 0 || boat->x + dx * (boat->size - 1) >= lanes->width
+            || boat->y + dy * (boat->size - 1) >= lanes->height) {
+            fprintf(stderr, "Boat %d of lane %d is off the board.\n", b, game);
+            return false;
+        }
+        for (int i = 0; i < boat->size; i++) {
+            int cell = (boat->y + dy * i) * lanes->width + boat->x + dx * i;
+            if (owners[cell]) {
+                fprintf(stderr, "Boat %d of lane %d overlaps another one.\n", b, game);
+                return false;
+            }
+            owners[cell] = (uint8_t)(b + 1);
+        }
+        lanes->intact[b * stride + game] = boat->size;
+        lanes->afloat[game] += boat->size;
+    }
+    return true;
+}
+
+// Function to take one shot in every game: at cell y * width + x of
+// `cells[g]` in game g, whose ShotResult goes to `results[g]`. A cell off the
+// board, such as -1 for a game that sits out, changes nothing.
+void shootLanes(GameLanes *lanes, const int *cells, uint8_t *results) {
+    lanes->kernels->shoot(lanes, cells, results);
+}
+
+// Function to find the games whose fleet is sunk. Writes 1 or 0 per game to
+// `over`, and returns how many are.
+int lanesGameOver(const GameLanes *lanes, uint8_t *over) {
+    return lanes->kernels->gameOver(lanes, over);
+}
@@ -0,0 +1,46 @@
+#ifndef LANES_H
+#define LANES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gameboard.h"
+#include "boat.h"
+
+// Many games of the same size stored lane by lane, so that one vector
+// instruction works on a whole group of games: word w of the shot mask of
+// game g lies at w * lanes + g, as do the intact cells of boat b at
+// b * lanes + g, and a vector holds 8 (AVX2) or 16 (AVX-512) consecutive
+// games. shootLanes takes one shot in every game at once, each at its own
+// cell: every word of the masks is visited for the group, which only pays
+// while the board spans a few words (up to 16x16 or so), and the boat under
+// each new shot is gathered from a table of owners per game. lanesGameOver
+// checks every game.
+//
+// The kernels are picked once per store, the widest one the processor runs
+// unless asked otherwise, and give the same results as shootAt; the games
+// that do not fill a last vector go through the scalar ones. Each game holds
+// a fleet and the cells shot at, nothing else; the fleets come from the
+// placer of boat.h or placement.h.
+#define LANE_BLOCK 16   // Lanes are allocated in groups of this many games, so that rows stay aligned
+
+typedef struct GameLanes GameLanes;
+
+typedef struct {
+    const char *name;   // "scalar", "avx2" or "avx512"
+    // Takes the shot at `cells[g]` in every game g, writes its ShotResult to `results[g]`.
+    void (*shoot)(GameLanes *lanes, const int *cells, uint8_t *results);
+    // Writes, for every game, whether its fleet is sunk; returns how many are.
+    int (*gameOver)(const GameLanes *lanes, uint8_t *over);
+} LaneKernels;
+
+const LaneKernels *selectLaneKernels(void);
+const LaneKernels *findLaneKernels(const char *name);
+
+GameLanes *createGameLanes(int games, int width, int height, const LaneKernels *kernels);
+void freeGameLanes(GameLanes *lanes);
+const LaneKernels *gameLanesKernels(const GameLanes *lanes);
+bool setLaneFleet(GameLanes *lanes, int game, const Boat *fleet, int count);
+void shootLanes(GameLanes *lanes, const int *cells, uint8_t *results);
+int lanesGameOver(const GameLanes *lanes, uint8_t *over);
+
+#endif // LANES_H
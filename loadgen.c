@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "server.h"
+
+// Load generator for battleship-server: simulated players, all driven by one
+// thread over epoll, each playing whole games with one request in flight, as
+// a person would. Prints the throughput and the latency of the replies.
+
+#define MAX_CONNECTING 256      // Connections being opened at once, not to overflow the backlog
+#define LATENCY_BUCKETS 40      // Bucket b holds latencies in [2^(b-1), 2^b) ns
+#define EVENT_BATCH 256
+
+typedef enum {
+    PLAYER_CONNECTING,
+    PLAYER_STARTING,    // NEW sent
+    PLAYER_PLAYING,     // Shot sent
+    PLAYER_DONE
+} PlayerState;
+
+// The shots of a game visit every cell once: cell k is (start + k * step) mod
+// cells, with step prime to cells.
+typedef struct {
+    int fd;
+    PlayerState state;
+    int gamesLeft;
+    int width;
+    int cells;
+    int start;
+    int step;
+    int shot;
+    uint64_t sentAt;
+    int inLength;
+    char in[2 * SERVER_REPLY_MAX];
+} Player;
+
+typedef struct {
+    struct sockaddr_in address;
+    int epollFd;
+    Player *players;
+    int playerCount;
+    int gamesPerPlayer;
+    int started;        // Players whose connection was opened
+    int connecting;
+    int active;         // Players not done
+    Rng rng;
+    long games;
+    long wins;
+    long requests;
+    long errors;
+    uint64_t latencies[LATENCY_BUCKETS];
+} LoadGenerator;
+
+static uint64_t nowNanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int greatestCommonDivisor(int a, int b) {
+    while (b != 0) {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+static void finishPlayer(LoadGenerator *load, Player *player) {
+    if (player->fd >= 0) close(player->fd);
+    player->fd = -1;
+    if (player->state == PLAYER_CONNECTING) load->connecting--;
+    player->state = PLAYER_DONE;
+    load->active--;
+}
+
+static void failPlayer(LoadGenerator *load, Player *player) {
+    load->errors++;
+    finishPlayer(load, player);
+}
+
+static bool sendRequest(LoadGenerator *load, Player *player, const char *request, int length) {
+    player->sentAt = nowNanoseconds();
+    if (send(player->fd, request, length, MSG_NOSIGNAL) != length) {
+        failPlayer(load, player);
+        return false;
+    }
+    load->requests++;
+    return true;
+}
+
+static void sendShot(LoadGenerator *load, Player *player) {
+    char request[SERVER_LINE_MAX];
+    int cell = (int)(((long)player->start + (long)player->shot * player->step) % player->cells);
+    int length = snprintf(request, sizeof(request), "S %d %d\n", cell % player->width, cell / player->width);
+
+    player->shot++;
+    player->state = PLAYER_PLAYING;
+    sendRequest(load, player, request, length);
+}
+
+static void startGame(LoadGenerator *load, Player *player) {
+    player->state = PLAYER_STARTING;
+    sendRequest(load, player, "NEW\n", 4);
+}
+
+static void openConnection(LoadGenerator *load, Player *player) {
+    int on = 1;
+
+    player->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    player->state = PLAYER_CONNECTING;
+    player->gamesLeft = load->gamesPerPlayer;
+    load->started++;
+    load->connecting++;
+    if (player->fd < 0) {
+        perror("socket");
+        failPlayer(load, player);
+        return;
+    }
+    setsockopt(player->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    struct epoll_event event = { .events = EPOLLOUT, .data.ptr = player };
+    if ((connect(player->fd, (struct sockaddr*)&load->address, sizeof(load->address)) < 0 && errno != EINPROGRESS)
+        || epoll_ctl(load->epollFd, EPOLL_CTL_ADD, player->fd, &event) < 0) {
+        failPlayer(load, player);
+    }
+}
+
+// Handles one reply line of the server.
+static void handleReply(LoadGenerator *load, Player *player, char *line) {
+    uint64_t elapsed = nowNanoseconds() - player->sentAt;
+    int bucket = elapsed == 0 ? 0 : 64 - __builtin_clzll(elapsed);
+    load->latencies[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+
+    if (player->state == PLAYER_STARTING) {
+        int width, height;
+        if (sscanf(line, "G %d %d", &width, &height) != 2 || width <= 0 || height <= 0) {
+            failPlayer(load, player);
+            return;
+        }
+        player->width = width;
+        player->cells = width * height;
+        player->start = (int)randomBelow(&load->rng, player->cells);
+        do {
+            player->step = 1 + (int)randomBelow(&load->rng, player->cells);
+        } while (greatestCommonDivisor(player->step, player->cells) != 1);
+        player->shot = 0;
+        sendShot(load, player);
+        return;
+    }
+
+    size_t length = strlen(line);
+    if (line[0] == 'E' || line[0] == 'A' || line[0] == 'I' || length == 0) {
+        failPlayer(load, player);
+        return;
+    }
+    bool won = length >= 2 && strcmp(line + length - 2, " W") == 0;
+    bool lost = length >= 2 && strcmp(line + length - 2, " L") == 0;
+    if (!won && !lost) {
+        if (player->shot < player->cells) {
+            sendShot(load, player);
+        } else {
+            failPlayer(load, player);   // Every cell shot and the game still runs
+        }
+        return;
+    }
+
+    load->games++;
+    load->wins += won;
+    if (--player->gamesLeft > 0) {
+        startGame(load, player);
+    } else {
+        finishPlayer(load, player);
+    }
+}
+
+static void servePlayer(LoadGenerator *load, Player *player, uint32_t events) {
+    if (player->state == PLAYER_CONNECTING) {
+        int error = 0;
+        socklen_t size = sizeof(error);
+        getsockopt(player->fd, SOL_SOCKET, SO_ERROR, &error, &size);
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = player };
+        if (error != 0 || (events & (EPOLLERR | EPOLLHUP))
+            || epoll_ctl(load->epollFd, EPOLL_CTL_MOD, player->fd, &event) < 0) {
+            failPlayer(load, player);
+            return;
+        }
+        load->connecting--;
+        startGame(load, player);
+        return;
+    }
+
+    for (;;) {
+        ssize_t received = recv(player->fd, player->in + player->inLength, sizeof(player->in) - player->inLength, 0);
+        if (received <= 0) {
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (received < 0 && errno == EINTR) continue;
+            failPlayer(load, player);
+            return;
+        }
+        player->inLength += (int)received;
+
+        char *newline;
+        while (player->state != PLAYER_DONE && (newline = memchr(player->in, '\n', player->inLength)) != NULL) {
+            *newline = '\0';
+            int consumed = (int)(newline + 1 - player->in);
+            handleReply(load, player, player->in);
+            player->inLength -= consumed;
+            memmove(player->in, player->in + consumed, player->inLength);
+        }
+        if (player->state == PLAYER_DONE) return;
+        if (player->inLength == (int)sizeof(player->in)) {
+            failPlayer(load, player);
+            return;
+        }
+    }
+}
+
+static uint64_t latencyQuantile(const LoadGenerator *load, double q) {
+    long count = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) count += (long)load->latencies[b];
+    long rank = (long)(q * (count - 1));
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (rank < (long)load->latencies[b]) return b == 0 ? 0 : (uint64_t)1 << b;
+        rank -= (long)load->latencies[b];
+    }
+    return (uint64_t)1 << (LATENCY_BUCKETS - 1);
+}
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--address IPV4] [--port PORT] [--players N] [--games G] [--seed SEED]\n", program);
+}
+
+int main(int argc, char **argv) {
+    const char *address = "127.0.0.1";
+    int port = SERVER_PORT;
+    uint64_t seed = (uint64_t)time(NULL);
+    static LoadGenerator load;
+
+    load.playerCount = 1000;
+    load.gamesPerPlayer = 10;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--address") == 0 && i + 1 < argc) {
+            address = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            load.playerCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            load.gamesPerPlayer = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (load.playerCount <= 0 || load.gamesPerPlayer <= 0) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // One descriptor per player.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+        if ((long)limit.rlim_cur < load.playerCount + 16) {
+            fprintf(stderr, "Only %ld descriptors allowed, raise the limit (ulimit -n) for %d players.\n",
+                    (long)limit.rlim_cur, load.playerCount);
+            return EXIT_FAILURE;
+        }
+    }
+
+    load.address.sin_family = AF_INET;
+    load.address.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, address, &load.address.sin_addr) != 1) {
+        fprintf(stderr, "Invalid address %s.\n", address);
+        return EXIT_FAILURE;
+    }
+    load.players = (Player*)calloc(load.playerCount, sizeof(Player));
+    load.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (load.players == NULL || load.epollFd < 0) {
+        fprintf(stderr, "Cannot set up %d players.\n", load.playerCount);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < load.playerCount; i++) load.players[i].fd = -1;
+    seedRng(&load.rng, seed);
+    load.active = load.playerCount;
+
+    struct epoll_event events[EVENT_BATCH];
+    uint64_t start = nowNanoseconds();
+    while (load.active > 0) {
+        while (load.started < load.playerCount && load.connecting < MAX_CONNECTING) {
+            openConnection(&load, &load.players[load.started]);
+        }
+        int count = epoll_wait(load.epollFd, events, EVENT_BATCH, 1000);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        if (count == 0 && load.connecting == 0 && load.started == load.playerCount) {
+            fprintf(stderr, "No reply from the server for a second, giving up.\n");
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            Player *player = (Player*)events[i].data.ptr;
+            if (player->state != PLAYER_DONE) servePlayer(&load, player, events[i].events);
+        }
+    }
+    double seconds = (nowNanoseconds() - start) * 1e-9;
+
+    printf("Players:        %d, %d games each\n", load.playerCount, load.gamesPerPlayer);
+    printf("Games:          %ld in %.3f s (%.0f games/s), %ld won by the players\n",
+           load.games, seconds, load.games / seconds, load.wins);
+    printf("Requests:       %ld (%.0f requests/s), %ld errors\n", load.requests, load.requests / seconds, load.errors);
+    if (load.requests > 0) {
+        printf("Latency:        p50 < %.1f us, p99 < %.1f us, p99.9 < %.1f us\n", latencyQuantile(&load, 0.5) * 1e-3,
+               latencyQuantile(&load, 0.99) * 1e-3, latencyQuantile(&load, 0.999) * 1e-3);
+    }
+    for (int i = 0; i < load.playerCount; i++) {
+        if (load.players[i].fd >= 0) close(load.players[i].fd);
+    }
+    free(load.players);
+    close(load.epollFd);
+    return load.errors == 0 && load.games == (long)load.playerCount * load.gamesPerPlayer ? EXIT_SUCCESS : EXIT_FAILURE;
+}
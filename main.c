@@ -1,402 +1,313 @@
-#define MAX_BOATS 5       // Define the maximum number of boats for a player
-#define BOARD_SIZE 10       // Define the size of the board
-
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdbool.h>    // Include for bool type
-#include <time.h>     // rand() and srand() utilisation
-
-
-typedef enum {
-    WATER,      // Water case
-    WATER_SHOT, // Water case where a shot has been made
-    BOAT,       // Case where a boat's part has not been hitten yet
-    WRECK,      // Case where a boat's part has not been hitten yet
-} CaseType;
-
-
-typedef enum {
-    HORIZONTAL, // Indicates the boat is placed horizontally.
-    VERTICAL,   // Indicates the boat is placed vertically.
-} Orientation;
-
-typedef struct{
-    int size;             // The length of the boat in terms of the number of grid squares it occupies.
-    int x, y;             // Coordinates of the reference position of the boat (e.g., the top-left position).
-    Orientation orientation; // The orientation of the boat: HORIZONTAL or VERTICAL.
-    int hit_count;         // The number of hits the boat has received.
-} Boat;
-
-typedef struct {
-    CaseType **grid;  // Pointer to a 2D CaseType table representing the tray.
-    int size;         // Size of one side of the square matrix 
-} GameBoard;
-
-typedef struct {
-    GameBoard player1Board;            // Game board for player 1.
-    GameBoard player2Board;            // Game board for player 2.
-    Boat player1Boats[MAX_BOATS];      // Array of boats for player 1.
-    Boat player2Boats[MAX_BOATS];      // Array of boats for player 2.
-} Game;
-
-
-
-Boat *createBoat(int size, int x, int y, Orientation orientation) {
-    // Allocate memory for a new Boat.
-    Boat *newBoat = (Boat*)malloc(sizeof(Boat));
-    if (newBoat == NULL) {
-        fprintf(stderr, "Memory allocation failed for new boat.\n");
-        return NULL;
-    }
-
-    // Initialize the boat's properties.
-    newBoat->size = size;
-    newBoat->x = x;
-    newBoat->y = y;
-    newBoat->orientation = orientation;
-
-    return newBoat; // Return the pointer to the new boat.
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "game.h"
+#include "renderer.h"
+#include "montecarlo.h"
+#include "exact.h"
+#include "book.h"
+#include "transposition.h"
+#include "record.h"
+#include "snapshot.h"
+#include "command.h"
+#include "speculation.h"
+#include "instrument.h"
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--seed SEED] [--size N | --width W --height H]\n"
+                    "          [--ai STRATEGY] [--ai1 STRATEGY] [--spectate]\n"
+                    "          [--mc-threads N] [--mc-samples N] [--mc-budget US] [--book FILE]\n"
+                    "          [--no-render | --plain] [--render-every TURNS]\n"
+                    "Strategies: random, density, montecarlo, exact\n", program);
 }
 
+// Function that shows a single computer vs computer game from player 1's side
+static int runSpectated(Game *game, Renderer *renderer) {
+    GameBoard *targets[2] = { &game->player2Board, &game->player1Board };
+    Targeter *targeting[2] = { &game->player1Targeting, &game->player2Targeting };
+    int x, y;
 
-// Function to check if a boat is still alive
-bool isBoatAlive(Boat *boat) {
-    if (boat == NULL) {
-        return false; // Return false if boat pointer is NULL.
-    }
-
-    // Check if the number of hits is less than the size of the boat.
-    return boat->hit_count < boat->size;
-}
-
-
-bool canPlaceBoat(GameBoard *board, Boat *boat) {
-    // Check if the boat leaves the board
-    if (boat->orientation == HORIZONTAL) {
-        if (boat->x + boat->size > board->size) return false;
-    } else { // VERTICAL
-        if (boat->y + boat->size > board->size) return false;
-    }
-
-    // Check if the boat touches or overlaps another boat
-    for (int i = 0; i < boat->size; i++) {
-        int x = boat->x + (boat->orientation == HORIZONTAL ? i : 0);
-        int y = boat->y + (boat->orientation == VERTICAL ? i : 0);
-
-        // Check the actual case
-        if (board->grid[y][x] != WATER) return false;
+    for (int turn = 0; ; turn ^= 1) {
+        computerShoot(targets[turn], targeting[turn], &game->rng, &x, &y);
+        renderFrame(renderer, &game->player1Board, &game->player2Board, false);
+        INSTRUMENT_POLL();
 
-        // Check the boxes around to avoid touching another boat.
-        for (int dx = -1; dx <= 1; dx++) {
-            for (int dy = -1; dy <= 1; dy++) {
-                int nx = x + dx, ny = y + dy;
-                if (nx >= 0 && nx < board->size && ny >= 0 && ny < board->size) {
-                    if (board->grid[ny][nx] != WATER) return false;
-                }
-            }
+        if (isGameOver(targets[turn])) {
+            renderFrame(renderer, &game->player1Board, &game->player2Board, true);
+            printf("Player %d wins.\n", turn + 1);
+            return EXIT_SUCCESS;
         }
     }
-    return true;
-}
-
-void setBoatOnBoard(GameBoard *board, Boat *boat) {
-    for (int i = 0; i < boat->size; i++) {
-        int x = boat->x + (boat->orientation == HORIZONTAL ? i : 0);
-        int y = boat->y + (boat->orientation == VERTICAL ? i : 0);
-
-        board->grid[y][x] = BOAT; // Place a part of the boat on the game board
-    }
 }
 
-// Function to place a boat on the game board randomly
-
-bool placeRandomBoat(GameBoard *board, Boat *boat) {
-    if (!board || !boat) return false; // Check if pointer no-NULL.
-
-    // Set a maximum number of attempts to avoid an infinite loop if placement is not possible.
-    int maxTries = 100;
-    for (int tries = 0; tries < maxTries; tries++) {
-        // Generate random position and orientation
-        boat->x = rand() % board->size;
-        boat->y = rand() % board->size;
-        boat->orientation = (rand() % 2 == 0) ? HORIZONTAL : VERTICAL;
-
-        // Check if the boat can be placed
-        if (canPlaceBoat(board, boat)) {
-            setBoatOnBoard(board, boat); // Place the boat
-            return true; // Success
+// Function to write the game played so far to `path`, as a record that
+// battleship-sim --replay reads. The shots taken back are left out.
+static bool saveGame(const Game *game, const GameHistory *history, const char *path) {
+    RecordFile file;
+    RecordWriter writer;
+
+    if (!openRecordFile(&file, path)) return false;
+    bool ok = initializeRecordWriter(&writer, &file);
+    if (ok) {
+        ok = beginGameRecord(&writer, game);
+        for (int i = 0; ok && i < history->position; i++) {
+            HistoryShot shot = gameHistoryShot(history, i);
+            ok = recordShot(&writer, shot.shooter, shot.x, shot.y, shot.result);
         }
-    }
-    return false; // Fail after the maxTries
-}
-
-
-void initializeGameBoard(GameBoard *board, int size) {
-    board->size = size;
-    board->grid = (CaseType**)malloc(sizeof(CaseType*) * size);
-    for (int i = 0; i < size; i++) {
-        board->grid[i] = (CaseType*)malloc(sizeof(CaseType) * size);
-        for (int j = 0; j < size; j++) {
-            board->grid[i][j] = WATER; // Initializes each case to WATER.
+        if (ok) {
+            ok = endGameRecord(&writer, 0) && flushRecordWriter(&writer);
+        } else {
+            abortGameRecord(&writer);
         }
+        freeRecordWriter(&writer);
     }
+    return closeRecordFile(&file) && ok;
 }
 
-void freeGameBoard(GameBoard *board) {
-    if (board && board->grid) {
-        for (int i = 0; i < board->size; i++) {
-            free(board->grid[i]);  // Free each line of the table.
-        }
-        free(board->grid);  // Clear the table of lines
+// Function to find the position an undo goes back to: before the player's
+// last shot. Returns -1 when there is none.
+static int undoPosition(const GameHistory *history) {
+    for (int i = history->position - 1; i >= 0; i--) {
+        if (gameHistoryShot(history, i).shooter == 1) return i;
     }
+    return -1;
 }
 
-Game *initializeGame() {
-    Game *newGame = (Game*)malloc(sizeof(Game));
-    if (newGame == NULL) {
-        fprintf(stderr, "Memory allocation failed for new game.\n");
-        return NULL;
-    }
+// Function to find the position a redo goes forth to: after the player's next
+// shot and the computer's reply to it. Returns -1 when there is none.
+static int redoPosition(const GameHistory *history) {
+    int position = history->position;
+    if (position == history->count) return -1;
+    position++;
+    if (position < history->count && gameHistoryShot(history, position).shooter == 2) position++;
+    return position;
+}
 
-    // Initialize the game board for the two players
-    initializeGameBoard(&newGame->player1Board, BOARD_SIZE);
-    initializeGameBoard(&newGame->player2Board, BOARD_SIZE);
+// Function to read the player's next command. The end of the input quits.
+static void readCommand(InputReader *input, const Game *game, Command *command) {
+    char *line;
+    InputStatus status;
 
-    srand(time(NULL)); // Initialization to use random number
+    printf("Your shot (B7 or X Y), or save, undo, redo, quit, help: ");
+    fflush(stdout);
+    INSTRUMENT_START(inputStart);
+    while ((status = readInputLine(input, -1, &line)) == INPUT_PENDING) INSTRUMENT_POLL();
+    INSTRUMENT_STOP(PHASE_INPUT, inputStart);
 
-    // Initialize and place boat for each player
-    for (int i = 0; i < MAX_BOATS; i++) {
-        newGame->player1Boats[i] = *createBoat(rand() % 3 + 2, 0, 0, HORIZONTAL); 
-        if (!placeRandomBoat(&newGame->player1Board, &newGame->player1Boats[i])) {
-            fprintf(stderr, "Failed to place a boat for player 1.\n");
-        }
-
-        newGame->player2Boats[i] = *createBoat(rand() % 3 + 2, 0, 0, HORIZONTAL);
-        if (!placeRandomBoat(&newGame->player2Board, &newGame->player2Boats[i])) {
-            fprintf(stderr, "Failed to place a boat for player 2.\n");
-        }
+    if (status == INPUT_CLOSED) {
+        printf("\n");
+        command->type = COMMAND_QUIT;
+    } else {
+        parseCommand(line, game->player2Board.width, game->player2Board.height, command);
     }
-
-    return newGame; // Return a pointer towards the new game
 }
 
-// Function to display a board with the status of the boats with player view
-void printPlayerView(GameBoard *board) {
-    if (board == NULL || board->grid == NULL) {
-        printf("Invalid game board.\n");
-        return;
-    }
+_Static_assert(HISTORY_CHECKPOINT_SHOTS % 2 == 0, "Checkpoints must not fall after the player's shots");
 
-    // Header for the columns
-    printf("  ");
-    for (int x = 0; x < board->size; x++) {
-        printf("%d ", x);
-    }
-    printf("\n");
+// Function that plays the game against the player. The computer chooses its
+// reply while the player types, so it answers as soon as the shot is in.
+static int runInteractive(Game *game, Renderer *renderer) {
+    InputReader input;
+    Command command;
+    GameHistory history;
+    bool gameIsOver = false;
+    bool quit = false;
+    int x, y;
+    Speculation *speculation = createSpeculation();
 
-    // Browse the gameboard and display the status of each box
-    for (int y = 0; y < board->size; y++) {
-        // Line number on the left
-        printf("%d ", y);
+    if (speculation == NULL || !initializeGameHistory(&history, game)) {
+        fprintf(stderr, "Failed to start the game loop.\n");
+        freeSpeculation(speculation);
+        return EXIT_FAILURE;
+    }
+    initializeInputReader(&input, STDIN_FILENO);
 
-        for (int x = 0; x < board->size; x++) {
-            switch (board->grid[y][x]) {
-                case WATER:
-                    printf("~ "); // Water not targeted
+    // Game's loop
+    while (!gameIsOver && !quit) {
+        startSpeculation(speculation, &game->player1Board, &game->player2Targeting, &game->rng);
+
+        // Player's turn: commands until a shot counts
+        printf("Player's Turn:\n");
+        bool shot = false;
+        while (!shot && !quit) {
+            readCommand(&input, game, &command);
+            switch (command.type) {
+                case COMMAND_SHOT: {
+                    ShotResult result = fireShot(game, 1, command.x, command.y);
+                    printShotResult(result, &game->player2Board);
+                    shot = result != SHOT_ALREADY_TARGETED;
+                    // The speculation is still drawing from the game's stream:
+                    // the player's shot leaves the position odd, where no
+                    // checkpoint reads the game (see snapshot.h).
+                    if (shot && !pushGameHistory(&history, game, 1, command.x, command.y, result)) quit = true;
                     break;
-                case WATER_SHOT:
-                    printf("o "); // Water targeted by a shot
+                }
+                case COMMAND_SAVE:
+                    if (saveGame(game, &history, command.path)) printf("Game saved to %s.\n", command.path);
                     break;
-                case BOAT:
-                    printf("B "); // Part of a boat not touched
+                case COMMAND_UNDO:
+                case COMMAND_REDO: {
+                    bool undo = command.type == COMMAND_UNDO;
+                    int position = undo ? undoPosition(&history) : redoPosition(&history);
+                    if (position < 0) {
+                        printf(undo ? "Nothing to undo.\n" : "Nothing to redo.\n");
+                        break;
+                    }
+                    // The reply being chosen belongs to the position left.
+                    cancelSpeculation(speculation);
+                    if (!seekGameHistory(&history, game, position)) {
+                        fprintf(stderr, "Failed to move through the game history.\n");
+                        quit = true;
+                        break;
+                    }
+                    // The game ends on its last shot, so the history never reaches its end.
+                    renderFrame(renderer, &game->player1Board, &game->player2Board, true);
+                    printf(undo ? "Your last shot and the computer's reply were taken back.\n"
+                                : "Your next shot and the computer's reply were played again.\n");
+                    startSpeculation(speculation, &game->player1Board, &game->player2Targeting, &game->rng);
                     break;
-                case WRECK:
-                    printf("X "); // Part of a boat hit
+                }
+                case COMMAND_QUIT:
+                    quit = true;
                     break;
-                default:
-                    printf("? "); // Unknown
-            }
-        }
-        printf("\n");
-    }
-}
-
-void printComputerView(GameBoard *board) {
-    if (board == NULL || board->grid == NULL) {
-        printf("Invalid game board.\n");
-        return;
-    }
-
-    // En-tête pour les colonnes.
-    printf("  ");
-    for (int x = 0; x < board->size; x++) {
-        printf("%d ", x);
-    }
-    printf("\n");
-
-    // Parcourir le plateau et afficher l'état de chaque case.
-    for (int y = 0; y < board->size; y++) {
-        // Numéro de la ligne à gauche.
-        printf("%d ", y);
-
-        for (int x = 0; x < board->size; x++) {
-            switch (board->grid[y][x]) {
-                case WATER_SHOT:
-                    printf("o "); // Eau ciblée par un tir.
+                case COMMAND_HELP:
+                    printf("B7 or 1 7: shoot at column B (numbered 1 on screen), row 7; save [FILE]: write the game to FILE "
+                           "(%s by default); undo: take back your last shot; redo: play it again; "
+                           "quit: leave the game.\n", COMMAND_DEFAULT_SAVE);
                     break;
-                case WRECK:
-                    printf("X "); // Partie d'un bateau touchée.
+                case COMMAND_INVALID:
+                    printf("%s\n", command.error);
+                    break;
+                case COMMAND_EMPTY:
                     break;
-                case WATER: // Cache les cases d'eau et de bateaux non touchés.
-                case BOAT:
-                default:
-                    printf("~ "); // Affiche comme de l'eau non ciblée.
             }
         }
-        printf("\n");
-    }
-}
+        if (quit) break;
 
-// Function to make a shot on a given square of the board
-void shootAt(GameBoard *board, int x, int y) {
-    if (x >= 0 && x < board->size && y >= 0 && y < board->size) {
-        // Check the current status of the case and make the changes
-        switch (board->grid[y][x]) {
-            case WATER:
-                board->grid[y][x] = WATER_SHOT;
-                printf("Missed! You hit the water.\n");
-                break;
-            case BOAT:
-                board->grid[y][x] = WRECK;
-                printf("Hit! You've touched a boat.\n");
-                break;
-            case WATER_SHOT:
-            case WRECK:
-                printf("This location has already been targeted.\n");
-                break;
+        gameIsOver = isGameOver(&game->player2Board);
+        renderFrame(renderer, &game->player1Board, &game->player2Board, gameIsOver);
+        if (gameIsOver) {
+            announceWinner(true); // Player wins
+            break;
         }
-    } else {
-        printf("Invalid coordinates. Choose within 0 and %d.\n", board->size - 1);
-    }
-}
-
-// Function that sequences a game round for the player
-void playerTurn(GameBoard *enemyBoard) {
-    int x, y;
-
-    printf("Enter coordinates for your shot (X Y): ");
-    scanf("%d %d", &x, &y);  // Ask the player to enter coordinates
-
-    shootAt(enemyBoard, x, y);  // Shoot and make the changes if there is
-}
-
 
-
-// Function to check if a box has already been targeted
-bool isAlreadyTargeted(GameBoard *board, int x, int y) {
-    return board->grid[y][x] == WATER_SHOT || board->grid[y][x] == WRECK;
-}
-
-// Function that sequences a game round for the player
-void computerTurn(GameBoard *playerBoard) {
-    int x, y;
-    bool shotValid = false;
-
-    // Continue to generate random coordinates until an untargeted box is found
-    while (!shotValid) {
-        x = rand() % playerBoard->size;
-        y = rand() % playerBoard->size;
-
-        if (!isAlreadyTargeted(playerBoard, x, y)) {
-            shotValid = true;
-            shootAt(playerBoard, x, y);  // Shoot and make the changes
-            printf("Computer shot at (%d, %d).\n", x, y);
-        }
+        // Computer's turn: its shot is ready, or nearly
+        printf("Computer's Turn:\n");
+        finishSpeculation(speculation, &x, &y);
+        ShotResult reply = fireShot(game, 2, x, y);
+        printShotResult(reply, &game->player1Board);
+        printf("Computer shot at (%d, %d).\n", x, y);
+        if (!pushGameHistory(&history, game, 2, x, y, reply)) break;
+
+        gameIsOver = isGameOver(&game->player1Board);
+        renderFrame(renderer, &game->player1Board, &game->player2Board, gameIsOver);
+        if (gameIsOver) announceWinner(false); // Computer wins
+        INSTRUMENT_POLL();
     }
-}
-
 
-bool isGameOver(GameBoard *board) {
-    for (int y = 0; y < board->size; y++) {
-        for (int x = 0; x < board->size; x++) {
-            if (board->grid[y][x] == BOAT) { // If an undamaged boat is found.
-                return false;
-            }
-        }
-    }
-    return true; // All boats have been touched
+    freeSpeculation(speculation);   // Waits for a reply still being chosen
+    freeGameHistory(&history);
+    return EXIT_SUCCESS;
 }
 
-void announceWinner(bool playerWon) {
-    if (playerWon) {
-        printf("You've won, you're a true Amiral !\n");
-    } else {
-        printf("Computer wins. It doesn't matter, sailor\n");
+int main(int argc, char **argv) {
+    bool spectate = false;
+    RenderMode renderMode = isatty(STDOUT_FILENO) ? RENDER_ANSI : RENDER_PLAIN;
+    int renderEvery = 1;
+    const char *bookPath = NULL;
+    uint64_t seed = (uint64_t)time(NULL);
+    // Player 1's strategy only matters when spectating, a human plays it otherwise.
+    GameConfig config = { BOARD_SIZE, BOARD_SIZE, { AI_DENSITY, AI_DENSITY }, NULL, NULL, NULL, NULL };
+    // A move of the montecarlo strategy takes at most 10 ms on every core.
+    MonteCarloConfig monteCarlo = { (int)sysconf(_SC_NPROCESSORS_ONLN), MONTE_CARLO_SAMPLES, 10000 };
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            config.width = config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            config.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spectate") == 0) {
+            spectate = true;
+        } else if (strcmp(argv[i], "--no-render") == 0) {
+            renderMode = RENDER_OFF;
+        } else if (strcmp(argv[i], "--plain") == 0) {
+            renderMode = RENDER_PLAIN;
+        } else if (strcmp(argv[i], "--render-every") == 0 && i + 1 < argc) {
+            renderEvery = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mc-threads") == 0 && i + 1 < argc) {
+            monteCarlo.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mc-samples") == 0 && i + 1 < argc) {
+            monteCarlo.samples = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mc-budget") == 0 && i + 1 < argc) {
+            monteCarlo.budget = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            bookPath = argv[++i];
+        } else if (strcmp(argv[i], "--ai1") == 0 && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &config.strategies[0])) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--ai") == 0 && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &config.strategies[1])) return EXIT_FAILURE;
+        } else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
     }
-}
 
 
-void freeGame(Game *game) {
-    if (game) {
-        // Free the two gameboard
-        freeGameBoard(&game->player1Board);
-        freeGameBoard(&game->player2Board);
+    INSTRUMENT_INSTALL();
 
-        free(game);
+    OpeningBook book = { 0 };
+    if (bookPath) {
+        if (!openOpeningBook(&book, bookPath)) return EXIT_FAILURE;
+        config.book = &book;
     }
-}
-
-int main() {
-    // Initialization of the random number for next
-    srand(time(NULL));
 
     // Create and initialize the game
-    Game *game = initializeGame();
-    if (game == NULL) {
+    Arena arena;
+    Renderer renderer;
+    initializeArena(&arena, 0);
+    if (!spectate) config.strategies[0] = AI_RANDOM;
+    if (config.strategies[0] == AI_MONTE_CARLO || config.strategies[1] == AI_MONTE_CARLO) {
+        config.monteCarlo = createMonteCarlo(&monteCarlo, config.width, config.height);
+    }
+    if (config.strategies[0] == AI_EXACT || config.strategies[1] == AI_EXACT) {
+        config.exact = createExactAnalysis(config.width, config.height);
+    }
+    Game *game = initializeGame(&config, seed, &arena);
+    if (game == NULL || !initializeRenderer(&renderer, renderMode, renderEvery, STDOUT_FILENO)) {
         fprintf(stderr, "Failed to initialize game.\n");
+        freeMonteCarlo(config.monteCarlo);
+        freeExactAnalysis(config.exact);
+        closeOpeningBook(&book);
+        freeArena(&arena);
         return EXIT_FAILURE;
     }
-
-    bool playerTurnFlag = true; // True if it's the player's turn, false for the computer.
-    bool gameIsOver = false;
-
-    // Game's loop
-    while (!gameIsOver) {
-        if (playerTurnFlag) {
-            // Player's turn
-            printf("Player's Turn:\n");
-            playerTurn(&game->player2Board); // The player shoots at the computer board
-            printf("\nYour Board:\n\n");
-            printPlayerView(&game->player1Board);
-            printf("Opponent's Board:\n");
-            printComputerView(&game->player2Board);
-
-        } else {
-            // Computer's turn
-            printf("Computer's Turn:\n");
-            computerTurn(&game->player1Board); // The computer shoots at the player’s board
-            printf("Your Board:\n");
-            printPlayerView(&game->player1Board); // Player(s board)
-            printf("\nOpponent's Board:\n\n");// Computer's view, we can see where we did shoot
-            printComputerView(&game->player2Board);
-
-        }
-
-        // Check if the game is over
-        if (isGameOver(&game->player1Board)) {
-            announceWinner(false); // Computer wins
-            gameIsOver = true;
-        } else if (isGameOver(&game->player2Board)) {
-            announceWinner(true); // Player wins
-            gameIsOver = true;
-        }
-
-        // Change turn
-        playerTurnFlag = !playerTurnFlag;
+    renderFrame(&renderer, &game->player1Board, &game->player2Board, true);
+    printf("Game seed: %llu (replay it with --seed)\n", (unsigned long long)seed);
+
+    if (spectate) {
+        int status = runSpectated(game, &renderer);
+        freeRenderer(&renderer);
+        freeMonteCarlo(config.monteCarlo);
+        freeExactAnalysis(config.exact);
+        closeOpeningBook(&book);
+        freeArena(&arena);
+        return status;
     }
 
+    int status = runInteractive(game, &renderer);
+
     // At the end of the game, release all allocated data.
-    freeGame(game);
+    freeRenderer(&renderer);
+    freeMonteCarlo(config.monteCarlo);
+    freeExactAnalysis(config.exact);
+    closeOpeningBook(&book);
+    freeArena(&arena);
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    return status;
+}
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "targeting.h"
+#include "gameboard.h"
+#include "montecarlo.h"
+#include "exact.h"
+#include "book.h"
+#include "threadpool.h"
+
+// Opening book generator: for every fleet a game may draw, plays the chosen
+// strategy from the empty board and follows both answers (miss or hit) to each
+// of its shots, up to a depth, keeping the shot chosen in every position met.
+// Positions after a boat was sunk are left to the strategy.
+
+#define MAX_DEPTH 16
+
+typedef struct {
+    Arena arena;
+    MonteCarlo *monteCarlo;
+    ExactAnalysis *exact;
+    uint64_t *keys;         // Positions found by this worker
+    int *cells;
+    long count;
+    long capacity;
+    bool failed;
+} BookWorker;
+
+typedef struct {
+    int width;
+    int height;
+    AiStrategy strategy;
+    int depth;
+    uint64_t seed;
+    int fleets[64][MAX_BOATS];  // Boat sizes of every fleet a game may draw
+    int fleetCount;
+    BookWorker *workers;
+} BookJob;
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s --output FILE [--size N | --width W --height H] [--ai STRATEGY]\n"
+                    "          [--depth N] [--threads THREADS] [--seed SEED] [--mc-samples N]\n"
+                    "Strategies: density, montecarlo, exact\n", program);
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Function to list the fleets of MAX_BOATS boats of MIN_BOAT_SIZE to
+// MAX_BOAT_SIZE boxes, sizes in increasing order: the order does not matter
+// to a targeter.
+static void listFleets(BookJob *job, int *sizes, int boat) {
+    if (boat == MAX_BOATS) {
+        memcpy(job->fleets[job->fleetCount++], sizes, sizeof(job->fleets[0]));
+        return;
+    }
+    for (int size = boat > 0 ? sizes[boat - 1] : MIN_BOAT_SIZE; size <= MAX_BOAT_SIZE; size++) {
+        sizes[boat] = size;
+        listFleets(job, sizes, boat + 1);
+    }
+}
+
+static bool addPosition(BookWorker *worker, uint64_t key, int cell) {
+    if (worker->count == worker->capacity) {
+        long capacity = worker->capacity ? 2 * worker->capacity : 1024;
+        uint64_t *keys = (uint64_t*)realloc(worker->keys, capacity * sizeof(uint64_t));
+        if (keys) worker->keys = keys;
+        int *cells = (int*)realloc(worker->cells, capacity * sizeof(int));
+        if (cells) worker->cells = cells;
+        if (keys == NULL || cells == NULL) {
+            fprintf(stderr, "Memory allocation failed for opening book.\n");
+            return false;
+        }
+        worker->capacity = capacity;
+    }
+    worker->keys[worker->count] = key;
+    worker->cells[worker->count++] = cell;
+    return true;
+}
+
+// Function to choose the shot of the position reached by the `depth` shots of
+// `shots` and `results`, then to follow both answers to it. The targeter is
+// rebuilt from the empty board in the worker's arena for every position.
+static bool expandPosition(const BookJob *job, BookWorker *worker, const Boat *fleet,
+                           int *shots, ShotResult *results, int depth) {
+    Targeter targeter;
+    Rng rng;
+    int x, y;
+
+    resetArena(&worker->arena);
+    if (!initializeTargeter(&targeter, job->strategy, job->width, job->height, fleet, MAX_BOATS, &worker->arena)) {
+        return false;
+    }
+    targeter.monteCarlo = worker->monteCarlo;
+    targeter.exact = worker->exact;
+    for (int i = 0; i < depth; i++) {
+        observeShot(&targeter, shots[i] % job->width, shots[i] / job->width, results[i]);
+    }
+
+    // Ties are broken by a stream of the position, so the book does not depend
+    // on the order positions were met in.
+    seedRng(&rng, streamSeed(job->seed, targeter.hash));
+    if (job->strategy == AI_DENSITY) {
+        chooseTargetedShot(&targeter, &rng, &x, &y);
+    } else if (job->strategy == AI_MONTE_CARLO) {
+        chooseMonteCarloShot(worker->monteCarlo, &targeter, &rng, &x, &y);
+    } else {
+        // No fleet agrees with the answers: the position never happens.
+        if (chooseExactShot(worker->exact, &targeter, &rng, &x, &y) && worker->exact->configurations == 0) {
+            return true;
+        }
+    }
+    if (!addPosition(worker, targeter.hash, y * job->width + x)) return false;
+    if (depth == job->depth) return true;
+
+    shots[depth] = y * job->width + x;
+    results[depth] = SHOT_MISS;
+    if (!expandPosition(job, worker, fleet, shots, results, depth + 1)) return false;
+    results[depth] = SHOT_HIT;
+    return expandPosition(job, worker, fleet, shots, results, depth + 1);
+}
+
+static void expandFleets(void *context, int worker, long begin, long end) {
+    const BookJob *job = (const BookJob*)context;
+    BookWorker *mine = &job->workers[worker];
+    int shots[MAX_DEPTH];
+    ShotResult results[MAX_DEPTH];
+
+    for (long i = begin; i < end && !mine->failed; i++) {
+        Boat fleet[MAX_BOATS];
+        for (int b = 0; b < MAX_BOATS; b++) fleet[b] = createBoat(job->fleets[i][b], 0, 0, HORIZONTAL);
+        if (!expandPosition(job, mine, fleet, shots, results, 0)) mine->failed = true;
+    }
+}
+
+int main(int argc, char **argv) {
+    static BookJob job = { .width = BOARD_SIZE, .height = BOARD_SIZE, .strategy = AI_DENSITY, .depth = 6, .seed = 1 };
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    MonteCarloConfig monteCarlo = { 1, MONTE_CARLO_SAMPLES, 0 };
+    const char *output = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            job.width = job.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            job.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            job.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ai") == 0 && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &job.strategy)) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            job.depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            job.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mc-samples") == 0 && i + 1 < argc) {
+            monteCarlo.samples = strtol(argv[++i], NULL, 10);
+        } else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (output == NULL || job.strategy == AI_RANDOM || job.depth < 0 || job.depth >= MAX_DEPTH) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int sizes[MAX_BOATS];
+    listFleets(&job, sizes, 0);
+
+    ThreadPool *pool = createThreadPool(threads);
+    if (pool == NULL) return EXIT_FAILURE;
+    threads = threadPoolSize(pool);
+    job.workers = (BookWorker*)calloc(threads, sizeof(BookWorker));
+    if (job.workers == NULL) {
+        fprintf(stderr, "Memory allocation failed for book workers.\n");
+        freeThreadPool(pool);
+        return EXIT_FAILURE;
+    }
+    bool ok = true;
+    for (int i = 0; i < threads; i++) {
+        BookWorker *worker = &job.workers[i];
+        initializeArena(&worker->arena, 0);
+        if (job.strategy == AI_MONTE_CARLO) {
+            worker->monteCarlo = createMonteCarlo(&monteCarlo, job.width, job.height);
+            if (worker->monteCarlo == NULL) ok = false;
+        } else if (job.strategy == AI_EXACT) {
+            worker->exact = createExactAnalysis(job.width, job.height);
+            if (worker->exact == NULL) ok = false;
+        }
+    }
+
+    double start = nowSeconds();
+    if (ok) runThreadPool(pool, job.fleetCount, 1, expandFleets, &job);
+
+    // Gather the positions of every worker into the file.
+    long count = 0;
+    for (int i = 0; i < threads; i++) {
+        if (job.workers[i].failed) ok = false;
+        count += job.workers[i].count;
+    }
+    uint64_t *keys = (uint64_t*)malloc((count + 1) * sizeof(uint64_t));
+    int *cells = (int*)malloc((count + 1) * sizeof(int));
+    if (keys == NULL || cells == NULL) ok = false;
+    if (ok) {
+        long offset = 0;
+        for (int i = 0; i < threads; i++) {
+            memcpy(keys + offset, job.workers[i].keys, job.workers[i].count * sizeof(uint64_t));
+            memcpy(cells + offset, job.workers[i].cells, job.workers[i].count * sizeof(int));
+            offset += job.workers[i].count;
+        }
+        ok = writeOpeningBook(output, job.width, job.height, job.strategy, keys, cells, count);
+    }
+    if (ok) {
+        printf("%ld positions of %d fleets, %d shots deep, in %.3f s, written to %s\n",
+               count, job.fleetCount, job.depth, nowSeconds() - start, output);
+    }
+
+    free(keys);
+    free(cells);
+    for (int i = 0; i < threads; i++) {
+        freeArena(&job.workers[i].arena);
+        freeMonteCarlo(job.workers[i].monteCarlo);
+        freeExactAnalysis(job.workers[i].exact);
+        free(job.workers[i].keys);
+        free(job.workers[i].cells);
+    }
+    free(job.workers);
+    freeThreadPool(pool);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
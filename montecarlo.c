@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "montecarlo.h"
+#include "threadpool.h"
+#include "bitboard.h"
+#include "kernels.h"
+
+#define MAX_ATTEMPTS 64     // Draws tried for one sample before giving it up
+#define MAX_CANDIDATES (MAX_BOATS * 2 * MAX_BOAT_SIZE)
+
+// A placement covering a given hit: index of its length, orientation, first box.
+typedef struct {
+    int lengthIndex;
+    Orientation orientation;
+    int anchor;
+} Candidate;
+
+// Scratch of one thread, on cache lines of its own.
+typedef struct {
+    _Alignas(64) uint32_t *counts;  // Per box: fleets of the round with a boat there
+    long samples;                   // Fleets drawn in the round
+    uint64_t *forbidden;            // Boxes no further boat may cover
+    uint64_t *uncovered;            // Open hits no drawn boat covers yet
+    uint64_t *slots;                // Legal first boxes, horizontal then vertical
+    Candidate candidates[MAX_CANDIDATES];
+} Worker;
+
+struct MonteCarlo {
+    MonteCarloConfig config;
+    int width;
+    int height;
+    int cells;
+    int words;
+    ThreadPool *pool;
+    int threads;
+    uint64_t *anchors;      // Per length and orientation: boxes a boat may start from
+    const BoardKernels *kernels;    // Mask loops compiled for this size, see kernels.h
+    Worker *workers;
+    uint64_t *totals;       // Per box: fleets of the rounds kept with a boat there
+
+    // Move being chosen
+    const Targeter *targeter;
+    uint64_t moveSeed;
+    long round;
+    uint64_t deadline;      // In ns of CLOCK_MONOTONIC, 0 for none
+    atomic_bool expired;    // The round ran past the deadline and is dropped
+};
+
+static uint64_t nowNanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t *anchorMask(const MonteCarlo *engine, int length, Orientation orientation) {
+    return engine->anchors + ((length - 1) * 2 + (orientation == VERTICAL)) * engine->words;
+}
+
+// Function to create the engine of the boards of `width` x `height`, with its threads.
+MonteCarlo *createMonteCarlo(const MonteCarloConfig *config, int width, int height) {
+    MonteCarlo *engine = (MonteCarlo*)calloc(1, sizeof(MonteCarlo));
+    if (engine == NULL) {
+        fprintf(stderr, "Memory allocation failed for Monte Carlo engine.\n");
+        return NULL;
+    }
+    engine->config = *config;
+    engine->width = width;
+    engine->height = height;
+    engine->cells = width * height;
+    engine->words = bitboardWords(engine->cells);
+    engine->kernels = selectBoardKernels(width, height);
+    engine->pool = createThreadPool(config->threads);
+    if (engine->pool == NULL) {
+        free(engine);
+        return NULL;
+    }
+    engine->threads = threadPoolSize(engine->pool);
+
+    int words = engine->words;
+    size_t countBytes = ((size_t)engine->cells * sizeof(uint32_t) + 63) & ~(size_t)63;
+    size_t maskBytes = ((size_t)4 * words * sizeof(uint64_t) + 63) & ~(size_t)63;
+    engine->anchors = (uint64_t*)calloc(2 * MAX_BOAT_SIZE * words, sizeof(uint64_t));
+    engine->totals = (uint64_t*)calloc(engine->cells, sizeof(uint64_t));
+    engine->workers = (Worker*)aligned_alloc(64, engine->threads * sizeof(Worker));
+    if (engine->anchors == NULL || engine->totals == NULL || engine->workers == NULL) {
+        fprintf(stderr, "Memory allocation failed for Monte Carlo engine.\n");
+        free(engine->workers);
+        engine->workers = NULL;
+        freeMonteCarlo(engine);
+        return NULL;
+    }
+    for (int i = 0; i < engine->threads; i++) {
+        Worker *worker = &engine->workers[i];
+        uint8_t *memory = (uint8_t*)aligned_alloc(64, countBytes + maskBytes);
+        worker->counts = (uint32_t*)memory;
+        if (memory == NULL) {
+            fprintf(stderr, "Memory allocation failed for Monte Carlo engine.\n");
+            engine->threads = i;
+            freeMonteCarlo(engine);
+            return NULL;
+        }
+        worker->forbidden = (uint64_t*)(memory + countBytes);
+        worker->uncovered = worker->forbidden + words;
+        worker->slots = worker->uncovered + words;
+    }
+
+    for (int length = 1; length <= MAX_BOAT_SIZE; length++) {
+        for (int y = 0; y < height && length <= width; y++) {
+            bitRangeSet(anchorMask(engine, length, HORIZONTAL), y * width, width - length + 1);
+        }
+        if (length <= height) {
+            bitRangeSet(anchorMask(engine, length, VERTICAL), 0, (height - length + 1) * width);
+        }
+    }
+    return engine;
+}
+
+void freeMonteCarlo(MonteCarlo *engine) {
+    if (engine) {
+        for (int i = 0; engine->workers && i < engine->threads; i++) free(engine->workers[i].counts);
+        freeThreadPool(engine->pool);
+        free(engine->workers);
+        free(engine->anchors);
+        free(engine->totals);
+        free(engine);
+    }
+}
+
+static int firstBit(const uint64_t *mask, int words) {
+    for (int i = 0; i < words; i++) {
+        if (mask[i]) return i * 64 + __builtin_ctzll(mask[i]);
+    }
+    return -1;
+}
+
+static int boatCell(const MonteCarlo *engine, const Boat *boat, int i) {
+    return boat->orientation == HORIZONTAL ? boat->y * engine->width + boat->x + i
+                                           : (boat->y + i) * engine->width + boat->x;
+}
+
+// Lists the legal placements of the boats left that cover box `hit`.
+static int collectCovering(const MonteCarlo *engine, Worker *worker, const int *left, int hit) {
+    const Targeter *targeter = engine->targeter;
+    int hx = hit % engine->width;
+    int hy = hit / engine->width;
+    int count = 0;
+
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        int length = targeter->lengths[l];
+        if (left[l] == 0) continue;
+
+        for (int k = 0; k < length; k++) {
+            if (hx - k >= 0 && hx - k + length <= engine->width) {
+                int anchor = hy * engine->width + hx - k;
+                if (!bitRangeAny(worker->forbidden, anchor, length)) {
+                    worker->candidates[count++] = (Candidate){ l, HORIZONTAL, anchor };
+                }
+            }
+            if (hy - k >= 0 && hy - k + length <= engine->height) {
+                int anchor = (hy - k) * engine->width + hx;
+                bool legal = true;
+                for (int i = 0; i < length && legal; i++) legal = !bitTest(worker->forbidden, anchor + i * engine->width);
+                if (legal) worker->candidates[count++] = (Candidate){ l, VERTICAL, anchor };
+            }
+        }
+    }
+    return count;
+}
+
+static int kthBit(const uint64_t *mask, uint32_t k) {
+    for (int i = 0; ; i++) {
+        uint32_t bits = (uint32_t)__builtin_popcountll(mask[i]);
+        if (k < bits) {
+            uint64_t word = mask[i];
+            while (k--) word &= word - 1;
+            return i * 64 + __builtin_ctzll(word);
+        }
+        k -= bits;
+    }
+}
+
+// Draws one fleet of the boats not sunk yet that agrees with the shots, and
+// counts the untargeted boxes it covers. The boats covering the open hits
+// are drawn first, then the others longest first. Returns false on a dead end.
+static bool drawFleet(const MonteCarlo *engine, Worker *worker, Rng *rng) {
+    const Targeter *targeter = engine->targeter;
+    int words = engine->words;
+    int left[MAX_BOATS];
+    Boat fleet[MAX_BOATS];
+    int boats = 0;
+    int placed = 0;
+
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        left[l] = targeter->boatsOfLength[l];
+        boats += left[l];
+        if (left[l] > 0 && targeter->lengths[l] > MAX_BOAT_SIZE) return false;
+    }
+    for (int i = 0; i < words; i++) {
+        worker->forbidden[i] = targeter->misses[i] | targeter->sunkZone[i];
+        worker->uncovered[i] = targeter->openHits[i];
+    }
+
+    while (placed < boats) {
+        int l, anchor;
+        Orientation orientation;
+        int hit = firstBit(worker->uncovered, words);
+
+        if (hit >= 0) {
+            int count = collectCovering(engine, worker, left, hit);
+            if (count == 0) return false;
+            Candidate candidate = worker->candidates[randomBelow(rng, count)];
+            l = candidate.lengthIndex;
+            orientation = candidate.orientation;
+            anchor = candidate.anchor;
+        } else {
+            l = -1;
+            for (int i = 0; i < targeter->lengthCount; i++) {
+                if (left[i] > 0 && (l < 0 || targeter->lengths[i] > targeter->lengths[l])) l = i;
+            }
+            int legal = engine->kernels->collectSlots(engine->anchors, worker->forbidden, targeter->lengths[l],
+                                                      worker->slots, engine->width, words);
+            if (legal == 0) return false;
+            int slot = kthBit(worker->slots, randomBelow(rng, legal));
+            orientation = slot < words * 64 ? HORIZONTAL : VERTICAL;
+            anchor = slot % (words * 64);
+        }
+
+        Boat boat = createBoat(targeter->lengths[l], anchor % engine->width, anchor / engine->width, orientation);
+        int hitCells = 0;
+        for (int i = 0; i < boat.size; i++) {
+            int cell = boatCell(engine, &boat, i);
+            hitCells += bitTest(targeter->openHits, cell);
+            bitClear(worker->uncovered, cell);
+        }
+        if (hitCells == boat.size) return false; // It would have been announced sunk
+        engine->kernels->forbidAround(worker->forbidden, engine->width, engine->height, boat.x, boat.y,
+                                      boat.orientation == HORIZONTAL ? boat.size : 1,
+                                      boat.orientation == VERTICAL ? boat.size : 1);
+        fleet[placed++] = boat;
+        left[l]--;
+    }
+    if (firstBit(worker->uncovered, words) >= 0) return false;
+
+    for (int b = 0; b < placed; b++) {
+        for (int i = 0; i < fleet[b].size; i++) {
+            int cell = boatCell(engine, &fleet[b], i);
+            if (!bitTest(targeter->openHits, cell)) worker->counts[cell]++;
+        }
+    }
+    return true;
+}
+
+static void drawChunks(void *context, int index, long begin, long end) {
+    MonteCarlo *engine = (MonteCarlo*)context;
+    Worker *worker = &engine->workers[index];
+    Rng rng;
+
+    for (long chunk = begin; chunk < end; chunk++) {
+        seedRng(&rng, streamSeed(engine->moveSeed, (uint64_t)(engine->round * MONTE_CARLO_ROUND_CHUNKS + chunk)));
+        for (int s = 0; s < MONTE_CARLO_CHUNK_SAMPLES; s++) {
+            // The first round always completes, later ones stop at the deadline.
+            if (engine->round > 0 && engine->deadline != 0) {
+                if (atomic_load_explicit(&engine->expired, memory_order_relaxed)) return;
+                if (nowNanoseconds() >= engine->deadline) {
+                    atomic_store_explicit(&engine->expired, true, memory_order_relaxed);
+                    return;
+                }
+            }
+            for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+                if (drawFleet(engine, worker, &rng)) {
+                    worker->samples++;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Function to pick the computer's shot from sampled fleets. Returns the
+// number of fleets the choice is based on; with none, any box not targeted
+// yet may be picked.
+long chooseMonteCarloShot(MonteCarlo *engine, const Targeter *targeter, Rng *rng, int *x, int *y) {
+    long perRound = MONTE_CARLO_ROUND_CHUNKS * MONTE_CARLO_CHUNK_SAMPLES;
+    long rounds = engine->config.samples > perRound ? (engine->config.samples + perRound - 1) / perRound : 1;
+    long samples = 0;
+
+    engine->targeter = targeter;
+    engine->moveSeed = nextRandom(rng);
+    engine->deadline = engine->config.budget > 0 ? nowNanoseconds() + (uint64_t)engine->config.budget * 1000 : 0;
+    memset(engine->totals, 0, engine->cells * sizeof(uint64_t));
+
+    for (engine->round = 0; engine->round < rounds; engine->round++) {
+        atomic_store_explicit(&engine->expired, false, memory_order_relaxed);
+        for (int i = 0; i < engine->threads; i++) {
+            memset(engine->workers[i].counts, 0, engine->cells * sizeof(uint32_t));
+            engine->workers[i].samples = 0;
+        }
+        runThreadPool(engine->pool, MONTE_CARLO_ROUND_CHUNKS, 1, drawChunks, engine);
+        if (atomic_load_explicit(&engine->expired, memory_order_relaxed)) break;
+
+        for (int i = 0; i < engine->threads; i++) {
+            const uint32_t *counts = engine->workers[i].counts;
+            for (int cell = 0; cell < engine->cells; cell++) engine->totals[cell] += counts[cell];
+            samples += engine->workers[i].samples;
+        }
+        if (engine->deadline != 0 && nowNanoseconds() >= engine->deadline) break;
+    }
+
+    // Best box not targeted yet; the boxes around sunk boats are water anyway.
+    uint64_t best = 0;
+    uint32_t ties = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t k = pass == 0 ? 0 : randomBelow(rng, ties);
+        for (int cell = 0; cell < engine->cells; cell++) {
+            if (bitTest(targeter->misses, cell) || bitTest(targeter->openHits, cell)
+                || bitTest(targeter->sunkZone, cell)) {
+                continue;
+            }
+            if (pass == 0) {
+                if (ties == 0 || engine->totals[cell] > best) {
+                    best = engine->totals[cell];
+                    ties = 0;
+                }
+                ties += engine->totals[cell] == best;
+            } else if (engine->totals[cell] == best && k-- == 0) {
+                *x = cell % engine->width;
+                *y = cell / engine->width;
+                return samples;
+            }
+        }
+        if (ties == 0) break;
+    }
+    *x = *y = 0; // Every box was targeted
+    return samples;
+}
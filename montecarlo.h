@@ -0,0 +1,34 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "targeting.h"
+
+// Engine of AI_MONTE_CARLO. For every move it draws whole fleets that agree
+// with the shots seen so far under the rules of canPlaceBoat (no overlap, no
+// contact, diagonals included): every open hit covered, no boat on a miss or
+// next to a sunk boat, and no boat entirely hit since it would have sunk. The
+// box holding a boat in the most fleets is shot, ties broken at random.
+//
+// Fleets are drawn in rounds of MONTE_CARLO_ROUND_CHUNKS chunks spread over
+// the engine's threads. Chunk c of a move gets its own random stream from the
+// move seed, so the counts of a round do not depend on which thread drew it.
+// A round cut short by the time budget is dropped whole: the choice only
+// depends on the seed and on how many whole rounds fit, the first one always
+// being kept. Without a budget it is the same for any thread count.
+#define MONTE_CARLO_CHUNK_SAMPLES 16
+#define MONTE_CARLO_ROUND_CHUNKS 16
+#define MONTE_CARLO_SAMPLES 2048    // Default fleets per move
+
+typedef struct {
+    int threads;        // Threads drawing fleets, the caller included
+    long samples;       // Fleets drawn per move at most, rounded up to whole rounds
+    long budget;        // Time limit of a move in microseconds, 0 for none
+} MonteCarloConfig;
+
+MonteCarlo *createMonteCarlo(const MonteCarloConfig *config, int width, int height);
+void freeMonteCarlo(MonteCarlo *engine);
+long chooseMonteCarloShot(MonteCarlo *engine, const Targeter *targeter, Rng *rng, int *x, int *y);
+
+#endif // MONTECARLO_H
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "placement.h"
+#include "bitboard.h"
+#include "kernels.h"
+#include "instrument.h"
+
+// Anchor mask of the boats of `length` lying along `orientation`.
+static uint64_t *anchorMask(const FleetPlacer *placer, int length, Orientation orientation) {
+    return placer->anchors + ((length - 1) * 2 + (orientation == VERTICAL)) * placer->words;
+}
+
+bool initializeFleetPlacer(FleetPlacer *placer, int width, int height, int maxBoats, int maxLength, Arena *arena) {
+    memset(placer, 0, sizeof(FleetPlacer));
+    placer->width = width;
+    placer->height = height;
+    placer->maxBoats = maxBoats;
+    placer->maxLength = maxLength;
+    placer->words = bitboardWords(width * height);
+    placer->kernels = selectBoardKernels(width, height);
+
+    placer->anchors = (uint64_t*)arenaCalloc(arena, 2 * maxLength * placer->words, sizeof(uint64_t));
+    placer->forbidden = (uint64_t*)arenaAlloc(arena, (maxBoats + 1) * placer->words * sizeof(uint64_t));
+    placer->candidates = (uint64_t*)arenaAlloc(arena, maxBoats * 2 * placer->words * sizeof(uint64_t));
+    placer->order = (int*)arenaAlloc(arena, maxBoats * sizeof(int));
+    if (!placer->anchors || !placer->forbidden || !placer->candidates || !placer->order) {
+        fprintf(stderr, "Memory allocation failed for fleet placer.\n");
+        return false;
+    }
+
+    // A boat of length L fits from any x up to width - L (resp. y up to height - L).
+    for (int length = 1; length <= maxLength; length++) {
+        uint64_t *horizontal = anchorMask(placer, length, HORIZONTAL);
+        uint64_t *vertical = anchorMask(placer, length, VERTICAL);
+
+        for (int y = 0; y < height && length <= width; y++) {
+            bitRangeSet(horizontal, y * width, width - length + 1);
+        }
+        if (length <= height) {
+            bitRangeSet(vertical, 0, (height - length + 1) * width);
+        }
+    }
+    return true;
+}
+
+// Removes and returns the k-th slot of the set.
+static int takeSlot(uint64_t *slots, uint32_t k) {
+    for (int i = 0; ; i++) {
+        uint32_t bits = (uint32_t)__builtin_popcountll(slots[i]);
+        if (k < bits) {
+            uint64_t word = slots[i];
+            while (k--) word &= word - 1;
+            int bit = __builtin_ctzll(word);
+            slots[i] &= ~((uint64_t)1 << bit);
+            return i * 64 + bit;
+        }
+        k -= bits;
+    }
+}
+
+static bool placeFrom(FleetPlacer *placer, Boat *boats, int count, int depth, Rng *rng) {
+    if (depth == count) return true;
+
+    Boat *boat = &boats[placer->order[depth]];
+    uint64_t *forbidden = placer->forbidden + depth * placer->words;
+    uint64_t *next = forbidden + placer->words;
+    uint64_t *slots = placer->candidates + depth * 2 * placer->words;
+    int legal = placer->kernels->collectSlots(placer->anchors, forbidden, boat->size, slots, placer->width, placer->words);
+
+    // Try the legal slots in random order until the rest of the fleet fits.
+    while (legal > 0) {
+        int slot = takeSlot(slots, randomBelow(rng, legal--));
+        int cell = slot % (placer->words * 64);
+
+        boat->orientation = slot < placer->words * 64 ? HORIZONTAL : VERTICAL;
+        boat->x = cell % placer->width;
+        boat->y = cell / placer->width;
+
+        memcpy(next, forbidden, placer->words * sizeof(uint64_t));
+        placer->kernels->forbidAround(next, placer->width, placer->height, boat->x, boat->y,
+                                      boat->orientation == HORIZONTAL ? boat->size : 1,
+                                      boat->orientation == VERTICAL ? boat->size : 1);
+        if (placeFrom(placer, boats, count, depth + 1, rng)) return true;
+        INSTRUMENT_COUNT(COUNT_PLACEMENT_RETRIES, 1);
+    }
+    return false;
+}
+
+// Function to place `count` boats on the board at once. Boat sizes are read from
+// the array and their positions written back. The board is left untouched when
+// the fleet cannot fit, or when the board refuses one of the boats.
+bool placeFleet(FleetPlacer *placer, GameBoard *board, Boat *boats, int count, Rng *rng) {
+    if (!placer || !board || !boats || board->width != placer->width || board->height != placer->height || count > placer->maxBoats) {
+        return false;
+    }
+    if (board->fleetSize + count > MAX_FLEET) return false;
+    for (int i = 0; i < count; i++) {
+        if (boats[i].size < 1 || boats[i].size > placer->maxLength) return false;
+    }
+
+    // Whatever is already on the board is forbidden as well: boats with their
+    // surroundings, and the cells already shot.
+    uint64_t *forbidden = placer->forbidden;
+    memcpy(forbidden, board->shots, placer->words * sizeof(uint64_t));
+    for (int i = 0; i < placer->words; i++) {
+        for (uint64_t bits = board->boats[i]; bits; bits &= bits - 1) {
+            int cell = i * 64 + __builtin_ctzll(bits);
+            placer->kernels->forbidAround(forbidden, placer->width, placer->height,
+                                          cell % board->width, cell / board->width, 1, 1);
+        }
+    }
+
+    // Longest boats first: they have the fewest slots, so dead ends show up early.
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        while (j > 0 && boats[placer->order[j - 1]].size < boats[i].size) {
+            placer->order[j] = placer->order[j - 1];
+            j--;
+        }
+        placer->order[j] = i;
+    }
+
+    if (!placeFrom(placer, boats, count, 0, rng)) return false;
+    for (int i = 0; i < count; i++) {
+        if (!setBoatOnBoard(board, &boats[i])) {
+            // The placer and the board disagree: take back the boats set so far.
+            fprintf(stderr, "The placed fleet does not fit on the board.\n");
+            while (--i >= 0) removeBoatFromBoard(board, &boats[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Set of the placements of `length` lying along `orientation`: its conflicts
+// and its legal mask start at set * cells and set * words.
+static int placementSet(int length, Orientation orientation) {
+    return (length - 1) * 2 + (orientation == VERTICAL);
+}
+
+// Function to index the legal placements of boats up to `maxLength` on
+// `board`, from the boats and the shots already there, and to attach the
+// index to the board so that its changes keep the index up to date.
+bool attachPlacementIndex(PlacementIndex *index, GameBoard *board, int maxLength, Arena *arena) {
+    memset(index, 0, sizeof(PlacementIndex));
+    if (maxLength < 1 || maxLength > PLACEMENT_INDEX_MAX_LENGTH) {
+        fprintf(stderr, "Invalid placement index for boats of length %d.\n", maxLength);
+        return false;
+    }
+    index->width = board->width;
+    index->height = board->height;
+    index->cells = board->cellCount;
+    index->words = board->words;
+    index->maxLength = maxLength;
+
+    index->blocked = (uint8_t*)arenaCalloc(arena, index->cells, 1);
+    index->conflicts = (uint8_t*)arenaCalloc(arena, (size_t)2 * maxLength * index->cells, 1);
+    index->legal = (uint64_t*)arenaCalloc(arena, (size_t)2 * maxLength * index->words, sizeof(uint64_t));
+    index->legalCounts = (int*)arenaCalloc(arena, 2 * maxLength, sizeof(int));
+    if (!index->blocked || !index->conflicts || !index->legal || !index->legalCounts) {
+        fprintf(stderr, "Memory allocation failed for placement index.\n");
+        return false;
+    }
+
+    // Nothing blocked yet: every placement that stays on the board is legal.
+    for (int length = 1; length <= maxLength; length++) {
+        uint64_t *horizontal = index->legal + placementSet(length, HORIZONTAL) * index->words;
+        uint64_t *vertical = index->legal + placementSet(length, VERTICAL) * index->words;
+
+        for (int y = 0; y < index->height && length <= index->width; y++) {
+            bitRangeSet(horizontal, y * index->width, index->width - length + 1);
+        }
+        if (length <= index->height) {
+            bitRangeSet(vertical, 0, (index->height - length + 1) * index->width);
+        }
+        index->legalCounts[placementSet(length, HORIZONTAL)] = bitCount(horizontal, index->words);
+        index->legalCounts[placementSet(length, VERTICAL)] = bitCount(vertical, index->words);
+    }
+
+    for (int i = 0; i < board->fleetSize; i++) {
+        const Boat *boat = board->fleet[i];
+        updatePlacementIndex(index, boat->x, boat->y,
+                             boat->orientation == HORIZONTAL ? boat->size : 1,
+                             boat->orientation == VERTICAL ? boat->size : 1, 1);
+    }
+    for (int i = 0; i < index->words; i++) {
+        for (uint64_t bits = board->shots[i]; bits; bits &= bits - 1) {
+            int cell = i * 64 + __builtin_ctzll(bits);
+            updatePlacementIndex(index, cell % index->width, cell / index->width, 1, 1, 1);
+        }
+    }
+    board->placements = index;
+    return true;
+}
+
+// Function to count one more (delta > 0) or one less blocked cell under
+// every placement through `cell`.
+static void recountPlacements(PlacementIndex *index, int cell, int delta) {
+    int x = cell % index->width;
+    int y = cell / index->width;
+
+    for (int length = 1; length <= index->maxLength; length++) {
+        for (int o = 0; o < 2; o++) {
+            int set = placementSet(length, o == 0 ? HORIZONTAL : VERTICAL);
+            uint8_t *conflicts = index->conflicts + (size_t)set * index->cells;
+            uint64_t *legal = index->legal + (size_t)set * index->words;
+
+            // The placements through the cell start up to length - 1 cells before it.
+            for (int k = 0; k < length; k++) {
+                int ax = o == 0 ? x - k : x;
+                int ay = o == 0 ? y : y - k;
+                if (ax < 0 || ay < 0) break;
+                if (o == 0 ? ax + length > index->width : ay + length > index->height) continue;
+
+                int anchor = ay * index->width + ax;
+                if (delta > 0) {
+                    if (conflicts[anchor]++ == 0) {
+                        bitClear(legal, anchor);
+                        index->legalCounts[set]--;
+                    }
+                } else if (--conflicts[anchor] == 0) {
+                    bitSet(legal, anchor);
+                    index->legalCounts[set]++;
+                }
+            }
+        }
+    }
+}
+
+// Function to block (delta > 0) or unblock the box of width x height cells at
+// (left, top) grown by one cell on every side: the surroundings of a boat set
+// or removed, or of a shot taken.
+void updatePlacementIndex(PlacementIndex *index, int left, int top, int width, int height, int delta) {
+    int x0 = left > 0 ? left - 1 : 0;
+    int x1 = left + width < index->width ? left + width : index->width - 1;
+    int y0 = top > 0 ? top - 1 : 0;
+    int y1 = top + height < index->height ? top + height : index->height - 1;
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            int cell = y * index->width + x;
+            // Only the cells that become blocked or free change the placements.
+            if (delta > 0 ? index->blocked[cell]++ == 0 : --index->blocked[cell] == 0) {
+                recountPlacements(index, cell, delta);
+            }
+        }
+    }
+}
+
+// Function to check a placement in constant time. Placements leaving the
+// board, or of boats longer than the index covers, are not legal.
+bool isPlacementLegal(const PlacementIndex *index, int length, Orientation orientation, int x, int y) {
+    if (length < 1 || length > index->maxLength || x < 0 || y < 0 || x >= index->width || y >= index->height) {
+        return false;
+    }
+    return bitTest(index->legal + placementSet(length, orientation) * index->words, y * index->width + x);
+}
+
+// Number of the legal placements of a boat of `length`, both orientations.
+int countLegalPlacements(const PlacementIndex *index, int length) {
+    if (length < 1 || length > index->maxLength) return 0;
+    return index->legalCounts[placementSet(length, HORIZONTAL)] + index->legalCounts[placementSet(length, VERTICAL)];
+}
+
+// Function to write the n-th legal placement of a boat of `length` to the
+// position of `boat`, the horizontal ones coming first in cell order.
+bool findLegalPlacement(const PlacementIndex *index, int length, int n, Boat *boat) {
+    if (n < 0 || n >= countLegalPlacements(index, length)) return false;
+
+    Orientation orientation = HORIZONTAL;
+    if (n >= index->legalCounts[placementSet(length, HORIZONTAL)]) {
+        n -= index->legalCounts[placementSet(length, HORIZONTAL)];
+        orientation = VERTICAL;
+    }
+    const uint64_t *legal = index->legal + placementSet(length, orientation) * index->words;
+    for (int i = 0; ; i++) {
+        int bits = __builtin_popcountll(legal[i]);
+        if (n < bits) {
+            uint64_t word = legal[i];
+            while (n--) word &= word - 1;
+            int cell = i * 64 + __builtin_ctzll(word);
+            boat->x = cell % index->width;
+            boat->y = cell / index->width;
+            boat->orientation = orientation;
+            return true;
+        }
+        n -= bits;
+    }
+}
+
+// Function to list the legal placements of a boat of `length`, at most
+// `capacity` of them, in the order of findLegalPlacement. Only the set bits
+// of the masks are visited. Returns the number written.
+int listLegalPlacements(const PlacementIndex *index, int length, Boat *placements, int capacity) {
+    int count = 0;
+
+    if (length < 1 || length > index->maxLength) return 0;
+    for (int o = 0; o < 2; o++) {
+        Orientation orientation = o == 0 ? HORIZONTAL : VERTICAL;
+        const uint64_t *legal = index->legal + placementSet(length, orientation) * index->words;
+        for (int i = 0; i < index->words; i++) {
+            for (uint64_t bits = legal[i]; bits; bits &= bits - 1) {
+                if (count == capacity) return count;
+                int cell = i * 64 + __builtin_ctzll(bits);
+                placements[count++] = createBoat(length, cell % index->width, cell / index->width, orientation);
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,65 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "boat.h"
+#include "rng.h"
+#include "arena.h"
+
+// Places a whole fleet at once. A "forbidden" mask holds every cell that a new
+// boat may not cover (the boats already placed and the boxes around them); it
+// grows incrementally with each boat. The slots (x, y, orientation) of a boat
+// are kept as two masks of first cells, one per orientation: the precomputed
+// anchors that keep a boat of that size on the board, minus the anchors whose
+// cells meet the forbidden mask, found with one shift per cell of the boat.
+// Each boat is drawn uniformly among its legal slots and the placer backtracks
+// when the remaining boats no longer fit, so any feasible fleet is placed.
+typedef struct {
+    int width;              // Board dimensions the placer was built for
+    int height;
+    int words;              // Words of a board mask
+    int maxBoats;
+    int maxLength;          // Longest boat the placer accepts
+    uint64_t *anchors;      // Per length and orientation, the first cells that stay on the board
+    uint64_t *forbidden;    // One mask per depth of the search, maxBoats + 1 of them
+    uint64_t *candidates;   // Legal slots per depth: horizontal mask then vertical mask
+    int *order;             // Boats sorted by decreasing size
+    const BoardKernels *kernels;    // Mask loops compiled for this size, see kernels.h
+} FleetPlacer;
+
+// Index of the legal placements of a board, for the boards that test or list
+// them over and over (placing boats one at a time, validating a placement at
+// every move of a cursor). A cell is blocked by each boat whose surroundings
+// cover it, and by each shot next to it or on it; a placement (length,
+// orientation, first cell) counts the blocked cells under its boat, and is
+// legal when it stays on the board and that count is zero. Attached to a
+// board, the index is kept up to date by setBoatOnBoard, removeBoatFromBoard
+// and shootAt: a change only recounts the placements through the cells whose
+// blocked count moves between zero and one, so it costs in proportion to the
+// area around the boat. A legality test is then one bit, and listing the
+// legal placements a scan of their masks.
+#define PLACEMENT_INDEX_MAX_LENGTH UINT8_MAX   // Longest boat indexed, so that its conflicts fit in a byte
+
+struct PlacementIndex {
+    int width;
+    int height;
+    int cells;
+    int words;              // Words of a board mask
+    int maxLength;          // Longest boat indexed
+    uint8_t *blocked;       // Per cell: boats and shots blocking it
+    uint8_t *conflicts;     // Per length, orientation and first cell: blocked cells under the boat
+    uint64_t *legal;        // Per length and orientation: first cells of the legal placements
+    int *legalCounts;       // Per length and orientation: legal placements
+};
+
+bool initializeFleetPlacer(FleetPlacer *placer, int width, int height, int maxBoats, int maxLength, Arena *arena);
+bool placeFleet(FleetPlacer *placer, GameBoard *board, Boat *boats, int count, Rng *rng);
+bool attachPlacementIndex(PlacementIndex *index, GameBoard *board, int maxLength, Arena *arena);
+void updatePlacementIndex(PlacementIndex *index, int left, int top, int width, int height, int delta);
+bool isPlacementLegal(const PlacementIndex *index, int length, Orientation orientation, int x, int y);
+int countLegalPlacements(const PlacementIndex *index, int length);
+bool findLegalPlacement(const PlacementIndex *index, int length, int n, Boat *boat);
+int listLegalPlacements(const PlacementIndex *index, int length, Boat *placements, int capacity);
+
+#endif // PLACEMENT_H
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "record.h"
+
+// Writes all of `length` bytes, retrying after short writes.
+static bool writeAll(int fd, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+bool openRecordFile(RecordFile *file, const char *path) {
+    uint8_t header[RECORD_FILE_HEADER_SIZE] = { 0 };
+
+    file->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0) {
+        fprintf(stderr, "Cannot open record file %s.\n", path);
+        return false;
+    }
+    memcpy(header, RECORD_MAGIC, 4);
+    putLe16(header + 4, RECORD_VERSION);
+    putLe16(header + 6, RECORD_FILE_HEADER_SIZE);
+    if (!writeAll(file->fd, header, sizeof(header))) {
+        close(file->fd);
+        return false;
+    }
+    pthread_mutex_init(&file->lock, NULL);
+    return true;
+}
+
+bool closeRecordFile(RecordFile *file) {
+    pthread_mutex_destroy(&file->lock);
+    if (close(file->fd) < 0) {
+        perror("close");
+        return false;
+    }
+    return true;
+}
+
+bool initializeRecordWriter(RecordWriter *writer, RecordFile *file) {
+    memset(writer, 0, sizeof(RecordWriter));
+    writer->file = file;
+    writer->capacity = RECORD_BUFFER_SIZE;
+    writer->data = (uint8_t*)malloc(writer->capacity);
+    if (writer->data == NULL) {
+        fprintf(stderr, "Memory allocation failed for record writer.\n");
+        return false;
+    }
+    return true;
+}
+
+// Makes room for `extra` more bytes; a game larger than the buffer grows it.
+static bool reserveRecord(RecordWriter *writer, size_t extra) {
+    if (writer->length + extra <= writer->capacity) return true;
+
+    size_t capacity = writer->capacity * 2;
+    while (capacity < writer->length + extra) capacity *= 2;
+    uint8_t *data = (uint8_t*)realloc(writer->data, capacity);
+    if (data == NULL) {
+        fprintf(stderr, "Memory allocation failed for record writer.\n");
+        return false;
+    }
+    writer->data = data;
+    writer->capacity = capacity;
+    return true;
+}
+
+// Function to start the record of a game once its fleets are placed.
+// Returns false, with nothing written, when the buffer cannot grow: the game
+// must then be played without recording it.
+bool beginGameRecord(RecordWriter *writer, const Game *game) {
+    const Boat *fleets[2] = { game->player1Boats, game->player2Boats };
+    size_t size = RECORD_HEADER_SIZE + 2 * MAX_BOATS * RECORD_BOAT_SIZE;
+
+    writer->recordStart = writer->length;
+    writer->shots = 0;
+    if (!reserveRecord(writer, size)) return false;
+
+    uint8_t *out = writer->data + writer->length;
+    memset(out, 0, RECORD_HEADER_SIZE);
+    putLe64(out + 4, game->seed);
+    putLe16(out + 12, (uint16_t)game->player1Board.width);
+    putLe16(out + 14, (uint16_t)game->player1Board.height);
+    out[16] = (uint8_t)game->player1Targeting.strategy;
+    out[17] = (uint8_t)game->player2Targeting.strategy;
+    out[19] = MAX_BOATS;
+    out[20] = MAX_BOATS;
+    out += RECORD_HEADER_SIZE;
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i < MAX_BOATS; i++) {
+            putLe32(out, packBoat(&fleets[player][i]));
+            out += RECORD_BOAT_SIZE;
+        }
+    }
+    writer->length += size;
+    return true;
+}
+
+// Function to append a shot of `player` (1 or 2) to the record being written.
+// Shots that changed nothing are left out. Returns false when the buffer
+// cannot grow: the record then misses a shot and must be aborted.
+bool recordShot(RecordWriter *writer, int player, int x, int y, ShotResult result) {
+    if (result != SHOT_MISS && result != SHOT_HIT && result != SHOT_SUNK) return true;
+    if (!reserveRecord(writer, RECORD_SHOT_SIZE)) return false;
+
+    int width = readLe16(writer->data + writer->recordStart + 12);
+    uint32_t packed = (uint32_t)(y * width + x) | (uint32_t)result << 20 | (uint32_t)(player == 2) << 23;
+    putLe24(writer->data + writer->length, packed);
+    writer->length += RECORD_SHOT_SIZE;
+    writer->shots++;
+    return true;
+}
+
+// Function to close the record being written, and to send the buffer to the
+// file once it is full enough.
+bool endGameRecord(RecordWriter *writer, int winner) {
+    uint8_t *record = writer->data + writer->recordStart;
+
+    putLe32(record, (uint32_t)(writer->length - writer->recordStart));
+    record[18] = (uint8_t)winner;
+    putLe32(record + 24, writer->shots);
+    if (writer->length >= RECORD_BUFFER_SIZE) return flushRecordWriter(writer);
+    return true;
+}
+
+// Function to drop the record being written, for a game that could not be
+// finished, so that no record with its length still unset reaches the file.
+void abortGameRecord(RecordWriter *writer) {
+    writer->length = writer->recordStart;
+    writer->shots = 0;
+}
+
+bool flushRecordWriter(RecordWriter *writer) {
+    if (writer->length == 0) return true;
+
+    pthread_mutex_lock(&writer->file->lock);
+    bool ok = writeAll(writer->file->fd, writer->data, writer->length);
+    pthread_mutex_unlock(&writer->file->lock);
+    writer->length = 0;
+    writer->recordStart = 0;
+    return ok;
+}
+
+void freeRecordWriter(RecordWriter *writer) {
+    if (writer) {
+        free(writer->data);
+        writer->data = NULL;
+    }
+}
+
+bool openRecordReader(RecordReader *reader, const char *path) {
+    struct stat status;
+
+    memset(reader, 0, sizeof(RecordReader));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &status) < 0) {
+        fprintf(stderr, "Cannot open record file %s.\n", path);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    if ((size_t)status.st_size < RECORD_FILE_HEADER_SIZE) {
+        fprintf(stderr, "%s is not a record file.\n", path);
+        close(fd);
+        return false;
+    }
+
+    // The mapping outlives the descriptor.
+    void *data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    madvise(data, status.st_size, MADV_SEQUENTIAL);
+    reader->data = (const uint8_t*)data;
+    reader->size = status.st_size;
+
+    if (memcmp(reader->data, RECORD_MAGIC, 4) != 0 || readLe16(reader->data + 4) != RECORD_VERSION) {
+        fprintf(stderr, "%s is not a record file of version %d.\n", path, RECORD_VERSION);
+        closeRecordReader(reader);
+        return false;
+    }
+    reader->offset = readLe16(reader->data + 6);
+    return true;
+}
+
+void closeRecordReader(RecordReader *reader) {
+    if (reader && reader->data) {
+        munmap((void*)reader->data, reader->size);
+        reader->data = NULL;
+    }
+}
+
+// Function to decode the next record without copying its boats and shots.
+// Returns false at the end of the file, or on a truncated or corrupt record.
+bool nextGameRecord(RecordReader *reader, GameRecord *record) {
+    if (reader->offset + RECORD_HEADER_SIZE > reader->size) {
+        if (reader->offset != reader->size) fprintf(stderr, "Truncated record at offset %zu.\n", reader->offset);
+        return false;
+    }
+
+    const uint8_t *in = reader->data + reader->offset;
+    uint32_t length = readLe32(in);
+    record->seed = readLe64(in + 4);
+    record->width = readLe16(in + 12);
+    record->height = readLe16(in + 14);
+    record->strategies[0] = (AiStrategy)in[16];
+    record->strategies[1] = (AiStrategy)in[17];
+    record->winner = in[18];
+    record->boatCounts[0] = in[19];
+    record->boatCounts[1] = in[20];
+    record->shotCount = readLe32(in + 24);
+    record->boats[0] = in + RECORD_HEADER_SIZE;
+    record->boats[1] = record->boats[0] + record->boatCounts[0] * RECORD_BOAT_SIZE;
+    record->shots = record->boats[1] + record->boatCounts[1] * RECORD_BOAT_SIZE;
+
+    size_t expected = RECORD_HEADER_SIZE + (size_t)(record->boatCounts[0] + record->boatCounts[1]) * RECORD_BOAT_SIZE
+        + (size_t)record->shotCount * RECORD_SHOT_SIZE;
+    if (length != expected) {
+        fprintf(stderr, "Corrupt record at offset %zu.\n", reader->offset);
+        return false;
+    }
+    if (reader->offset + length > reader->size) {
+        fprintf(stderr, "Truncated record at offset %zu.\n", reader->offset);
+        return false;
+    }
+    reader->offset += length;
+    return true;
+}
+
+// Function to rebuild a recorded game in `arena` by setting its fleets and
+// firing its shots again, without any AI. Every shot must give the recorded
+// result, which makes it a regression check of the board rules as well.
+// Returns NULL when the record does not replay.
+Game *replayGameRecord(const GameRecord *record, Arena *arena) {
+    Game *game = (Game*)arenaCalloc(arena, 1, sizeof(Game));
+    if (game == NULL) return NULL;
+    if (record->boatCounts[0] > MAX_BOATS || record->boatCounts[1] > MAX_BOATS) {
+        fprintf(stderr, "Record of seed %llu has too many boats.\n", (unsigned long long)record->seed);
+        return NULL;
+    }
+
+    game->seed = record->seed;
+    game->arena = arena;
+    seedRng(&game->rng, record->seed);
+    game->player1Targeting.strategy = record->strategies[0];
+    game->player2Targeting.strategy = record->strategies[1];
+    GameBoard *boards[2] = { &game->player1Board, &game->player2Board };
+    Boat *fleets[2] = { game->player1Boats, game->player2Boats };
+
+    for (int player = 0; player < 2; player++) {
+        if (!initializeGameBoard(boards[player], record->width, record->height, arena)) return NULL;
+        for (int i = 0; i < record->boatCounts[player]; i++) {
+            fleets[player][i] = recordedBoat(record, player + 1, i);
+            if (!canPlaceBoat(boards[player], &fleets[player][i])
+                || !setBoatOnBoard(boards[player], &fleets[player][i])) {
+                fprintf(stderr, "Record of seed %llu has an invalid fleet.\n", (unsigned long long)record->seed);
+                return NULL;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < record->shotCount; i++) {
+        RecordedShot shot = recordedShot(record, i);
+        // Player 1 shoots at player 2's board and the other way around.
+        if (shootAt(boards[2 - shot.player], shot.x, shot.y) != shot.result) {
+            fprintf(stderr, "Record of seed %llu diverges at shot %u.\n", (unsigned long long)record->seed, i);
+            return NULL;
+        }
+    }
+    return game;
+}
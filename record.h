@@ -0,0 +1,107 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "game.h"
+#include "byteorder.h"
+
+// Game record files. Every integer is little-endian.
+//
+// File header, 16 bytes:
+//   "BSRC", u16 version, u16 header size, 8 reserved bytes
+// Then records, one per game, appended back to back:
+//   u32 record length in bytes, this field included
+//   u64 seed the game was created from
+//   u16 width, u16 height
+//   u8 strategy of player 1, u8 strategy of player 2
+//   u8 winner (0 when the game was not finished)
+//   u8 boats of player 1, u8 boats of player 2, 3 reserved bytes
+//   u32 shot count
+//   4 bytes per boat, player 1's fleet then player 2's:
+//     x in bits 0-9, y in bits 10-19, vertical in bit 20, size in bits 21-30
+//   3 bytes per shot, in the order they were fired:
+//     cell y * width + x in bits 0-19, result in bits 20-21 (0 miss, 1 hit,
+//     2 sunk), shooter in bit 23 (0 for player 1)
+#define RECORD_MAGIC "BSRC"
+#define RECORD_VERSION 1
+#define RECORD_FILE_HEADER_SIZE 16
+#define RECORD_HEADER_SIZE 28
+#define RECORD_BOAT_SIZE 4
+#define RECORD_SHOT_SIZE 3
+#define RECORD_BUFFER_SIZE (1 << 20)    // Bytes a writer gathers before sending them to the file
+
+// Output file shared by every writer of a run.
+typedef struct {
+    int fd;
+    pthread_mutex_t lock;   // Held while a writer appends its buffer
+} RecordFile;
+
+// Buffered writer, one per thread. Whole records are gathered in memory and
+// appended to the file under its lock, so records never interleave.
+typedef struct {
+    RecordFile *file;
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    size_t recordStart;     // Offset of the record being written
+    uint32_t shots;         // Shots in the record being written
+} RecordWriter;
+
+// A record read from a mapped file. The boats and shots point into the mapping.
+typedef struct {
+    uint64_t seed;
+    int width;
+    int height;
+    AiStrategy strategies[2];
+    int winner;
+    int boatCounts[2];
+    const uint8_t *boats[2];
+    uint32_t shotCount;
+    const uint8_t *shots;
+} GameRecord;
+
+typedef struct {
+    int player;     // 1 or 2, the shooter
+    int x, y;
+    ShotResult result;
+} RecordedShot;
+
+typedef struct {
+    const uint8_t *data;    // Whole file, mapped read-only
+    size_t size;
+    size_t offset;          // Next record
+} RecordReader;
+
+// Boat `index` of `player` (1 or 2), not hit yet.
+static inline Boat recordedBoat(const GameRecord *record, int player, int index) {
+    return unpackBoat(readLe32(record->boats[player - 1] + index * RECORD_BOAT_SIZE));
+}
+
+static inline RecordedShot recordedShot(const GameRecord *record, uint32_t index) {
+    uint32_t packed = readLe24(record->shots + (size_t)index * RECORD_SHOT_SIZE);
+    int cell = (int)(packed & 0xfffff);
+    RecordedShot shot = { 1 + (int)(packed >> 23), cell % record->width, cell / record->width,
+                          (ShotResult)(packed >> 20 & 3) };
+    return shot;
+}
+
+bool openRecordFile(RecordFile *file, const char *path);
+bool closeRecordFile(RecordFile *file);
+
+bool initializeRecordWriter(RecordWriter *writer, RecordFile *file);
+bool beginGameRecord(RecordWriter *writer, const Game *game);
+bool recordShot(RecordWriter *writer, int player, int x, int y, ShotResult result);
+bool endGameRecord(RecordWriter *writer, int winner);
+void abortGameRecord(RecordWriter *writer);
+bool flushRecordWriter(RecordWriter *writer);
+void freeRecordWriter(RecordWriter *writer);
+
+bool openRecordReader(RecordReader *reader, const char *path);
+bool nextGameRecord(RecordReader *reader, GameRecord *record);
+void closeRecordReader(RecordReader *reader);
+Game *replayGameRecord(const GameRecord *record, Arena *arena);
+
+#endif // RECORD_H
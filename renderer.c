@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "renderer.h"
+#include "instrument.h"
+
+#define VIEW_GAP 3      // Columns between the two views in RENDER_ANSI mode
+#define FIRST_ROW 3     // Screen row of the first board row, under the title and the header
+
+bool initializeRenderer(Renderer *renderer, RenderMode mode, int every, int fd) {
+    memset(renderer, 0, sizeof(Renderer));
+    renderer->mode = mode;
+    renderer->every = every > 0 ? every : 1;
+    renderer->fd = fd;
+    if (mode == RENDER_OFF) return true;
+
+    renderer->capacity = 4096;
+    renderer->buffer = (char*)malloc(renderer->capacity);
+    if (renderer->buffer == NULL) {
+        fprintf(stderr, "Memory allocation failed for renderer.\n");
+        return false;
+    }
+    return true;
+}
+
+void freeRenderer(Renderer *renderer) {
+    if (renderer) {
+        if (renderer->mode == RENDER_ANSI && renderer->shown) {
+            // Give the whole screen back to the scrolling text.
+            int written = snprintf(renderer->buffer, renderer->capacity, "\x1b[r\x1b[%d;1H\n", renderer->screenRows);
+            fflush(stdout);
+            if (write(renderer->fd, renderer->buffer, written) < 0) perror("write");
+        }
+        free(renderer->buffer);
+        free(renderer->shown);
+        renderer->buffer = NULL;
+        renderer->shown = NULL;
+    }
+}
+
+// Makes room for `extra` more bytes in the frame buffer.
+static bool reserve(Renderer *renderer, size_t extra) {
+    if (renderer->length + extra <= renderer->capacity) return true;
+
+    size_t capacity = renderer->capacity * 2;
+    while (capacity < renderer->length + extra) capacity *= 2;
+    char *buffer = (char*)realloc(renderer->buffer, capacity);
+    if (buffer == NULL) {
+        fprintf(stderr, "Memory allocation failed for renderer.\n");
+        return false;
+    }
+    renderer->buffer = buffer;
+    renderer->capacity = capacity;
+    return true;
+}
+
+static void append(Renderer *renderer, const char *text, size_t length) {
+    if (!reserve(renderer, length)) return;
+    memcpy(renderer->buffer + renderer->length, text, length);
+    renderer->length += length;
+}
+
+static void appendFormat(Renderer *renderer, const char *format, int value) {
+    char text[32];
+    int length = snprintf(text, sizeof(text), format, value);
+    append(renderer, text, length);
+}
+
+static void appendRepeated(Renderer *renderer, char c, int count) {
+    if (count <= 0 || !reserve(renderer, count)) return;
+    memset(renderer->buffer + renderer->length, c, count);
+    renderer->length += count;
+}
+
+static int digitCount(int value) {
+    int digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+// Character shown for a case, boats hidden in the opponent's view.
+static char caseGlyph(CaseType state, bool revealBoats) {
+    switch (state) {
+        case WATER:
+            return '~';     // Water not targeted
+        case WATER_SHOT:
+            return 'o';     // Water targeted by a shot
+        case BOAT:
+            return revealBoats ? 'B' : '~'; // Part of a boat not touched
+        case WRECK:
+            return 'X';     // Part of a boat hit
+        default:
+            return '?';     // Unknown
+    }
+}
+
+// Width of a view on screen: row labels, then every cell padded to the widest column label.
+static int viewColumns(const GameBoard *board) {
+    return digitCount(board->height - 1) + 1 + board->width * (digitCount(board->width - 1) + 1);
+}
+
+// Header for the columns, every label padded to the widest one
+static void appendColumnHeader(Renderer *renderer, const GameBoard *board) {
+    int columnWidth = digitCount(board->width - 1);
+
+    appendRepeated(renderer, ' ', digitCount(board->height - 1) + 1);
+    for (int x = 0; x < board->width; x++) {
+        int length = digitCount(x);
+        appendFormat(renderer, "%d", x);
+        appendRepeated(renderer, ' ', columnWidth - length + 1);
+    }
+}
+
+// One row of a view: line number on the left, then the status of each box.
+static void appendRow(Renderer *renderer, const GameBoard *board, int y, bool revealBoats) {
+    int padding = digitCount(board->width - 1);
+    const uint8_t *cells = board->cells + y * board->width;
+
+    appendRepeated(renderer, ' ', digitCount(board->height - 1) - digitCount(y));
+    appendFormat(renderer, "%d ", y);
+    if (!reserve(renderer, (size_t)board->width * (padding + 1))) return;
+    char *out = renderer->buffer + renderer->length;
+    for (int x = 0; x < board->width; x++) {
+        *out++ = caseGlyph((CaseType)(cells[x] & CELL_STATE_MASK), revealBoats);
+        memset(out, ' ', padding);
+        out += padding;
+    }
+    renderer->length = out - renderer->buffer;
+}
+
+static void appendView(Renderer *renderer, const GameBoard *board, bool revealBoats) {
+    appendColumnHeader(renderer, board);
+    append(renderer, "\n", 1);
+    for (int y = 0; y < board->height; y++) {
+        appendRow(renderer, board, y, revealBoats);
+        append(renderer, "\n", 1);
+    }
+}
+
+static void flushFrame(Renderer *renderer) {
+    // Whatever the game printed through stdio must reach the screen first.
+    fflush(stdout);
+    size_t sent = 0;
+    while (sent < renderer->length) {
+        ssize_t written = write(renderer->fd, renderer->buffer + sent, renderer->length - sent);
+        if (written < 0) {
+            perror("write");
+            break;
+        }
+        sent += written;
+    }
+    renderer->length = 0;
+}
+
+static void composePlainFrame(Renderer *renderer, const GameBoard *own, const GameBoard *enemy) {
+    static const char ownTitle[] = "Your Board:\n";
+    static const char enemyTitle[] = "\nOpponent's Board:\n";
+
+    append(renderer, ownTitle, sizeof(ownTitle) - 1);
+    appendView(renderer, own, true);
+    append(renderer, enemyTitle, sizeof(enemyTitle) - 1);
+    appendView(renderer, enemy, false);
+}
+
+static void appendMoveTo(Renderer *renderer, int row, int column) {
+    char text[32];
+    int length = snprintf(text, sizeof(text), "\x1b[%d;%dH", row, column);
+    append(renderer, text, length);
+}
+
+// First ANSI frame: clear the screen, draw both views side by side at the top
+// and keep the rows below them as the scrolling area for the messages.
+// Returns false when the terminal is too small, so plain frames are used instead.
+static bool composeFullFrame(Renderer *renderer, const GameBoard *own, const GameBoard *enemy) {
+    struct winsize size;
+    int columns = viewColumns(own);
+    if (ioctl(renderer->fd, TIOCGWINSZ, &size) < 0
+        || size.ws_col < 2 * columns + VIEW_GAP || size.ws_row < own->height + FIRST_ROW + 4) {
+        return false;
+    }
+
+    renderer->shown = (uint8_t*)malloc(2 * (size_t)own->cellCount);
+    if (renderer->shown == NULL) {
+        fprintf(stderr, "Memory allocation failed for renderer.\n");
+        return false;
+    }
+    renderer->width = own->width;
+    renderer->height = own->height;
+    renderer->screenRows = size.ws_row;
+
+    const GameBoard *views[2] = { own, enemy };
+    static const char *titles[2] = { "Your Board:", "Opponent's Board:" };
+    append(renderer, "\x1b[H\x1b[2J", 7);
+    for (int v = 0; v < 2; v++) {
+        int left = 1 + v * (columns + VIEW_GAP);
+        appendMoveTo(renderer, 1, left);
+        append(renderer, titles[v], strlen(titles[v]));
+        appendMoveTo(renderer, 2, left);
+        appendColumnHeader(renderer, views[v]);
+        for (int y = 0; y < own->height; y++) {
+            appendMoveTo(renderer, FIRST_ROW + y, left);
+            appendRow(renderer, views[v], y, v == 0);
+        }
+        for (int i = 0; i < own->cellCount; i++) {
+            renderer->shown[v * own->cellCount + i] = caseGlyph((CaseType)(views[v]->cells[i] & CELL_STATE_MASK), v == 0);
+        }
+    }
+
+    // Messages scroll in the rows under the boards, which stay in place.
+    char region[32];
+    int length = snprintf(region, sizeof(region), "\x1b[%d;%dr", own->height + FIRST_ROW + 1, renderer->screenRows);
+    append(renderer, region, length);
+    appendMoveTo(renderer, own->height + FIRST_ROW + 1, 1);
+    return true;
+}
+
+// Later ANSI frames: only the cells whose glyph changed are written, then the
+// cursor goes back where the messages were being printed.
+static void composeChanges(Renderer *renderer, const GameBoard *own, const GameBoard *enemy) {
+    const GameBoard *views[2] = { own, enemy };
+    int columns = viewColumns(own);
+    int rowLabel = digitCount(own->height - 1) + 1;
+    int step = digitCount(own->width - 1) + 1;
+    size_t start = renderer->length;
+
+    append(renderer, "\x1b" "7", 2); // Save the cursor
+    for (int v = 0; v < 2; v++) {
+        uint8_t *shown = renderer->shown + v * own->cellCount;
+        for (int i = 0; i < own->cellCount; i++) {
+            char glyph = caseGlyph((CaseType)(views[v]->cells[i] & CELL_STATE_MASK), v == 0);
+            if (glyph != shown[i]) {
+                shown[i] = glyph;
+                appendMoveTo(renderer, FIRST_ROW + i / own->width,
+                             1 + v * (columns + VIEW_GAP) + rowLabel + (i % own->width) * step);
+                append(renderer, &glyph, 1);
+            }
+        }
+    }
+    if (renderer->length == start + 2) {
+        renderer->length = start; // Nothing changed, nothing to send
+        return;
+    }
+    append(renderer, "\x1b" "8", 2); // Restore the cursor
+}
+
+// Function to draw both boards, once every `every` calls unless `force` is set.
+void renderFrame(Renderer *renderer, const GameBoard *own, const GameBoard *enemy, bool force) {
+    if (renderer->mode == RENDER_OFF) return;
+    if (renderer->turns++ % renderer->every != 0 && !force) return;
+    INSTRUMENT_START(renderStart);
+
+    if (renderer->mode == RENDER_ANSI) {
+        if (renderer->shown != NULL && (own->width != renderer->width || own->height != renderer->height)) {
+            free(renderer->shown);  // New board dimensions, start over
+            renderer->shown = NULL;
+        }
+        if (renderer->shown != NULL) {
+            composeChanges(renderer, own, enemy);
+        } else if (!composeFullFrame(renderer, own, enemy)) {
+            renderer->length = 0;
+            renderer->mode = RENDER_PLAIN;
+        }
+    }
+    if (renderer->mode == RENDER_PLAIN) {
+        composePlainFrame(renderer, own, enemy);
+    }
+    flushFrame(renderer);
+    INSTRUMENT_STOP(PHASE_RENDER, renderStart);
+}
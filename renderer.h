@@ -0,0 +1,37 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "gameboard.h"
+
+typedef enum {
+    RENDER_OFF,     // Nothing is drawn
+    RENDER_PLAIN,   // Both boards printed in full, for pipes and small terminals
+    RENDER_ANSI,    // Boards drawn once at the top of the screen, then only the cells that changed
+} RenderMode;
+
+// Draws a player's own board next to what they know of the opponent's. A frame
+// is composed in one buffer reused from frame to frame and sent with a single
+// write(). In RENDER_ANSI mode the boards stay at the top of the screen and the
+// lines below them scroll on their own, so the messages of the game keep going
+// through stdio while a frame only moves the cursor to the cells that changed.
+typedef struct {
+    RenderMode mode;
+    int fd;                 // Where frames are written
+    int every;              // A frame is drawn every `every` turns
+    long turns;             // Turns seen so far
+    char *buffer;           // Frame being composed
+    size_t length;
+    size_t capacity;
+    uint8_t *shown;         // ANSI: glyph on screen for each cell of both views
+    int width, height;      // Board dimensions `shown` was drawn for
+    int screenRows;         // ANSI: height of the terminal
+} Renderer;
+
+bool initializeRenderer(Renderer *renderer, RenderMode mode, int every, int fd);
+void renderFrame(Renderer *renderer, const GameBoard *own, const GameBoard *enemy, bool force);
+void freeRenderer(Renderer *renderer);
+
+#endif // RENDERER_H
@@ -0,0 +1,51 @@
+#include "rng.h"
+
+static uint64_t splitMix(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Expands a 64-bit seed into a full state, as recommended by the xoshiro authors.
+void seedRng(Rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitMix(&seed);
+    }
+}
+
+// Derives the seed of stream number `stream` (a game, a chunk...) from a base seed.
+// The result only depends on the two numbers, whatever thread asks for it.
+uint64_t streamSeed(uint64_t seed, uint64_t stream) {
+    uint64_t state = seed ^ (stream * 0xd1b54a32d192ed03ULL);
+    splitMix(&state);
+    return splitMix(&state);
+}
+
+// Advances the generator by 2^128 draws: calling it k times on a copy gives the
+// k-th of 2^128 non-overlapping streams, one per worker thread. The simulators
+// seed each game with streamSeed instead, so that a game plays the same
+// whichever worker runs it and however many there are.
+void jumpRng(Rng *rng) {
+    static const uint64_t jump[] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL,
+    };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & ((uint64_t)1 << b)) {
+                s0 ^= rng->s[0];
+                s1 ^= rng->s[1];
+                s2 ^= rng->s[2];
+                s3 ^= rng->s[3];
+            }
+            nextRandom(rng);
+        }
+    }
+    rng->s[0] = s0;
+    rng->s[1] = s1;
+    rng->s[2] = s2;
+    rng->s[3] = s3;
+}
@@ -0,0 +1,49 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xoshiro256** generator. Every game and every thread owns its own state, so
+// runs are reproducible from a seed and threads never share hidden state.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+void seedRng(Rng *rng, uint64_t seed);
+uint64_t streamSeed(uint64_t seed, uint64_t stream);
+void jumpRng(Rng *rng);
+
+static inline uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t nextRandom(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotateLeft(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotateLeft(s[3], 45);
+    return result;
+}
+
+// Uniform integer in [0, bound) without the bias of a modulo (Lemire's method).
+static inline uint32_t randomBelow(Rng *rng, uint32_t bound) {
+    uint64_t product = (nextRandom(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)product;
+
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = (nextRandom(rng) >> 32) * bound;
+            low = (uint32_t)product;
+        }
+    }
+    return (uint32_t)(product >> 32);
+}
+
+#endif // RNG_H
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "server.h"
+#include "montecarlo.h"
+#include "book.h"
+#include "transposition.h"
+
+// Multiplayer server: every connection plays against the computer, all games
+// served by one thread over epoll. See server.h for the protocol.
+
+static Server *runningServer;
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--address IPV4] [--port PORT] [--max-games N] [--max-connections N]\n"
+                    "          [--seed SEED] [--size N | --width W --height H] [--ai random|density|montecarlo]\n"
+                    "          [--mc-samples N] [--mc-budget US] [--book FILE] [--cache ENTRIES]\n", program);
+}
+
+static void stopOnSignal(int signal) {
+    (void)signal;
+    stopServer(runningServer);
+}
+
+// Raises the descriptor limit as far as allowed, and returns it.
+static long raiseDescriptorLimit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0) return 1024;
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+    return (long)limit.rlim_cur;
+}
+
+int main(int argc, char **argv) {
+    ServerConfig config = { "127.0.0.1", SERVER_PORT, 0, 0, (uint64_t)time(NULL),
+                            { BOARD_SIZE, BOARD_SIZE, { AI_RANDOM, AI_DENSITY }, NULL, NULL, NULL, NULL } };
+    // Games are served from one thread, so is the sampling: no move may stall the others for long.
+    MonteCarloConfig monteCarlo = { 1, MONTE_CARLO_SAMPLES, 1000 };
+    // Every game starts from the same few positions: remember the shots chosen there.
+    long cacheEntries = TRANSPOSITION_ENTRIES;
+    const char *bookPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--address") == 0 && i + 1 < argc) {
+            config.address = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-games") == 0 && i + 1 < argc) {
+            config.maxGames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-connections") == 0 && i + 1 < argc) {
+            config.maxConnections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            config.game.width = config.game.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            config.game.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            config.game.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ai") == 0 && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &config.game.strategies[1])) return EXIT_FAILURE;
+            // A move of the exact analysis takes up to a second, for which the
+            // single thread would leave every other game waiting.
+            if (config.game.strategies[1] == AI_EXACT) {
+                fprintf(stderr, "The server cannot play the exact strategy: its moves would stall every game.\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--mc-samples") == 0 && i + 1 < argc) {
+            monteCarlo.samples = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mc-budget") == 0 && i + 1 < argc) {
+            monteCarlo.budget = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            bookPath = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheEntries = strtol(argv[++i], NULL, 10);
+        } else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Every connection takes a descriptor; keep a few for the listener and epoll.
+    long descriptors = raiseDescriptorLimit() - 16;
+    if (config.maxConnections <= 0 || config.maxConnections > descriptors) config.maxConnections = (int)descriptors;
+    if (config.maxGames <= 0) config.maxGames = config.maxConnections;
+
+    if (config.game.strategies[1] == AI_MONTE_CARLO) {
+        config.game.monteCarlo = createMonteCarlo(&monteCarlo, config.game.width, config.game.height);
+        if (config.game.monteCarlo == NULL) return EXIT_FAILURE;
+    }
+    OpeningBook book = { 0 };
+    if (bookPath) {
+        if (!openOpeningBook(&book, bookPath)) return EXIT_FAILURE;
+        config.game.book = &book;
+    }
+    if (cacheEntries > 0 && (config.game.transpositions = createTranspositionTable(cacheEntries)) == NULL) {
+        return EXIT_FAILURE;
+    }
+    runningServer = createServer(&config);
+    if (runningServer == NULL) {
+        freeMonteCarlo(config.game.monteCarlo);
+        freeTranspositionTable(config.game.transpositions);
+        closeOpeningBook(&book);
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction action = { 0 };
+    action.sa_handler = stopOnSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf("Listening on %s:%d, %d connections, %d games, %dx%d boards\n", config.address, config.port,
+           config.maxConnections, config.maxGames, config.game.width, config.game.height);
+    fflush(stdout);
+    bool ok = runServer(runningServer);
+
+    const ServerStats *stats = serverStats(runningServer);
+    printf("Connections:    %ld\n", stats->connections);
+    printf("Games:          %ld started, %ld won by players, %ld lost\n",
+           stats->gamesStarted, stats->gamesWon, stats->gamesLost);
+    printf("Player shots:   %ld\n", stats->shots);
+    freeServer(runningServer);
+    freeMonteCarlo(config.game.monteCarlo);
+    freeTranspositionTable(config.game.transpositions);
+    closeOpeningBook(&book);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
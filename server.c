@@ -0,0 +1,403 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include "server.h"
+
+#define SLOT_ARENA_SIZE (16 * 1024)    // First block of a game slot's arena
+#define EVENT_BATCH 256
+#define LISTENER UINT64_MAX             // Epoll tag of the listening socket
+
+// A game in the table. Its arena is reset when the slot is reused, so a
+// server that runs warm no longer allocates anything per game.
+typedef struct {
+    Arena arena;
+    Game *game;
+    int next;           // Next free slot, -1 at the end of the list
+} GameSlot;
+
+// A player's connection. Requests are read into `in` and handled a whole
+// line at a time; replies wait in `out` until the socket takes them.
+typedef struct {
+    int fd;             // -1 when the connection is free
+    int slot;           // Game being played, -1 for none
+    int next;           // Next free connection, -1 at the end of the list
+    bool writing;       // Waiting for the socket to take the rest of `out`
+    int inLength;
+    int outLength;
+    int outSent;
+    char in[4 * SERVER_LINE_MAX];
+    char out[16 * SERVER_REPLY_MAX];
+} Connection;
+
+struct Server {
+    ServerConfig config;
+    int listenFd;
+    int epollFd;
+    GameSlot *slots;
+    int freeSlot;
+    Connection *connections;
+    int freeConnection;
+    ServerStats stats;
+    volatile sig_atomic_t stopping;
+};
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+
+static bool openListener(Server *server) {
+    struct sockaddr_in address = { 0 };
+    int on = 1;
+
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)server->config.port);
+    if (inet_pton(AF_INET, server->config.address, &address.sin_addr) != 1) {
+        fprintf(stderr, "Invalid address %s.\n", server->config.address);
+        return false;
+    }
+
+    server->listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server->listenFd < 0) {
+        perror("socket");
+        return false;
+    }
+    setsockopt(server->listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(server->listenFd, (struct sockaddr*)&address, sizeof(address)) < 0
+        || listen(server->listenFd, SOMAXCONN) < 0 || !setNonBlocking(server->listenFd)) {
+        fprintf(stderr, "Cannot listen on %s:%d: %s\n", server->config.address, server->config.port, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Function to create a server listening on the configured port, with every
+// game slot and connection allocated up front.
+Server *createServer(const ServerConfig *config) {
+    Server *server = (Server*)calloc(1, sizeof(Server));
+    if (server == NULL) {
+        fprintf(stderr, "Memory allocation failed for server.\n");
+        return NULL;
+    }
+    server->config = *config;
+    server->listenFd = -1;
+    server->epollFd = -1;
+
+    server->slots = (GameSlot*)calloc(config->maxGames, sizeof(GameSlot));
+    server->connections = (Connection*)calloc(config->maxConnections, sizeof(Connection));
+    if (server->slots == NULL || server->connections == NULL) {
+        fprintf(stderr, "Memory allocation failed for server.\n");
+        freeServer(server);
+        return NULL;
+    }
+    for (int i = 0; i < config->maxGames; i++) {
+        initializeArena(&server->slots[i].arena, SLOT_ARENA_SIZE);
+        server->slots[i].next = i + 1 < config->maxGames ? i + 1 : -1;
+    }
+    for (int i = 0; i < config->maxConnections; i++) {
+        server->connections[i].fd = -1;
+        server->connections[i].next = i + 1 < config->maxConnections ? i + 1 : -1;
+    }
+    server->freeSlot = config->maxGames > 0 ? 0 : -1;
+    server->freeConnection = config->maxConnections > 0 ? 0 : -1;
+
+    struct epoll_event event = { .events = EPOLLIN, .data.u64 = LISTENER };
+    if (!openListener(server) || (server->epollFd = epoll_create1(EPOLL_CLOEXEC)) < 0
+        || epoll_ctl(server->epollFd, EPOLL_CTL_ADD, server->listenFd, &event) < 0) {
+        if (server->listenFd >= 0 && server->epollFd < 0) perror("epoll");
+        freeServer(server);
+        return NULL;
+    }
+    return server;
+}
+
+void freeServer(Server *server) {
+    if (server == NULL) return;
+
+    if (server->connections) {
+        for (int i = 0; i < server->config.maxConnections; i++) {
+            if (server->connections[i].fd >= 0) close(server->connections[i].fd);
+        }
+    }
+    if (server->slots) {
+        for (int i = 0; i < server->config.maxGames; i++) freeArena(&server->slots[i].arena);
+    }
+    if (server->listenFd >= 0) close(server->listenFd);
+    if (server->epollFd >= 0) close(server->epollFd);
+    free(server->slots);
+    free(server->connections);
+    free(server);
+}
+
+// Function to make runServer return after the events being handled.
+// Only sets a flag, so it may be called from a signal handler.
+void stopServer(Server *server) {
+    server->stopping = 1;
+}
+
+const ServerStats *serverStats(const Server *server) {
+    return &server->stats;
+}
+
+static void releaseGame(Server *server, Connection *connection) {
+    if (connection->slot < 0) return;
+    server->slots[connection->slot].game = NULL;
+    server->slots[connection->slot].next = server->freeSlot;
+    server->freeSlot = connection->slot;
+    connection->slot = -1;
+}
+
+static void closeConnection(Server *server, Connection *connection) {
+    releaseGame(server, connection);
+    close(connection->fd);  // Also takes it out of the epoll set
+    connection->fd = -1;
+    connection->next = server->freeConnection;
+    server->freeConnection = (int)(connection - server->connections);
+}
+
+static void reply(Connection *connection, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void reply(Connection *connection, const char *format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(connection->out + connection->outLength, SERVER_REPLY_MAX, format, arguments);
+    va_end(arguments);
+    if (length >= SERVER_REPLY_MAX) length = SERVER_REPLY_MAX - 1;
+    connection->outLength += length;
+}
+
+static void startGame(Server *server, Connection *connection, const char *arguments) {
+    char *end;
+    while (*arguments == ' ') arguments++;
+    uint64_t seed = strtoull(arguments, &end, 10);
+    while (*end == ' ' || *end == '\t') end++;
+    if (*arguments == '\0') {
+        seed = streamSeed(server->config.seed, (uint64_t)server->stats.gamesStarted);
+    } else if (end == arguments || *end != '\0' || *arguments < '0' || *arguments > '9') {
+        reply(connection, "E bad seed\n");
+        return;
+    }
+
+    releaseGame(server, connection);
+    if (server->freeSlot < 0) {
+        reply(connection, "E server full\n");
+        return;
+    }
+    GameSlot *slot = &server->slots[server->freeSlot];
+    resetArena(&slot->arena);
+    slot->game = initializeGame(&server->config.game, seed, &slot->arena);
+    if (slot->game == NULL) {
+        reply(connection, "E cannot create game\n");
+        return;
+    }
+    connection->slot = server->freeSlot;
+    server->freeSlot = slot->next;
+    server->stats.gamesStarted++;
+    reply(connection, "G %d %d %llu\n", server->config.game.width, server->config.game.height,
+          (unsigned long long)seed);
+}
+
+// The player shoots at player 2's board, the computer answers on player 1's.
+static void playTurn(Server *server, Connection *connection, const char *arguments) {
+    char *xEnd, *yEnd;
+    if (connection->slot < 0) {
+        reply(connection, "E no game\n");
+        return;
+    }
+    Game *game = server->slots[connection->slot].game;
+    long x = strtol(arguments, &xEnd, 10);
+    long y = strtol(xEnd, &yEnd, 10);
+    if (xEnd == arguments || yEnd == xEnd) {
+        reply(connection, "E expected S <x> <y>\n");
+        return;
+    }
+
+    while (*yEnd == ' ' || *yEnd == '\t') yEnd++;
+
+    // Checked as longs, so that a huge coordinate cannot wrap onto the board.
+    GameBoard *board = &game->player2Board;
+    ShotResult result = SHOT_INVALID;
+    if (*yEnd == '\0' && x >= 0 && x < board->width && y >= 0 && y < board->height) {
+        result = shootAt(board, (int)x, (int)y);
+    }
+    if (result == SHOT_ALREADY_TARGETED || result == SHOT_INVALID) {
+        reply(connection, "%c\n", shotResultCode(result));
+        return;
+    }
+    server->stats.shots++;
+    if (isGameOver(&game->player2Board)) {
+        reply(connection, "%c W\n", shotResultCode(result));
+        server->stats.gamesWon++;
+        releaseGame(server, connection);
+        return;
+    }
+
+    int cx, cy;
+    ShotResult answer = computerShoot(&game->player1Board, &game->player2Targeting, &game->rng, &cx, &cy);
+    if (isGameOver(&game->player1Board)) {
+        reply(connection, "%c %d %d %c L\n", shotResultCode(result), cx, cy, shotResultCode(answer));
+        server->stats.gamesLost++;
+        releaseGame(server, connection);
+        return;
+    }
+    reply(connection, "%c %d %d %c\n", shotResultCode(result), cx, cy, shotResultCode(answer));
+}
+
+// Handles the complete lines received, as long as there is room for their
+// replies. Returns false when the connection must be closed.
+static bool handleRequests(Server *server, Connection *connection) {
+    int start = 0;
+
+    while (connection->outLength + SERVER_REPLY_MAX <= (int)sizeof(connection->out)) {
+        char *line = connection->in + start;
+        char *newline = memchr(line, '\n', connection->inLength - start);
+        if (newline == NULL) break;
+        *newline = '\0';
+        if (newline > line && newline[-1] == '\r') newline[-1] = '\0';
+        start = (int)(newline + 1 - connection->in);
+
+        if (strncmp(line, "S ", 2) == 0) {
+            playTurn(server, connection, line + 2);
+        } else if (strncmp(line, "NEW", 3) == 0 && (line[3] == '\0' || line[3] == ' ')) {
+            startGame(server, connection, line + 3);
+        } else if (strcmp(line, "Q") == 0) {
+            return false;
+        } else {
+            reply(connection, "E unknown request\n");
+        }
+    }
+
+    connection->inLength -= start;
+    memmove(connection->in, connection->in + start, connection->inLength);
+    if (connection->inLength == (int)sizeof(connection->in)) return false; // No newline in a full buffer
+    return true;
+}
+
+// Sends what the socket takes, and waits for it to drain before reading more
+// requests when it does not take everything. Returns false on a dead socket.
+static bool flushReplies(Server *server, Connection *connection) {
+    while (connection->outSent < connection->outLength) {
+        ssize_t sent = send(connection->fd, connection->out + connection->outSent,
+                            connection->outLength - connection->outSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            break;
+        }
+        connection->outSent += (int)sent;
+    }
+    if (connection->outSent == connection->outLength) connection->outSent = connection->outLength = 0;
+
+    bool writing = connection->outLength > 0;
+    if (writing != connection->writing) {
+        struct epoll_event event = { .events = writing ? EPOLLOUT : EPOLLIN,
+                                     .data.u64 = (uint64_t)(connection - server->connections) };
+        if (epoll_ctl(server->epollFd, EPOLL_CTL_MOD, connection->fd, &event) < 0) return false;
+        connection->writing = writing;
+    }
+    return true;
+}
+
+// Handles the buffered requests and sends their replies until either runs out.
+static bool serveBuffered(Server *server, Connection *connection) {
+    do {
+        if (!handleRequests(server, connection) || !flushReplies(server, connection)) return false;
+    } while (!connection->writing && memchr(connection->in, '\n', connection->inLength) != NULL);
+    return true;
+}
+
+static void serveConnection(Server *server, Connection *connection, uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        closeConnection(server, connection);
+        return;
+    }
+
+    // Once the backlog is sent, the requests already buffered come first.
+    bool open = true;
+    if (connection->writing) {
+        open = flushReplies(server, connection) && (connection->writing || serveBuffered(server, connection));
+    }
+
+    while (open && !connection->writing) {
+        ssize_t received = recv(connection->fd, connection->in + connection->inLength,
+                                sizeof(connection->in) - connection->inLength, 0);
+        if (received == 0) {
+            open = false;
+        } else if (received < 0) {
+            if (errno == EINTR) continue;
+            open = errno == EAGAIN || errno == EWOULDBLOCK;
+            break;
+        } else {
+            connection->inLength += (int)received;
+            open = serveBuffered(server, connection);
+        }
+    }
+    if (!open) closeConnection(server, connection);
+}
+
+static void acceptConnections(Server *server) {
+    int on = 1;
+
+    for (;;) {
+        int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+        if (server->freeConnection < 0) {
+            close(fd);  // Every connection is taken
+            continue;
+        }
+
+        int index = server->freeConnection;
+        Connection *connection = &server->connections[index];
+        struct epoll_event event = { .events = EPOLLIN, .data.u64 = (uint64_t)index };
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));  // Replies are tiny, send them now
+        if (epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            perror("epoll_ctl");
+            close(fd);
+            continue;
+        }
+        server->freeConnection = connection->next;
+        connection->fd = fd;
+        connection->slot = -1;
+        connection->writing = false;
+        connection->inLength = connection->outLength = connection->outSent = 0;
+        server->stats.connections++;
+    }
+}
+
+// Function to serve every connection from the calling thread until
+// stopServer. Returns false when waiting for events fails.
+bool runServer(Server *server) {
+    struct epoll_event events[EVENT_BATCH];
+
+    while (!server->stopping) {
+        int count = epoll_wait(server->epollFd, events, EVENT_BATCH, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.u64 == LISTENER) {
+                acceptConnections(server);
+            } else {
+                Connection *connection = &server->connections[events[i].data.u64];
+                if (connection->fd >= 0) serveConnection(server, connection, events[i].events);
+            }
+        }
+    }
+    return true;
+}
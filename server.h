@@ -0,0 +1,55 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+
+// Line protocol spoken by battleship-server, one request and one reply per line.
+//
+//   NEW [SEED]     start a game against the computer, replacing the current one
+//                  -> "G <width> <height> <seed>"
+//   S <x> <y>      shoot at the computer's board
+//                  -> "<r>" alone when the shot did not count or won the game,
+//                  -> "<r> <cx> <cy> <cr>" otherwise, with the computer's reply
+//                     shot; it is followed by " L" when that shot won the game
+//                  The player's win is announced by " W" after "<r>".
+//   Q              close the connection
+//
+// Results are one letter: M miss, H hit, S sunk, A already targeted, I invalid.
+// Errors are "E <message>"; the connection stays open.
+#define SERVER_PORT 7777
+#define SERVER_LINE_MAX 64          // Longest request line, newline included
+#define SERVER_REPLY_MAX 48         // Longest reply line, newline included
+
+static inline char shotResultCode(ShotResult result) {
+    static const char codes[] = { 'M', 'H', 'S', 'A', 'I' };
+    return codes[result];
+}
+
+typedef struct {
+    const char *address;    // IPv4 address to listen on
+    int port;
+    int maxGames;       // Games in play at once; NEW is refused beyond
+    int maxConnections;
+    uint64_t seed;      // Game n gets streamSeed(seed, n) unless NEW gives a seed
+    GameConfig game;    // Board dimensions and the computer's strategy
+} ServerConfig;
+
+typedef struct {
+    long connections;   // Accepted since the start
+    long gamesStarted;
+    long gamesWon;      // By the players
+    long gamesLost;
+    long shots;         // Counted player shots
+} ServerStats;
+
+typedef struct Server Server;
+
+Server *createServer(const ServerConfig *config);
+bool runServer(Server *server);
+void stopServer(Server *server);
+const ServerStats *serverStats(const Server *server);
+void freeServer(Server *server);
+
+#endif // SERVER_H
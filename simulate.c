@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "game.h"
+#include "simulation.h"
+#include "tournament.h"
+#include "record.h"
+#include "book.h"
+#include "transposition.h"
+#include "instrument.h"
+
+// Headless simulator: plays computer vs computer games on every core and
+// prints their statistics, optionally recording them, replays a record file,
+// or runs a tournament between strategies.
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--games GAMES] [--threads THREADS] [--seed SEED]\n"
+                    "          [--size N | --width W --height H]\n"
+                    "          [--ai1 STRATEGY] [--ai2 STRATEGY] [--mc-samples N] [--mc-budget US]\n"
+                    "          [--book FILE] [--cache ENTRIES]\n"
+                    "          [--record FILE] | --replay FILE\n"
+                    "       %s --tournament STRATEGY,STRATEGY,... [--min-pairs N] [--max-pairs N]\n"
+                    "          [--confidence Z] [--threads THREADS] [--seed SEED] [--size N | --width W --height H]\n"
+                    "Strategies: random, density, montecarlo, exact\n"
+                    "Tournament strategies: the above, montecarlo:SAMPLES, hunt, parity\n", program, program);
+}
+
+// Function that runs computer vs computer games without display and prints the statistics
+static int runHeadless(long games, int threads, uint64_t seed, const GameConfig *game,
+                       const MonteCarloConfig *monteCarlo, const char *recordPath) {
+    SimulationConfig config = { games, threads, seed, *game, NULL, *monteCarlo, NULL };
+    SimulationStats stats;
+    RecordFile records;
+
+    if (recordPath) {
+        if (!openRecordFile(&records, recordPath)) return EXIT_FAILURE;
+        config.records = &records;
+    }
+    printf("Seed:           %llu\n", (unsigned long long)seed);
+    printf("Board:          %dx%d\n", game->width, game->height);
+    bool ok = runSimulation(&config, &stats);
+    printSimulationStats(&stats, stdout);
+    freeSimulationStats(&stats);
+    if (recordPath && !closeRecordFile(&records)) ok = false;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Function that plays every matchup of the comma separated strategies and
+// prints the verdicts and the standings.
+static int runLeague(char *list, const TournamentConfig *config, long samples) {
+    TournamentEntry entries[32];
+    TournamentResult result;
+    int count = 0;
+
+    for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        if (count == 32) {
+            fprintf(stderr, "Too many strategies, 32 at most.\n");
+            return EXIT_FAILURE;
+        }
+        if (!parseTournamentEntry(name, samples, &entries[count++])) return EXIT_FAILURE;
+    }
+    printf("Seed:           %llu\n", (unsigned long long)config->seed);
+    printf("Board:          %dx%d\n", config->width, config->height);
+    bool ok = runTournament(config, entries, count, &result);
+    if (ok) printTournamentResult(&result, config, entries, count, stdout);
+    freeTournamentResult(&result);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Function that replays every game of a record file and checks each shot
+static int runReplay(const char *path) {
+    RecordReader reader;
+    GameRecord record;
+    Arena arena;
+    long games = 0, shots = 0, wins[2] = { 0, 0 };
+    bool ok = true;
+
+    if (!openRecordReader(&reader, path)) return EXIT_FAILURE;
+    initializeArena(&arena, 0);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (nextGameRecord(&reader, &record)) {
+        resetArena(&arena);
+        if (replayGameRecord(&record, &arena) == NULL) ok = false;
+        games++;
+        shots += record.shotCount;
+        if (record.winner == 1 || record.winner == 2) wins[record.winner - 1]++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (reader.offset != reader.size) ok = false;
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+    printf("Games:          %ld replayed in %.3f s (%.0f games/s, %.0f shots/s)\n",
+           games, seconds, games / seconds, shots / seconds);
+    printf("Wins:           player 1 %ld, player 2 %ld\n", wins[0], wins[1]);
+    printf("Replay:         %s\n", ok ? "every shot matches" : "MISMATCH");
+    freeArena(&arena);
+    closeRecordReader(&reader);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    long games = 10000;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = (uint64_t)time(NULL);
+    const char *recordPath = NULL;
+    const char *replayPath = NULL;
+    const char *bookPath = NULL;
+    char *league = NULL;
+    long cacheEntries = 0;
+    // A matchup is settled once 1/2 is 3 standard errors away from its score,
+    // wide enough for the look taken after every round.
+    TournamentConfig tournament = { 0, 0, 0, 0, 128, 2000, 3.0 };
+    GameConfig config = { BOARD_SIZE, BOARD_SIZE, { AI_DENSITY, AI_DENSITY }, NULL, NULL, NULL, NULL };
+    MonteCarloConfig monteCarlo = { 1, MONTE_CARLO_SAMPLES, 0 };
+
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--games") == 0 || strcmp(argv[i], "--simulate") == 0) && i + 1 < argc) {
+            games = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            config.width = config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            config.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ai1") == 0 && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &config.strategies[0])) return EXIT_FAILURE;
+        } else if ((strcmp(argv[i], "--ai2") == 0 || strcmp(argv[i], "--ai") == 0) && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &config.strategies[1])) return EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--mc-samples") == 0 && i + 1 < argc) {
+            monteCarlo.samples = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--mc-budget") == 0 && i + 1 < argc) {
+            monteCarlo.budget = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            bookPath = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cacheEntries = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--tournament") == 0 && i + 1 < argc) {
+            league = argv[++i];
+        } else if (strcmp(argv[i], "--min-pairs") == 0 && i + 1 < argc) {
+            tournament.minPairs = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-pairs") == 0 && i + 1 < argc) {
+            tournament.maxPairs = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--confidence") == 0 && i + 1 < argc) {
+            tournament.z = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    INSTRUMENT_INSTALL();
+    if (replayPath) {
+        return runReplay(replayPath);
+    }
+    if (league) {
+        tournament.width = config.width;
+        tournament.height = config.height;
+        tournament.threads = threads;
+        tournament.seed = seed;
+        return runLeague(league, &tournament, monteCarlo.samples);
+    }
+    if (games <= 0) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Every worker reads the same book and shares the same table.
+    OpeningBook book;
+    if (bookPath) {
+        if (!openOpeningBook(&book, bookPath)) return EXIT_FAILURE;
+        config.book = &book;
+    }
+    if (cacheEntries > 0 && (config.transpositions = createTranspositionTable(cacheEntries)) == NULL) {
+        if (bookPath) closeOpeningBook(&book);
+        return EXIT_FAILURE;
+    }
+    int status = runHeadless(games, threads, seed, &config, &monteCarlo, recordPath);
+    freeTranspositionTable(config.transpositions);
+    if (bookPath) closeOpeningBook(&book);
+    return status;
+}
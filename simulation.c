@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "simulation.h"
+#include "threadpool.h"
+#include "exact.h"
+#include "instrument.h"
+
+#define GAMES_PER_CHUNK 64  // Games handed to a worker at once
+
+// Accumulators of one worker, padded so that workers never share a cache line.
+// Each worker also owns the arena its games are built in, reset between games.
+typedef struct {
+    _Alignas(64) SimulationStats stats;
+    Arena arena;
+    RecordWriter writer;
+    GameAnalytics analytics;    // This worker's share of config->analytics
+    MonteCarlo *monteCarlo;     // Engine of the AI_MONTE_CARLO players of this worker's games
+    ExactAnalysis *exact;       // Engine of its AI_EXACT players
+    bool failed;
+} WorkerStats;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool initializeStats(SimulationStats *stats, int cells) {
+    memset(stats, 0, sizeof(SimulationStats));
+    stats->cells = cells;
+    stats->shotsToWin = (long*)calloc(cells + 1, sizeof(long));
+    if (stats->shotsToWin == NULL) {
+        fprintf(stderr, "Memory allocation failed for simulation statistics.\n");
+        return false;
+    }
+    return true;
+}
+
+static void addGame(SimulationStats *stats, const SimulatedGame *game) {
+    int shots = game->shots[game->winner - 1];
+
+    stats->games++;
+    if (game->winner == 1) {
+        stats->player1Wins++;
+    } else {
+        stats->player2Wins++;
+    }
+    stats->totalShots += game->shots[0] + game->shots[1];
+    stats->winnerShots += shots;
+    stats->winnerShotsBy[game->winner - 1] += shots;
+    stats->winnerShotsSquares += (double)shots * shots;
+    stats->shotsToWin[shots <= stats->cells ? shots : stats->cells]++;
+}
+
+static void mergeStats(SimulationStats *into, const SimulationStats *from) {
+    into->games += from->games;
+    into->player1Wins += from->player1Wins;
+    into->player2Wins += from->player2Wins;
+    into->totalShots += from->totalShots;
+    into->winnerShots += from->winnerShots;
+    into->winnerShotsBy[0] += from->winnerShotsBy[0];
+    into->winnerShotsBy[1] += from->winnerShotsBy[1];
+    into->winnerShotsSquares += from->winnerShotsSquares;
+    for (int i = 0; i <= into->cells; i++) {
+        into->shotsToWin[i] += from->shotsToWin[i];
+    }
+}
+
+// Function that plays a whole computer vs computer game without any output.
+// Player 1 shoots first; the game stops as soon as one fleet is sunk.
+// Every shot goes to `writer` as well, unless it is NULL; a game that fails
+// leaves no record behind.
+bool playSimulatedGame(Game *game, SimulatedGame *result, RecordWriter *writer) {
+    GameBoard *targets[2] = { &game->player2Board, &game->player1Board };
+    Targeter *targeting[2] = { &game->player1Targeting, &game->player2Targeting };
+    int maxShots = game->player1Board.cellCount;
+    int x, y;
+
+    result->shots[0] = 0;
+    result->shots[1] = 0;
+    if (writer && !beginGameRecord(writer, game)) return false;
+    for (int turn = 0; ; turn ^= 1) {
+        if (result->shots[turn] >= maxShots) {  // Board exhausted, should not happen
+            if (writer) abortGameRecord(writer);
+            return false;
+        }
+
+        ShotResult shot = computerShoot(targets[turn], targeting[turn], &game->rng, &x, &y);
+        result->shots[turn]++;
+        if (writer && !recordShot(writer, turn + 1, x, y, shot)) {
+            abortGameRecord(writer);
+            return false;
+        }
+
+        if (isGameOver(targets[turn])) {
+            result->winner = turn + 1;
+            return writer == NULL || endGameRecord(writer, result->winner);
+        }
+    }
+}
+
+typedef struct {
+    const SimulationConfig *config;
+    WorkerStats *workers;
+} SimulationJob;
+
+static void simulateRange(void *context, int worker, long begin, long end) {
+    SimulationJob *job = (SimulationJob*)context;
+    WorkerStats *mine = &job->workers[worker];
+    RecordWriter *writer = job->config->records ? &mine->writer : NULL;
+    GameConfig config = job->config->game;
+    SimulatedGame result;
+
+    config.monteCarlo = mine->monteCarlo;
+    config.exact = mine->exact;
+
+    // Each game gets its own stream from its index, so the results do not
+    // depend on which worker happened to play it.
+    for (long i = begin; i < end; i++) {
+        resetArena(&mine->arena);
+        Game *game = initializeGame(&config, streamSeed(job->config->seed, i), &mine->arena);
+        if (game == NULL || !playSimulatedGame(game, &result, writer)) {
+            mine->failed = true;
+        } else {
+            addGame(&mine->stats, &result);
+            if (job->config->analytics) addGameToAnalytics(&mine->analytics, game, result.winner, result.shots);
+        }
+        INSTRUMENT_POLL();
+    }
+}
+
+bool runSimulation(const SimulationConfig *config, SimulationStats *stats) {
+    int cells = config->game.width * config->game.height;
+    bool ok = true;
+
+    if (!initializeStats(stats, cells)) return false;
+
+    ThreadPool *pool = createThreadPool(config->threads);
+    if (pool == NULL) return false;
+    int threads = threadPoolSize(pool);
+
+    WorkerStats *workers = (WorkerStats*)aligned_alloc(64, threads * sizeof(WorkerStats));
+    if (workers == NULL) {
+        fprintf(stderr, "Memory allocation failed for simulation workers.\n");
+        freeThreadPool(pool);
+        return false;
+    }
+    for (int i = 0; i < threads; i++) {
+        workers[i].failed = !initializeStats(&workers[i].stats, cells);
+        initializeArena(&workers[i].arena, 0);
+        if (config->records && !initializeRecordWriter(&workers[i].writer, config->records)) {
+            workers[i].failed = true;
+        }
+        if (config->analytics && !initializeGameAnalytics(&workers[i].analytics, config->game.width,
+                                                          config->game.height)) {
+            workers[i].failed = true;
+        }
+        // Games already run in parallel, each engine samples on its worker's thread only.
+        workers[i].monteCarlo = NULL;
+        if (config->game.strategies[0] == AI_MONTE_CARLO || config->game.strategies[1] == AI_MONTE_CARLO) {
+            MonteCarloConfig monteCarlo = config->monteCarlo;
+            monteCarlo.threads = 1;
+            workers[i].monteCarlo = createMonteCarlo(&monteCarlo, config->game.width, config->game.height);
+            if (workers[i].monteCarlo == NULL) workers[i].failed = true;
+        }
+        workers[i].exact = NULL;
+        if (config->game.strategies[0] == AI_EXACT || config->game.strategies[1] == AI_EXACT) {
+            workers[i].exact = createExactAnalysis(config->game.width, config->game.height);
+            if (workers[i].exact == NULL) workers[i].failed = true;
+        }
+        if (workers[i].failed) ok = false;
+    }
+
+    // No game is played unless every worker could be set up.
+    SimulationJob job = { config, workers };
+    double start = nowSeconds();
+    if (ok) runThreadPool(pool, config->games, GAMES_PER_CHUNK, simulateRange, &job);
+    stats->seconds = nowSeconds() - start;
+
+    // Merge the per-worker accumulators once everything is done.
+    for (int i = 0; i < threads; i++) {
+        if (workers[i].failed) ok = false;
+        if (workers[i].stats.shotsToWin) mergeStats(stats, &workers[i].stats);
+        freeSimulationStats(&workers[i].stats);
+        if (config->analytics && workers[i].analytics.occupancy) {
+            mergeGameAnalytics(config->analytics, &workers[i].analytics);
+            freeGameAnalytics(&workers[i].analytics);
+        }
+        freeArena(&workers[i].arena);
+        freeMonteCarlo(workers[i].monteCarlo);
+        freeExactAnalysis(workers[i].exact);
+        if (config->records && workers[i].writer.data) {
+            if (!flushRecordWriter(&workers[i].writer)) ok = false;
+            freeRecordWriter(&workers[i].writer);
+        }
+    }
+    free(workers);
+    freeThreadPool(pool);
+
+    if (!ok) fprintf(stderr, "Some simulated games could not be played.\n");
+    return ok;
+}
+
+// Smallest shot count reached by at least `share` of the games.
+static int shotsPercentile(const SimulationStats *stats, double share) {
+    long target = (long)ceil(share * stats->games);
+    long seen = 0;
+
+    for (int i = 0; i <= stats->cells; i++) {
+        seen += stats->shotsToWin[i];
+        if (seen >= target && seen > 0) return i;
+    }
+    return stats->cells;
+}
+
+void printSimulationStats(const SimulationStats *stats, FILE *out) {
+    if (stats->games == 0) {
+        fprintf(out, "No game played.\n");
+        return;
+    }
+
+    double games = (double)stats->games;
+    double mean = stats->winnerShots / games;
+    double variance = stats->winnerShotsSquares / games - mean * mean;
+    double p1 = stats->player1Wins / games;
+    double margin = 1.96 * sqrt(p1 * (1 - p1) / games); // 95% normal interval
+
+    fprintf(out, "Games:          %ld in %.3f s (%.0f games/s, %.0f shots/s)\n",
+            stats->games, stats->seconds, games / stats->seconds,
+            stats->totalShots / stats->seconds);
+    fprintf(out, "Player 1 wins:  %.2f%% +/- %.2f%%, mean shots to win %.2f\n", 100 * p1, 100 * margin,
+            stats->player1Wins ? (double)stats->winnerShotsBy[0] / stats->player1Wins : 0.0);
+    fprintf(out, "Player 2 wins:  %.2f%% +/- %.2f%%, mean shots to win %.2f\n", 100 * (1 - p1), 100 * margin,
+            stats->player2Wins ? (double)stats->winnerShotsBy[1] / stats->player2Wins : 0.0);
+    fprintf(out, "Shots to win:   mean %.2f, stddev %.2f, p10 %d, p50 %d, p90 %d\n",
+            mean, sqrt(variance > 0 ? variance : 0), shotsPercentile(stats, 0.1),
+            shotsPercentile(stats, 0.5), shotsPercentile(stats, 0.9));
+
+    // Distribution of the winner's shot count, ten shots per line.
+    for (int first = 0; first <= stats->cells; first += 10) {
+        long count = 0;
+        for (int i = first; i < first + 10 && i <= stats->cells; i++) {
+            count += stats->shotsToWin[i];
+        }
+        if (count > 0) {
+            fprintf(out, "  %4d-%-4d %6.2f%%\n", first, first + 9, 100 * count / games);
+        }
+    }
+}
+
+void freeSimulationStats(SimulationStats *stats) {
+    if (stats) {
+        free(stats->shotsToWin);
+        stats->shotsToWin = NULL;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "game.h"
+#include "record.h"
+#include "montecarlo.h"
+#include "analytics.h"
+
+typedef struct {
+    long games;     // Number of computer vs computer games to play
+    int threads;    // Worker threads, the calling thread included
+    uint64_t seed;  // Game i is seeded with streamSeed(seed, i)
+    GameConfig game;            // Board dimensions and strategy of each player
+    RecordFile *records;        // Where every game is recorded, NULL for none
+    MonteCarloConfig monteCarlo;    // AI_MONTE_CARLO settings, for one engine per worker
+    GameAnalytics *analytics;   // Where every game is added as well, NULL for none
+} SimulationConfig;
+
+typedef struct {
+    int winner;     // 1 or 2
+    int shots[2];   // Shots fired by each player
+} SimulatedGame;
+
+typedef struct {
+    long games;
+    long player1Wins;
+    long player2Wins;
+    long totalShots;            // Shots fired by both players
+    long winnerShots;           // Sum of the winners' shot counts
+    long winnerShotsBy[2];      // Same, split by winning player
+    double winnerShotsSquares;  // Sum of their squares, for the deviation
+    int cells;                  // Cells on a board, the longest possible game
+    long *shotsToWin;           // Histogram of the winner's shot count, cells + 1 entries
+    double seconds;             // Wall time of the whole run
+} SimulationStats;
+
+bool playSimulatedGame(Game *game, SimulatedGame *result, RecordWriter *writer);
+bool runSimulation(const SimulationConfig *config, SimulationStats *stats);
+void printSimulationStats(const SimulationStats *stats, FILE *out);
+void freeSimulationStats(SimulationStats *stats);
+
+#endif // SIMULATION_H
@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "record.h"
+#include "byteorder.h"
+
+static size_t shotMaskBytes(int width, int height) {
+    return ((size_t)width * height + 7) / 8;
+}
+
+size_t gameSnapshotSize(int width, int height) {
+    return SNAPSHOT_HEADER_SIZE + 2 * MAX_BOATS * RECORD_BOAT_SIZE + 2 * shotMaskBytes(width, height);
+}
+
+// Function to write the snapshot of `game` to `out`. Returns its size, or 0
+// when `capacity` is too small.
+size_t saveGameSnapshot(const Game *game, uint8_t *out, size_t capacity) {
+    const GameBoard *board = &game->player1Board;
+    const Boat *fleets[2] = { game->player1Boats, game->player2Boats };
+    const GameBoard *boards[2] = { &game->player1Board, &game->player2Board };
+    size_t size = gameSnapshotSize(board->width, board->height);
+    size_t maskBytes = shotMaskBytes(board->width, board->height);
+
+    if (capacity < size) return 0;
+    memcpy(out, SNAPSHOT_MAGIC, 4);
+    putLe16(out + 4, SNAPSHOT_VERSION);
+    putLe16(out + 6, (uint16_t)board->width);
+    putLe16(out + 8, (uint16_t)board->height);
+    out[10] = (uint8_t)game->player1Targeting.strategy;
+    out[11] = (uint8_t)game->player2Targeting.strategy;
+    putLe64(out + 12, game->seed);
+    for (int i = 0; i < 4; i++) putLe64(out + 20 + 8 * i, game->rng.s[i]);
+    out += SNAPSHOT_HEADER_SIZE;
+
+    for (int player = 0; player < 2; player++) {
+        for (int i = 0; i < MAX_BOATS; i++) {
+            const Boat *boat = &fleets[player][i];
+            putLe32(out, packBoat(boat));
+            out += RECORD_BOAT_SIZE;
+        }
+    }
+    // The masks are little-endian words, so their bytes are the bitmap as is.
+    for (int player = 0; player < 2; player++) {
+        for (size_t i = 0; i < maskBytes; i++) out[i] = (uint8_t)(boards[player]->shots[i / 8] >> (8 * (i % 8)));
+        out += maskBytes;
+    }
+    return size;
+}
+
+// Function to bring `game` back to the position of a snapshot. The game must
+// have been created for the same board and strategies; it keeps its engines,
+// book and transposition table. On failure the game is left unplayable.
+bool restoreGameSnapshot(Game *game, const uint8_t *snapshot, size_t size) {
+    int width = game->player1Board.width;
+    int height = game->player1Board.height;
+    size_t maskBytes = shotMaskBytes(width, height);
+
+    if (size < gameSnapshotSize(width, height) || memcmp(snapshot, SNAPSHOT_MAGIC, 4) != 0
+        || readLe16(snapshot + 4) != SNAPSHOT_VERSION) {
+        fprintf(stderr, "Invalid game snapshot.\n");
+        return false;
+    }
+    if (readLe16(snapshot + 6) != width || readLe16(snapshot + 8) != height
+        || snapshot[10] != game->player1Targeting.strategy || snapshot[11] != game->player2Targeting.strategy) {
+        fprintf(stderr, "The snapshot is of another kind of game.\n");
+        return false;
+    }
+    game->seed = readLe64(snapshot + 12);
+    for (int i = 0; i < 4; i++) game->rng.s[i] = readLe64(snapshot + 20 + 8 * i);
+
+    // The fleets, on empty boards.
+    const uint8_t *in = snapshot + SNAPSHOT_HEADER_SIZE;
+    Boat *fleets[2] = { game->player1Boats, game->player2Boats };
+    GameBoard *boards[2] = { &game->player1Board, &game->player2Board };
+    for (int player = 0; player < 2; player++) {
+        if (!clearGameBoard(boards[player])) return false;
+        for (int i = 0; i < MAX_BOATS; i++) {
+            fleets[player][i] = unpackBoat(readLe32(in));
+            in += RECORD_BOAT_SIZE;
+            if (!canPlaceBoat(boards[player], &fleets[player][i])
+                || !setBoatOnBoard(boards[player], &fleets[player][i])) {
+                fprintf(stderr, "The snapshot holds an invalid fleet.\n");
+                return false;
+            }
+        }
+    }
+    if (!resetTargeter(&game->player1Targeting, game->player2Boats, MAX_BOATS)
+        || !resetTargeter(&game->player2Targeting, game->player1Boats, MAX_BOATS)) {
+        return false;
+    }
+
+    // The shots each board received, fired by the other player, then the
+    // sinkings they caused.
+    Targeter *targeting[2] = { &game->player2Targeting, &game->player1Targeting };
+    for (int player = 0; player < 2; player++) {
+        for (int cell = 0; cell < width * height; cell++) {
+            if (in[cell >> 3] >> (cell & 7) & 1) {
+                observeShot(targeting[player], cell % width, cell / width,
+                            shootAt(boards[player], cell % width, cell / width));
+            }
+        }
+        for (int i = 0; i < MAX_BOATS; i++) {
+            if (!isBoatAlive(&fleets[player][i])) observeSunk(targeting[player], &fleets[player][i]);
+        }
+        in += maskBytes;
+    }
+    return true;
+}
+
+// Function to make room for one more shot, and for its checkpoint.
+static bool reserveHistory(GameHistory *history) {
+    if (history->count < history->capacity) return true;
+
+    int capacity = history->capacity ? 2 * history->capacity : 2 * HISTORY_CHECKPOINT_SHOTS;
+    uint8_t *shots = (uint8_t*)realloc(history->shots, (size_t)capacity * RECORD_SHOT_SIZE);
+    if (shots == NULL) {
+        fprintf(stderr, "Memory allocation failed for game history.\n");
+        return false;
+    }
+    history->shots = shots;
+    uint8_t *checkpoints = (uint8_t*)realloc(history->checkpoints,
+                                             (size_t)(capacity / HISTORY_CHECKPOINT_SHOTS + 1) * history->snapshotSize);
+    if (checkpoints == NULL) {
+        fprintf(stderr, "Memory allocation failed for game history.\n");
+        return false;
+    }
+    history->checkpoints = checkpoints;
+    history->capacity = capacity;
+    return true;
+}
+
+// Function to start the history of `game` at its current position.
+bool initializeGameHistory(GameHistory *history, const Game *game) {
+    memset(history, 0, sizeof(GameHistory));
+    history->width = game->player1Board.width;
+    history->height = game->player1Board.height;
+    history->snapshotSize = gameSnapshotSize(history->width, history->height);
+    if (!reserveHistory(history)) return false;
+    saveGameSnapshot(game, history->checkpoints, history->snapshotSize);
+    return true;
+}
+
+// Function to add the shot just fired in `game` to its history. The shots
+// that had been taken back can no longer be redone.
+bool pushGameHistory(GameHistory *history, const Game *game, int shooter, int x, int y, ShotResult result) {
+    history->count = history->position;
+    if (!reserveHistory(history)) return false;
+
+    uint32_t packed = (uint32_t)(y * history->width + x) | (uint32_t)result << 20 | (uint32_t)(shooter == 2) << 23;
+    putLe24(history->shots + (size_t)history->count * RECORD_SHOT_SIZE, packed);
+    history->position = ++history->count;
+    if (history->position % HISTORY_CHECKPOINT_SHOTS == 0) {
+        saveGameSnapshot(game, history->checkpoints + (history->position / HISTORY_CHECKPOINT_SHOTS)
+                                                      * history->snapshotSize, history->snapshotSize);
+    }
+    return true;
+}
+
+HistoryShot gameHistoryShot(const GameHistory *history, int index) {
+    uint32_t packed = readLe24(history->shots + (size_t)index * RECORD_SHOT_SIZE);
+    int cell = (int)(packed & 0xfffff);
+    HistoryShot shot = { 1 + (int)(packed >> 23), cell % history->width, cell / history->width,
+                         (ShotResult)(packed >> 20 & 3) };
+    return shot;
+}
+
+// Function to move `game` to the position after `position` shots of its
+// history, back (undo) or forth (redo).
+bool seekGameHistory(GameHistory *history, Game *game, int position) {
+    if (position < 0 || position > history->count) return false;
+
+    int first = position / HISTORY_CHECKPOINT_SHOTS * HISTORY_CHECKPOINT_SHOTS;
+    Rng rng = game->rng;
+    if (!restoreGameSnapshot(game, history->checkpoints + (first / HISTORY_CHECKPOINT_SHOTS) * history->snapshotSize,
+                             history->snapshotSize)) {
+        return false;
+    }
+    for (int i = first; i < position; i++) {
+        HistoryShot shot = gameHistoryShot(history, i);
+        if (fireShot(game, shot.shooter, shot.x, shot.y) != shot.result) {
+            fprintf(stderr, "The game history diverges at shot %d.\n", i);
+            return false;
+        }
+    }
+    game->rng = rng;
+    history->position = position;
+    return true;
+}
+
+void freeGameHistory(GameHistory *history) {
+    if (history) {
+        free(history->shots);
+        free(history->checkpoints);
+        history->shots = history->checkpoints = NULL;
+        history->capacity = history->count = history->position = 0;
+    }
+}
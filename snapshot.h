@@ -0,0 +1,68 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "game.h"
+
+// Game snapshots: the whole state of a game in a few bytes, since the boards
+// and the targeters follow from the fleets and the shots. Every integer is
+// little-endian.
+//
+//   "BSSN", u16 version, u16 width, u16 height,
+//   u8 strategy of player 1, u8 strategy of player 2
+//   u64 seed the game was created from, then its random stream: 4 x u64
+//   4 bytes per boat, MAX_BOATS of player 1 then of player 2, packed as in
+//   record.h
+//   Per board, player 1's then player 2's: one bit per cell shot at, cell
+//   y * width + x in bit (cell & 7) of byte cell >> 3
+//
+// A 10x10 game takes 118 bytes. Restoring one replays its shots in cell order,
+// then the sinkings. The targeters only depend on which shots were seen, so
+// they come back as they were.
+#define SNAPSHOT_MAGIC "BSSN"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 52
+
+size_t gameSnapshotSize(int width, int height);
+size_t saveGameSnapshot(const Game *game, uint8_t *out, size_t capacity);
+bool restoreGameSnapshot(Game *game, const uint8_t *snapshot, size_t size);
+
+// Undo and redo for a game, kept as the shots fired, 3 bytes each and packed
+// as in record.h, plus a snapshot every HISTORY_CHECKPOINT_SHOTS shots.
+// Moving to an earlier or later shot restores the checkpoint before it and
+// fires the shots in between. The game's random stream is left where it is:
+// once a shot is taken back, the computer may answer another one.
+//
+// A checkpoint reads the whole game, its random stream included. The
+// interactive game pushes the player's shots while the speculation thread
+// (speculation.h) draws from that stream; it relies on the checkpoints
+// falling after even positions only, that is after the computer's replies,
+// since the player's shots are at even indices and leave the position odd.
+#define HISTORY_CHECKPOINT_SHOTS 32     // Even, see above
+
+typedef struct {
+    int width;              // Dimensions of the game, for the cells of the shots
+    int height;
+    size_t snapshotSize;
+    uint8_t *shots;         // RECORD_SHOT_SIZE bytes per shot fired
+    uint8_t *checkpoints;   // Snapshot before shot k * HISTORY_CHECKPOINT_SHOTS, for every k
+    int count;              // Shots kept, the ones taken back included
+    int position;           // Shots played; those after it can be redone
+    int capacity;           // Shots the arrays have room for
+} GameHistory;
+
+typedef struct {
+    int shooter;    // 1 or 2
+    int x, y;
+    ShotResult result;
+} HistoryShot;
+
+bool initializeGameHistory(GameHistory *history, const Game *game);
+bool pushGameHistory(GameHistory *history, const Game *game, int shooter, int x, int y, ShotResult result);
+bool seekGameHistory(GameHistory *history, Game *game, int position);
+HistoryShot gameHistoryShot(const GameHistory *history, int index);
+void freeGameHistory(GameHistory *history);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "speculation.h"
+
+typedef enum {
+    SPECULATION_IDLE,       // Nothing asked
+    SPECULATION_RUNNING,    // A shot is being chosen
+    SPECULATION_DONE,       // The shot is ready
+    SPECULATION_STOPPING,   // The thread must exit
+} SpeculationState;
+
+struct Speculation {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;     // Signals every change of state
+    SpeculationState state;
+
+    // Current request, then its answer
+    GameBoard *playerBoard;
+    Targeter *targeting;
+    Rng *rng;
+    int x, y;
+};
+
+static void *speculationMain(void *arg) {
+    Speculation *speculation = (Speculation*)arg;
+
+    pthread_mutex_lock(&speculation->lock);
+    for (;;) {
+        while (speculation->state == SPECULATION_IDLE || speculation->state == SPECULATION_DONE) {
+            pthread_cond_wait(&speculation->changed, &speculation->lock);
+        }
+        if (speculation->state == SPECULATION_STOPPING) break;
+        pthread_mutex_unlock(&speculation->lock);
+
+        int x, y;
+        chooseComputerShot(speculation->playerBoard, speculation->targeting, speculation->rng, &x, &y);
+
+        pthread_mutex_lock(&speculation->lock);
+        speculation->x = x;
+        speculation->y = y;
+        speculation->state = SPECULATION_DONE;
+        pthread_cond_broadcast(&speculation->changed);
+    }
+    pthread_mutex_unlock(&speculation->lock);
+    return NULL;
+}
+
+Speculation *createSpeculation(void) {
+    Speculation *speculation = (Speculation*)calloc(1, sizeof(Speculation));
+    if (speculation == NULL) {
+        fprintf(stderr, "Memory allocation failed for speculation.\n");
+        return NULL;
+    }
+    pthread_mutex_init(&speculation->lock, NULL);
+    pthread_cond_init(&speculation->changed, NULL);
+    speculation->state = SPECULATION_IDLE;
+    if (pthread_create(&speculation->thread, NULL, speculationMain, speculation) != 0) {
+        fprintf(stderr, "Failed to start the speculation thread.\n");
+        pthread_cond_destroy(&speculation->changed);
+        pthread_mutex_destroy(&speculation->lock);
+        free(speculation);
+        return NULL;
+    }
+    return speculation;
+}
+
+// Function to start choosing the computer's shot at `playerBoard`. The
+// previous request must have been finished or cancelled.
+void startSpeculation(Speculation *speculation, GameBoard *playerBoard, Targeter *targeting, Rng *rng) {
+    pthread_mutex_lock(&speculation->lock);
+    speculation->playerBoard = playerBoard;
+    speculation->targeting = targeting;
+    speculation->rng = rng;
+    speculation->state = SPECULATION_RUNNING;
+    pthread_cond_broadcast(&speculation->changed);
+    pthread_mutex_unlock(&speculation->lock);
+}
+
+// Function to wait for the shot asked by startSpeculation.
+void finishSpeculation(Speculation *speculation, int *x, int *y) {
+    pthread_mutex_lock(&speculation->lock);
+    while (speculation->state == SPECULATION_RUNNING) {
+        pthread_cond_wait(&speculation->changed, &speculation->lock);
+    }
+    *x = speculation->x;
+    *y = speculation->y;
+    speculation->state = SPECULATION_IDLE;
+    pthread_mutex_unlock(&speculation->lock);
+}
+
+// Function to wait for the shot being chosen, if any, and forget it. The
+// random stream it was given has moved on all the same.
+void cancelSpeculation(Speculation *speculation) {
+    int x, y;
+    finishSpeculation(speculation, &x, &y);
+}
+
+void freeSpeculation(Speculation *speculation) {
+    if (speculation) {
+        cancelSpeculation(speculation);
+        pthread_mutex_lock(&speculation->lock);
+        speculation->state = SPECULATION_STOPPING;
+        pthread_cond_broadcast(&speculation->changed);
+        pthread_mutex_unlock(&speculation->lock);
+        pthread_join(speculation->thread, NULL);
+        pthread_cond_destroy(&speculation->changed);
+        pthread_mutex_destroy(&speculation->lock);
+        free(speculation);
+    }
+}
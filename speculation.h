@@ -0,0 +1,26 @@
+#ifndef SPECULATION_H
+#define SPECULATION_H
+
+#include <stdbool.h>
+#include "game.h"
+
+// Background thread that picks the computer's next shot while the player is
+// still typing theirs. The computer's choice only depends on what it knows of
+// the player's board, which the player's shot does not touch, so the shot
+// found ahead is the one the computer would have chosen on its turn; it is
+// only thrown away when the player takes moves back or leaves.
+//
+// Between startSpeculation and finishSpeculation the thread owns the board,
+// the targeter and the random stream it was given: the caller may shoot at
+// the other board and draw it, but must not touch these. Recording the
+// player's shot in the game history is safe because it never takes a
+// checkpoint, which would read the stream (see HISTORY_CHECKPOINT_SHOTS).
+typedef struct Speculation Speculation;
+
+Speculation *createSpeculation(void);
+void startSpeculation(Speculation *speculation, GameBoard *playerBoard, Targeter *targeting, Rng *rng);
+void finishSpeculation(Speculation *speculation, int *x, int *y);
+void cancelSpeculation(Speculation *speculation);
+void freeSpeculation(Speculation *speculation);
+
+#endif // SPECULATION_H
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "analytics.h"
+#include "simulation.h"
+#include "record.h"
+
+// Game analytics: reads record files, or simulates games, on every core and
+// prints where the fleets lie, how the strategies fare and how long games
+// last; the heatmaps and histograms can also be written as CSV or JSON.
+
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--threads THREADS] [--csv FILE] [--json FILE] RECORD_FILE...\n"
+                    "       %s --simulate GAMES [--threads THREADS] [--seed SEED] [--size N | --width W --height H]\n"
+                    "          [--ai1 STRATEGY] [--ai2 STRATEGY] [--mc-samples N] [--csv FILE] [--json FILE]\n"
+                    "Strategies: random, density, montecarlo, exact\n"
+                    "Records of another board size than the first one are skipped.\n", program, program);
+}
+
+// Function to read the board size of the first record of a file
+static bool firstRecordSize(const char *path, int *width, int *height) {
+    RecordReader reader;
+    GameRecord record;
+
+    if (!openRecordReader(&reader, path)) return false;
+    bool found = nextGameRecord(&reader, &record);
+    if (found) {
+        *width = record.width;
+        *height = record.height;
+    } else {
+        fprintf(stderr, "%s holds no game.\n", path);
+    }
+    closeRecordReader(&reader);
+    return found;
+}
+
+// Function to write the analytics to `path` with `write`
+static bool writeAnalyticsFile(const GameAnalytics *analytics, const char *path,
+                               bool (*write)(const GameAnalytics*, FILE*)) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Cannot create %s.\n", path);
+        return false;
+    }
+    bool ok = write(analytics, out);
+    if (fclose(out) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Cannot write %s.\n", path);
+    return ok;
+}
+
+// Function that gathers the analytics of the record files, or of `games`
+// simulated games when there are none, then prints and writes them
+static int runAnalytics(long games, int threads, uint64_t seed, const GameConfig *config,
+                        const MonteCarloConfig *monteCarlo, const char **paths, int pathCount,
+                        const char *csvPath, const char *jsonPath) {
+    GameAnalytics analytics;
+    bool ok = true;
+
+    if (games > 0) {
+        // The simulator feeds its per-worker accumulators as the games end.
+        SimulationConfig simulation = { games, threads, seed, *config, NULL, *monteCarlo, &analytics };
+        SimulationStats stats;
+        if (!initializeGameAnalytics(&analytics, config->width, config->height)) return EXIT_FAILURE;
+        printf("Seed:           %llu\n", (unsigned long long)seed);
+        ok = runSimulation(&simulation, &stats);
+        analytics.seconds = stats.seconds;
+        freeSimulationStats(&stats);
+    } else {
+        int width, height;
+        if (!firstRecordSize(paths[0], &width, &height)
+            || !initializeGameAnalytics(&analytics, width, height)) {
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < pathCount; i++) {
+            if (!analyzeRecordFile(&analytics, paths[i], threads)) ok = false;
+        }
+    }
+
+    printGameAnalytics(&analytics, stdout);
+    if (csvPath && !writeAnalyticsFile(&analytics, csvPath, writeAnalyticsCsv)) ok = false;
+    if (jsonPath && !writeAnalyticsFile(&analytics, jsonPath, writeAnalyticsJson)) ok = false;
+    freeGameAnalytics(&analytics);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    long games = 0;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = (uint64_t)time(NULL);
+    const char *csvPath = NULL;
+    const char *jsonPath = NULL;
+    const char **paths = (const char**)calloc(argc, sizeof(char*));
+    int pathCount = 0;
+    GameConfig config = { BOARD_SIZE, BOARD_SIZE, { AI_DENSITY, AI_DENSITY }, NULL, NULL, NULL, NULL };
+    MonteCarloConfig monteCarlo = { 1, MONTE_CARLO_SAMPLES, 0 };
+
+    if (paths == NULL) return EXIT_FAILURE;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--simulate") == 0 && i + 1 < argc) {
+            games = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            config.width = config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            config.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            config.height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ai1") == 0 && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &config.strategies[0])) {
+                free(paths);
+                return EXIT_FAILURE;
+            }
+        } else if ((strcmp(argv[i], "--ai2") == 0 || strcmp(argv[i], "--ai") == 0) && i + 1 < argc) {
+            if (!parseAiStrategy(argv[++i], &config.strategies[1])) {
+                free(paths);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--mc-samples") == 0 && i + 1 < argc) {
+            monteCarlo.samples = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (argv[i][0] != '-') {
+            paths[pathCount++] = argv[i];
+        } else {
+            printUsage(argv[0]);
+            free(paths);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((games > 0) == (pathCount > 0)) {
+        printUsage(argv[0]);
+        free(paths);
+        return EXIT_FAILURE;
+    }
+
+    int status = runAnalytics(games, threads, seed, &config, &monteCarlo, paths, pathCount, csvPath, jsonPath);
+    free(paths);
+    return status;
+}
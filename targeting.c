@@ -0,0 +1,446 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "targeting.h"
+#include "instrument.h"
+#include "bitboard.h"
+#include "zobrist.h"
+
+// Extra weight of a placement per hit it covers. A placement through a hit must
+// outweigh any box seen while hunting, which is at most 2 * MAX_BOATS * length.
+#define HIT_BONUS 100
+
+// Taken off the density of a box once it is targeted, so that it never wins
+// again while the placements through it keep their bookkeeping.
+#define TARGETED_PENALTY (1 << 30)
+
+// Function to read a strategy from its command line name
+bool parseAiStrategy(const char *name, AiStrategy *strategy) {
+    if (strcmp(name, "random") == 0) {
+        *strategy = AI_RANDOM;
+    } else if (strcmp(name, "density") == 0) {
+        *strategy = AI_DENSITY;
+    } else if (strcmp(name, "montecarlo") == 0) {
+        *strategy = AI_MONTE_CARLO;
+    } else if (strcmp(name, "exact") == 0) {
+        *strategy = AI_EXACT;
+    } else {
+        fprintf(stderr, "Unknown strategy '%s'.\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Function to give the command line name of a strategy
+const char *aiStrategyName(AiStrategy strategy) {
+    switch (strategy) {
+        case AI_RANDOM:
+            return "random";
+        case AI_DENSITY:
+            return "density";
+        case AI_MONTE_CARLO:
+            return "montecarlo";
+        case AI_EXACT:
+            return "exact";
+        default:
+            return "unknown";
+    }
+}
+
+// Placement p = (lengthIndex * 2 + orientation) * cells + first cell.
+static int placementIndex(const Targeter *targeter, int lengthIndex, Orientation orientation, int cell) {
+    return (lengthIndex * 2 + (orientation == VERTICAL)) * targeter->cells + cell;
+}
+
+static int32_t placementWeight(const Targeter *targeter, int lengthIndex, int placement) {
+    return targeter->boatsOfLength[lengthIndex] * (1 + HIT_BONUS * targeter->hits[placement]);
+}
+
+// Adds `delta` to the density of every box of the placement starting at (x, y)
+// and marks the rows it crosses for the next choice.
+static void spreadDensity(Targeter *targeter, int length, int x, int y, Orientation orientation, int32_t delta) {
+    int32_t *density = targeter->density + y * targeter->width + x;
+
+    if (orientation == HORIZONTAL) {
+        for (int i = 0; i < length; i++) {
+            density[i] += delta;
+        }
+        targeter->rowDirty[y] = 1;
+    } else {
+        for (int i = 0; i < length; i++) {
+            density[i * targeter->width] += delta;
+            targeter->rowDirty[y + i] = 1;
+        }
+    }
+}
+
+// The fleet is public, as in the classic rules: only its lengths are used.
+static void countFleetLengths(Targeter *targeter, const Boat *fleet, int count) {
+    targeter->lengthCount = 0;
+    memset(targeter->boatsOfLength, 0, sizeof(targeter->boatsOfLength));
+    for (int i = 0; i < count; i++) {
+        int l = 0;
+        while (l < targeter->lengthCount && targeter->lengths[l] != fleet[i].size) l++;
+        if (l == targeter->lengthCount) {
+            targeter->lengths[l] = fleet[i].size;
+            targeter->lengthCount++;
+        }
+        targeter->boatsOfLength[l]++;
+    }
+}
+
+// Placements followed by a density targeter, per length, orientation and first cell.
+static size_t placementCount(const Targeter *targeter) {
+    return (size_t)targeter->lengthCount * 2 * targeter->cells;
+}
+
+// Room for the placements of any fleet, so that a reset may bring one with
+// more distinct lengths.
+static size_t placementCapacity(const Targeter *targeter) {
+    return (size_t)MAX_BOATS * 2 * targeter->cells;
+}
+
+bool initializeTargeter(Targeter *targeter, AiStrategy strategy, int width, int height,
+                        const Boat *fleet, int count, Arena *arena) {
+    memset(targeter, 0, sizeof(Targeter));
+    targeter->strategy = strategy;
+    targeter->width = width;
+    targeter->height = height;
+    targeter->cells = width * height;
+    countFleetLengths(targeter, fleet, count);
+
+    if (strategy == AI_MONTE_CARLO || strategy == AI_EXACT) {
+        int words = bitboardWords(targeter->cells);
+        targeter->misses = (uint64_t*)arenaCalloc(arena, 3 * words, sizeof(uint64_t));
+        if (targeter->misses == NULL) {
+            fprintf(stderr, "Memory allocation failed for targeter.\n");
+            return false;
+        }
+        targeter->openHits = targeter->misses + words;
+        targeter->sunkZone = targeter->openHits + words;
+    } else if (strategy == AI_DENSITY) {
+        size_t placements = placementCapacity(targeter);
+        targeter->density = (int32_t*)arenaCalloc(arena, targeter->cells, sizeof(int32_t));
+        targeter->valid = (uint8_t*)arenaCalloc(arena, placements, sizeof(uint8_t));
+        targeter->hits = (uint8_t*)arenaCalloc(arena, placements, sizeof(uint8_t));
+        targeter->rowBest = (int32_t*)arenaCalloc(arena, height, sizeof(int32_t));
+        targeter->rowTies = (uint32_t*)arenaCalloc(arena, height, sizeof(uint32_t));
+        targeter->rowDirty = (uint8_t*)arenaCalloc(arena, height, sizeof(uint8_t));
+        if (!targeter->density || !targeter->valid || !targeter->hits
+            || !targeter->rowBest || !targeter->rowTies || !targeter->rowDirty) {
+            fprintf(stderr, "Memory allocation failed for targeter.\n");
+            return false;
+        }
+    }
+    return resetTargeter(targeter, fleet, count);
+}
+
+// Function to bring the targeter back to the start of a game against `fleet`,
+// in the memory it already has. The fleet must have the lengths it was
+// initialized with.
+bool resetTargeter(Targeter *targeter, const Boat *fleet, int count) {
+    int width = targeter->width;
+    int height = targeter->height;
+
+    if (!ownTargeter(targeter)) return false;
+    countFleetLengths(targeter, fleet, count);
+    targeter->hash = zobristKey(ZOBRIST_SETTING, (uint64_t)targeter->strategy | (uint64_t)width << 8
+                                                 | (uint64_t)height << 32);
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        targeter->hash ^= zobristKey(ZOBRIST_FLEET, (uint64_t)targeter->lengths[l] << 8 | targeter->boatsOfLength[l]);
+    }
+    if (targeter->strategy == AI_RANDOM) return true; // Nothing else to track
+
+    if (targeter->strategy == AI_MONTE_CARLO || targeter->strategy == AI_EXACT) {
+        memset(targeter->misses, 0, 3 * bitboardWords(targeter->cells) * sizeof(uint64_t));
+        return true;
+    }
+
+    memset(targeter->density, 0, targeter->cells * sizeof(int32_t));
+    memset(targeter->valid, 0, placementCount(targeter));
+    memset(targeter->hits, 0, placementCount(targeter));
+
+    // Every placement that fits on the board is possible before the first shot.
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        int length = targeter->lengths[l];
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int cell = y * width + x;
+                if (x + length <= width) {
+                    int p = placementIndex(targeter, l, HORIZONTAL, cell);
+                    targeter->valid[p] = 1;
+                    spreadDensity(targeter, length, x, y, HORIZONTAL, placementWeight(targeter, l, p));
+                }
+                if (y + length <= height) {
+                    int p = placementIndex(targeter, l, VERTICAL, cell);
+                    targeter->valid[p] = 1;
+                    spreadDensity(targeter, length, x, y, VERTICAL, placementWeight(targeter, l, p));
+                }
+            }
+        }
+    }
+    memset(targeter->rowDirty, 1, height);
+    return true;
+}
+
+// Function to make `targeter` a copy of `source` that shares its arrays: from
+// then on, each of them copies the arrays into its own arena (`arena` and
+// `sourceArena`) before it observes a shot. The row caches, written by every
+// choice, are copied right away.
+bool shareTargeter(Targeter *targeter, Targeter *source, Arena *arena, Arena *sourceArena) {
+    *targeter = *source;
+    if (source->strategy == AI_RANDOM) return true;  // No arrays
+    targeter->copyOnWrite = arena;
+    if (source->copyOnWrite == NULL) source->copyOnWrite = sourceArena;
+    if (source->strategy != AI_DENSITY) return true;
+
+    int height = source->height;
+    targeter->rowBest = (int32_t*)arenaAlloc(arena, height * (sizeof(int32_t) + sizeof(uint32_t) + 1));
+    if (targeter->rowBest == NULL) {
+        fprintf(stderr, "Memory allocation failed for targeter.\n");
+        return false;
+    }
+    targeter->rowTies = (uint32_t*)(targeter->rowBest + height);
+    targeter->rowDirty = (uint8_t*)(targeter->rowTies + height);
+    memcpy(targeter->rowBest, source->rowBest, height * sizeof(int32_t));
+    memcpy(targeter->rowTies, source->rowTies, height * sizeof(uint32_t));
+    memcpy(targeter->rowDirty, source->rowDirty, height);
+    return true;
+}
+
+// Function to give the targeter arrays of its own before it observes a shot,
+// when it shares them with the targeters it was forked from or into.
+bool ownTargeter(Targeter *targeter) {
+    Arena *arena = targeter->copyOnWrite;
+    if (arena == NULL) return true;
+
+    if (targeter->strategy == AI_MONTE_CARLO || targeter->strategy == AI_EXACT) {
+        int words = bitboardWords(targeter->cells);
+        uint64_t *misses = (uint64_t*)arenaAlloc(arena, 3 * words * sizeof(uint64_t));
+        if (misses == NULL) {
+            fprintf(stderr, "Memory allocation failed for targeter.\n");
+            return false;
+        }
+        memcpy(misses, targeter->misses, 3 * words * sizeof(uint64_t));
+        targeter->misses = misses;
+        targeter->openHits = misses + words;
+        targeter->sunkZone = misses + 2 * words;
+    } else {
+        size_t placements = placementCount(targeter);
+        size_t capacity = placementCapacity(targeter);
+        int32_t *density = (int32_t*)arenaAlloc(arena, targeter->cells * sizeof(int32_t));
+        uint8_t *valid = (uint8_t*)arenaAlloc(arena, 2 * capacity);
+        if (density == NULL || valid == NULL) {
+            fprintf(stderr, "Memory allocation failed for targeter.\n");
+            return false;
+        }
+        memcpy(density, targeter->density, targeter->cells * sizeof(int32_t));
+        memcpy(valid, targeter->valid, placements);
+        memcpy(valid + capacity, targeter->hits, placements);
+        targeter->density = density;
+        targeter->valid = valid;
+        targeter->hits = valid + capacity;
+    }
+    targeter->copyOnWrite = NULL;
+    return true;
+}
+
+// Function to pick the untargeted box of highest density, ties broken at random.
+// Only the rows touched since the last choice are scanned again.
+void chooseTargetedShot(Targeter *targeter, Rng *rng, int *x, int *y) {
+    int width = targeter->width;
+    int32_t best = INT32_MIN;
+    uint32_t ties = 0;
+
+    for (int row = 0; row < targeter->height; row++) {
+        if (targeter->rowDirty[row]) {
+            // Targeted boxes sit far below zero, so one pass finds the best
+            // untargeted value of the row and how many boxes share it.
+            const int32_t *density = targeter->density + row * width;
+            int32_t rowBest = INT32_MIN;
+            INSTRUMENT_COUNT(COUNT_CELLS_SCANNED, width);
+            uint32_t rowTies = 0;
+
+            for (int i = 0; i < width; i++) {
+                if (density[i] > rowBest) {
+                    rowBest = density[i];
+                    rowTies = 0;
+                }
+                rowTies += density[i] == rowBest;
+            }
+            targeter->rowBest[row] = rowBest;
+            targeter->rowTies[row] = rowTies;
+            targeter->rowDirty[row] = 0;
+        }
+
+        if (targeter->rowBest[row] > best) {
+            best = targeter->rowBest[row];
+            ties = 0;
+        }
+        if (targeter->rowBest[row] == best) ties += targeter->rowTies[row];
+    }
+
+    // Walk to the k-th box of best density, skipping whole rows first.
+    uint32_t k = randomBelow(rng, ties);
+    int row = 0;
+    while (targeter->rowBest[row] != best || k >= targeter->rowTies[row]) {
+        if (targeter->rowBest[row] == best) k -= targeter->rowTies[row];
+        row++;
+    }
+    const int32_t *density = targeter->density + row * width;
+    int column = 0;
+    while (density[column] != best || k-- > 0) column++;
+
+    *x = column;
+    *y = row;
+}
+
+static void discardPlacement(Targeter *targeter, int lengthIndex, int x, int y, Orientation orientation) {
+    int p = placementIndex(targeter, lengthIndex, orientation, y * targeter->width + x);
+
+    if (targeter->valid[p]) {
+        targeter->valid[p] = 0;
+        spreadDensity(targeter, targeter->lengths[lengthIndex], x, y, orientation,
+                      -placementWeight(targeter, lengthIndex, p));
+    }
+}
+
+// Discards the placements meeting the boxes [x0, x1] x [y0, y1], but not those
+// covering box (keepX, keepY). Each placement is visited once.
+static void discardPlacementsMeeting(Targeter *targeter, int x0, int y0, int x1, int y1, int keepX, int keepY) {
+    int width = targeter->width;
+    int height = targeter->height;
+
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        int length = targeter->lengths[l];
+        int first = x0 - length + 1 > 0 ? x0 - length + 1 : 0;
+        int last = x1 < width - length ? x1 : width - length;
+
+        // Horizontal placements starting in columns first..last of rows y0..y1.
+        for (int y = y0; y <= y1; y++) {
+            for (int x = first; x <= last; x++) {
+                if (y == keepY && keepX >= x && keepX < x + length) continue;
+                discardPlacement(targeter, l, x, y, HORIZONTAL);
+            }
+        }
+
+        // Vertical placements starting in rows first..last of columns x0..x1.
+        first = y0 - length + 1 > 0 ? y0 - length + 1 : 0;
+        last = y1 < height - length ? y1 : height - length;
+        for (int y = first; y <= last; y++) {
+            for (int x = x0; x <= x1; x++) {
+                if (x == keepX && keepY >= y && keepY < y + length) continue;
+                discardPlacement(targeter, l, x, y, VERTICAL);
+            }
+        }
+    }
+}
+
+// Adds a hit to every possible placement covering box (x, y).
+static void reinforcePlacementsThrough(Targeter *targeter, int x, int y) {
+    int width = targeter->width;
+    int height = targeter->height;
+
+    for (int l = 0; l < targeter->lengthCount; l++) {
+        int length = targeter->lengths[l];
+        int32_t bonus = targeter->boatsOfLength[l] * HIT_BONUS;
+
+        for (int k = 0; k < length; k++) {
+            if (x - k >= 0 && x - k + length <= width) {
+                int p = placementIndex(targeter, l, HORIZONTAL, y * width + x - k);
+                if (targeter->valid[p]) {
+                    targeter->hits[p]++;
+                    spreadDensity(targeter, length, x - k, y, HORIZONTAL, bonus);
+                }
+            }
+            if (y - k >= 0 && y - k + length <= height) {
+                int p = placementIndex(targeter, l, VERTICAL, (y - k) * width + x);
+                if (targeter->valid[p]) {
+                    targeter->hits[p]++;
+                    spreadDensity(targeter, length, x, y - k, VERTICAL, bonus);
+                }
+            }
+        }
+    }
+}
+
+// Function to update the position key and the densities after a shot at (x, y)
+void observeShot(Targeter *targeter, int x, int y, ShotResult result) {
+    if (result != SHOT_MISS && result != SHOT_HIT && result != SHOT_SUNK) return;
+    if (!ownTargeter(targeter)) return;
+    targeter->hash ^= zobristKey(result == SHOT_MISS ? ZOBRIST_MISS : ZOBRIST_HIT, y * targeter->width + x);
+    if (targeter->strategy == AI_RANDOM) return;
+    if (targeter->strategy == AI_MONTE_CARLO || targeter->strategy == AI_EXACT) {
+        bitSet(result == SHOT_MISS ? targeter->misses : targeter->openHits, y * targeter->width + x);
+        return;
+    }
+
+    targeter->density[y * targeter->width + x] -= TARGETED_PENALTY;
+    targeter->rowDirty[y] = 1;
+
+    if (result == SHOT_MISS) {
+        // No boat goes through a miss.
+        discardPlacementsMeeting(targeter, x, y, x, y, -1, -1);
+        return;
+    }
+
+    // The boat that was hit covers this box, and no other boat may touch it.
+    int lastX = targeter->width - 1;
+    int lastY = targeter->height - 1;
+    reinforcePlacementsThrough(targeter, x, y);
+    discardPlacementsMeeting(targeter, x > 0 ? x - 1 : 0, y > 0 ? y - 1 : 0,
+                             x < lastX ? x + 1 : lastX, y < lastY ? y + 1 : lastY, x, y);
+}
+
+// Function to forget a boat once it is announced sunk: nothing else lies on or
+// around its cells, and one boat fewer of its length is left to find.
+void observeSunk(Targeter *targeter, const Boat *boat) {
+    if (!ownTargeter(targeter)) return;
+    for (int i = 0; i < boat->size; i++) {
+        int cell = boat->orientation == HORIZONTAL ? boat->y * targeter->width + boat->x + i
+                                                   : (boat->y + i) * targeter->width + boat->x;
+        targeter->hash ^= zobristKey(ZOBRIST_HIT, cell) ^ zobristKey(ZOBRIST_SUNK, cell);
+    }
+    if (targeter->strategy == AI_RANDOM) return;
+
+    int width = boat->orientation == HORIZONTAL ? boat->size : 1;
+    int height = boat->orientation == VERTICAL ? boat->size : 1;
+    int x1 = boat->x + width < targeter->width ? boat->x + width : targeter->width - 1;
+    int y1 = boat->y + height < targeter->height ? boat->y + height : targeter->height - 1;
+    int l = 0;
+    while (l < targeter->lengthCount && targeter->lengths[l] != boat->size) l++;
+
+    if (targeter->strategy == AI_MONTE_CARLO || targeter->strategy == AI_EXACT) {
+        int x0 = boat->x > 0 ? boat->x - 1 : 0;
+        for (int y = boat->y > 0 ? boat->y - 1 : 0; y <= y1; y++) {
+            bitRangeSet(targeter->sunkZone, y * targeter->width + x0, x1 - x0 + 1);
+        }
+        for (int i = 0; i < boat->size; i++) {
+            int cell = boat->orientation == HORIZONTAL ? boat->y * targeter->width + boat->x + i
+                                                       : (boat->y + i) * targeter->width + boat->x;
+            bitClear(targeter->openHits, cell);
+        }
+        if (l < targeter->lengthCount && targeter->boatsOfLength[l] > 0) targeter->boatsOfLength[l]--;
+        return;
+    }
+
+    discardPlacementsMeeting(targeter, boat->x > 0 ? boat->x - 1 : 0, boat->y > 0 ? boat->y - 1 : 0,
+                             x1, y1, -1, -1);
+
+    if (l == targeter->lengthCount || targeter->boatsOfLength[l] == 0) return;
+
+    // Every placement of that length loses the share of the sunk boat.
+    targeter->boatsOfLength[l]--;
+    for (int orientation = 0; orientation < 2; orientation++) {
+        Orientation o = orientation ? VERTICAL : HORIZONTAL;
+        for (int cell = 0; cell < targeter->cells; cell++) {
+            int p = placementIndex(targeter, l, o, cell);
+            if (targeter->valid[p]) {
+                if (targeter->boatsOfLength[l] == 0) targeter->valid[p] = 0;
+                spreadDensity(targeter, boat->size, cell % targeter->width, cell / targeter->width, o,
+                              -(1 + HIT_BONUS * targeter->hits[p]));
+            }
+        }
+    }
+}
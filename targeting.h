@@ -0,0 +1,79 @@
+#ifndef TARGETING_H
+#define TARGETING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "boat.h"
+#include "rng.h"
+#include "arena.h"
+
+typedef enum {
+    AI_RANDOM,      // Uniform over the boxes not targeted yet
+    AI_DENSITY,     // Box covered by the most boat placements still possible
+    AI_MONTE_CARLO, // Box holding a boat in the most sampled fleets, see montecarlo.h
+    AI_EXACT,       // Box holding a boat in the most possible fleets, all counted, see exact.h
+} AiStrategy;
+
+typedef struct MonteCarlo MonteCarlo;
+typedef struct ExactAnalysis ExactAnalysis;
+typedef struct TranspositionTable TranspositionTable;
+typedef struct OpeningBook OpeningBook;
+
+// What a computer player knows about the board it shoots at.
+//
+// For AI_DENSITY, every placement (length, orientation, first cell) of the
+// opponent's boats is kept as long as it agrees with the shots seen so far:
+// it covers no miss and does not touch a hit it does not cover, since boats
+// never touch. The density of a box is the weight of the placements covering
+// it, a placement weighing more for every hit it covers. A shot only revisits
+// the placements around the box it landed on. A sunk boat removes every
+// placement on or around it and lowers the count of its length. Each row
+// caches its best density so that a choice only rescans the rows that changed.
+//
+// For AI_MONTE_CARLO and AI_EXACT, only the shots are kept, as bit masks that
+// the sampler of the engine draws fleets against, or that the exact analysis
+// counts them against.
+//
+// Forked targeters share their arrays until one of them observes a shot, at
+// which point it copies them (see forkGame in game.h).
+//
+// Whatever the strategy, `hash` is the Zobrist key of the position (see
+// zobrist.h), under which the opening book and the transposition table keep
+// the shot the strategy chose there.
+typedef struct {
+    AiStrategy strategy;
+    int width;                  // Board dimensions
+    int height;
+    int cells;
+    int lengthCount;            // Distinct boat lengths in the opponent's fleet
+    int lengths[MAX_BOATS];
+    int boatsOfLength[MAX_BOATS];
+    int32_t *density;           // Per box, far below zero once targeted
+    uint8_t *valid;             // Per placement: still possible
+    uint8_t *hits;              // Per placement: hits it covers
+    int32_t *rowBest;           // Per row: highest density
+    uint32_t *rowTies;          // Per row: boxes reaching rowBest
+    uint8_t *rowDirty;          // Per row: density changed since rowBest was computed
+    uint64_t *misses;           // AI_MONTE_CARLO and AI_EXACT: boxes shot in the water
+    uint64_t *openHits;         // Boxes hit on boats not sunk yet
+    uint64_t *sunkZone;         // Boxes of the sunk boats and around them
+    MonteCarlo *monteCarlo;     // Engine sampling the fleets, shared by the targeters of a thread
+    ExactAnalysis *exact;       // Engine counting the fleets, likewise
+    uint64_t hash;              // Zobrist key of the strategy, the board size, the fleet and the shots seen
+    const OpeningBook *book;    // Shots of the early positions, NULL for none
+    TranspositionTable *transpositions; // Shots of the positions met lately, NULL for none
+    Arena *copyOnWrite;         // Arena to copy the arrays into before the next observation, NULL when owned
+} Targeter;
+
+bool parseAiStrategy(const char *name, AiStrategy *strategy);
+const char *aiStrategyName(AiStrategy strategy);
+bool initializeTargeter(Targeter *targeter, AiStrategy strategy, int width, int height,
+                        const Boat *fleet, int count, Arena *arena);
+bool resetTargeter(Targeter *targeter, const Boat *fleet, int count);
+bool shareTargeter(Targeter *targeter, Targeter *source, Arena *arena, Arena *sourceArena);
+bool ownTargeter(Targeter *targeter);
+void chooseTargetedShot(Targeter *targeter, Rng *rng, int *x, int *y);
+void observeShot(Targeter *targeter, int x, int y, ShotResult result);
+void observeSunk(Targeter *targeter, const Boat *boat);
+
+#endif // TARGETING_H
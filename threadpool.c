@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "threadpool.h"
+
+// Chunks still to run for one worker. Each queue sits on its own cache line
+// because the owner and the thieves all take chunks with the same counter.
+typedef struct {
+    _Alignas(64) atomic_long next;  // Next chunk to hand out
+    long end;                       // One past the last chunk of this queue
+} WorkQueue;
+
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} WorkerSlot;
+
+struct ThreadPool {
+    int threads;            // Workers, the calling thread being worker 0
+    pthread_t *handles;
+    WorkerSlot *slots;
+    WorkQueue *queues;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;    // Signals a new job or the shutdown
+    pthread_cond_t done;    // Signals that the background workers finished
+    unsigned long generation;
+    int running;
+    bool stopping;
+
+    // Current job
+    long count;
+    long grain;
+    ThreadTask task;
+    void *context;
+};
+
+static bool takeChunk(WorkQueue *queue, long *chunk) {
+    // Cheap check first so that empty queues are not hammered by thieves.
+    if (atomic_load_explicit(&queue->next, memory_order_relaxed) >= queue->end) return false;
+    *chunk = atomic_fetch_add_explicit(&queue->next, 1, memory_order_relaxed);
+    return *chunk < queue->end;
+}
+
+static void work(ThreadPool *pool, int worker) {
+    long chunk;
+
+    // Drain our own queue, then steal from the others in turn.
+    for (int i = 0; i < pool->threads; i++) {
+        WorkQueue *queue = &pool->queues[(worker + i) % pool->threads];
+        while (takeChunk(queue, &chunk)) {
+            long begin = chunk * pool->grain;
+            long end = begin + pool->grain < pool->count ? begin + pool->grain : pool->count;
+            pool->task(pool->context, worker, begin, end);
+        }
+    }
+}
+
+static void *workerMain(void *arg) {
+    WorkerSlot *slot = (WorkerSlot*)arg;
+    ThreadPool *pool = slot->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stopping) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        work(pool, slot->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool *createThreadPool(int threads) {
+    if (threads < 1) threads = 1;
+
+    ThreadPool *pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        fprintf(stderr, "Memory allocation failed for thread pool.\n");
+        return NULL;
+    }
+    pool->threads = threads;
+    pool->handles = (pthread_t*)calloc(threads, sizeof(pthread_t));
+    pool->slots = (WorkerSlot*)calloc(threads, sizeof(WorkerSlot));
+    pool->queues = (WorkQueue*)aligned_alloc(64, threads * sizeof(WorkQueue));
+    if (pool->handles == NULL || pool->slots == NULL || pool->queues == NULL) {
+        fprintf(stderr, "Memory allocation failed for thread pool.\n");
+        free(pool->handles);
+        free(pool->slots);
+        free(pool->queues);
+        free(pool);
+        return NULL;
+    }
+    for (int i = 0; i < threads; i++) {
+        atomic_init(&pool->queues[i].next, 0);
+        pool->queues[i].end = 0;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Worker 0 is whoever calls runThreadPool, only the others get a thread.
+    for (int i = 1; i < threads; i++) {
+        pool->slots[i].pool = pool;
+        pool->slots[i].index = i;
+        if (pthread_create(&pool->handles[i], NULL, workerMain, &pool->slots[i]) != 0) {
+            fprintf(stderr, "Failed to start worker thread %d.\n", i);
+            pool->threads = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void freeThreadPool(ThreadPool *pool) {
+    if (pool) {
+        pthread_mutex_lock(&pool->lock);
+        pool->stopping = true;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (int i = 1; i < pool->threads; i++) {
+            pthread_join(pool->handles[i], NULL);
+        }
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->wake);
+        pthread_cond_destroy(&pool->done);
+        free(pool->handles);
+        free(pool->slots);
+        free(pool->queues);
+        free(pool);
+    }
+}
+
+int threadPoolSize(ThreadPool *pool) {
+    return pool->threads;
+}
+
+void runThreadPool(ThreadPool *pool, long count, long grain, ThreadTask task, void *context) {
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+
+    // Hand every worker a contiguous share of the chunks.
+    long chunks = (count + grain - 1) / grain;
+    for (int i = 0; i < pool->threads; i++) {
+        atomic_store_explicit(&pool->queues[i].next, chunks * i / pool->threads, memory_order_relaxed);
+        pool->queues[i].end = chunks * (i + 1) / pool->threads;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->count = count;
+    pool->grain = grain;
+    pool->task = task;
+    pool->context = context;
+    pool->running = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,17 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Persistent pool of worker threads running parallel loops over [0, count).
+// The range is cut in chunks of `grain` items and every worker starts on its
+// own share of chunks; a worker that runs out steals chunks from the others.
+
+typedef void (*ThreadTask)(void *context, int worker, long begin, long end);
+
+typedef struct ThreadPool ThreadPool;
+
+ThreadPool *createThreadPool(int threads);
+void freeThreadPool(ThreadPool *pool);
+int threadPoolSize(ThreadPool *pool);
+void runThreadPool(ThreadPool *pool, long count, long grain, ThreadTask task, void *context);
+
+#endif // THREADPOOL_H
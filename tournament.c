@@ -0,0 +1,363 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "tournament.h"
+#include "bitboard.h"
+#include "montecarlo.h"
+#include "exact.h"
+#include "threadpool.h"
+
+typedef struct {
+    _Alignas(64) Arena arena;
+    MonteCarlo **engines;   // Per entry, its engine when it is AI_MONTE_CARLO
+    ExactAnalysis *exact;   // Shared by the AI_EXACT entries
+    bool failed;
+} TournamentWorker;
+
+// What one task of a round adds to its matchup.
+typedef struct {
+    long halfPoints;
+    long squares;
+    long wins[2];
+    long winnerShots[2];
+} TournamentChunk;
+
+typedef struct {
+    const TournamentConfig *config;
+    const TournamentEntry *entries;
+    TournamentWorker *workers;
+    Matchup *matchups;
+    int *open;              // Matchups playing this round
+    long *roundPairs;       // Per open matchup, pairs of this round
+    TournamentChunk *chunks;    // Per task
+} TournamentJob;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Function of the "hunt" and "parity" strategies: shoot next to a hit on a
+// boat still afloat, in line with a second hit when there is one, and
+// otherwise at random, on one color of the checkerboard only for "parity"
+// since no boat is shorter than two boxes.
+static void huntShot(GameBoard *target, Rng *rng, bool parity, int *x, int *y) {
+    static const int dx[4] = { 1, -1, 0, 0 };
+    static const int dy[4] = { 0, 0, 1, -1 };
+    uint32_t seen[2] = { 0, 0 };    // Candidates in line with a hit, next to one
+
+    for (int i = 0; i < target->words; i++) {
+        for (uint64_t bits = target->wrecks[i]; bits; bits &= bits - 1) {
+            int cell = i * 64 + __builtin_ctzll(bits);
+            int hitX = cell % target->width, hitY = cell / target->width;
+            if (!isBoatAlive(boatAt(target, hitX, hitY))) continue;
+
+            for (int d = 0; d < 4; d++) {
+                int nx = hitX + dx[d], ny = hitY + dy[d];
+                if (!isOnBoard(target, nx, ny) || isAlreadyTargeted(target, nx, ny)) continue;
+                // The box behind the hit, on the other side, is a hit as well.
+                int bx = hitX - dx[d], by = hitY - dy[d];
+                int rank = isOnBoard(target, bx, by) && boardCase(target, bx, by) == WRECK ? 0 : 1;
+                if (seen[0] > 0 && rank == 1) continue;
+                // Reservoir sampling within the best rank met so far.
+                if (rank == 0 && seen[0] == 0) seen[1] = 0;
+                if (randomBelow(rng, ++seen[rank]) == 0) {
+                    *x = nx;
+                    *y = ny;
+                }
+            }
+        }
+    }
+    if (seen[0] > 0 || seen[1] > 0) return;
+
+    uint32_t legal = 0;
+    for (int pass = parity ? 0 : 1; pass < 2 && legal == 0; pass++) {
+        for (int cell = 0; cell < target->cellCount; cell++) {
+            int cx = cell % target->width, cy = cell / target->width;
+            if (bitTest(target->shots, cell) || (pass == 0 && (cx + cy) % 2 != 0)) continue;
+            if (randomBelow(rng, ++legal) == 0) {
+                *x = cx;
+                *y = cy;
+            }
+        }
+    }
+}
+
+static void chooseHuntShot(void *context, GameBoard *target, Targeter *targeting, Rng *rng, int *x, int *y) {
+    (void)context;
+    (void)targeting;
+    huntShot(target, rng, false, x, y);
+}
+
+static void chooseParityShot(void *context, GameBoard *target, Targeter *targeting, Rng *rng, int *x, int *y) {
+    (void)context;
+    (void)targeting;
+    huntShot(target, rng, true, x, y);
+}
+
+// Function to fill `entry` from a strategy name: the names of parseAiStrategy,
+// "montecarlo:N" for N fleets drawn per move, "hunt" and "parity".
+bool parseTournamentEntry(const char *name, long samples, TournamentEntry *entry) {
+    memset(entry, 0, sizeof(TournamentEntry));
+    entry->name = name;
+    entry->samples = samples;
+    if (strncmp(name, "montecarlo:", 11) == 0) {
+        entry->strategy = AI_MONTE_CARLO;
+        entry->samples = strtol(name + 11, NULL, 10);
+        if (entry->samples <= 0) {
+            fprintf(stderr, "Invalid sample count in '%s'.\n", name);
+            return false;
+        }
+    } else if (strcmp(name, "hunt") == 0) {
+        entry->strategy = AI_RANDOM;
+        entry->choose = chooseHuntShot;
+    } else if (strcmp(name, "parity") == 0) {
+        entry->strategy = AI_RANDOM;
+        entry->choose = chooseParityShot;
+    } else {
+        return parseAiStrategy(name, &entry->strategy);
+    }
+    return true;
+}
+
+// Function to play one game, `sides[0]` moving first. Returns the side that
+// won, or -1 when the game could not be played.
+static int playTournamentGame(const TournamentJob *job, TournamentWorker *worker, const int sides[2],
+                              uint64_t seed, long *winnerShots) {
+    const TournamentEntry *entries[2] = { &job->entries[sides[0]], &job->entries[sides[1]] };
+    MonteCarlo *engines[2] = { worker->engines[sides[0]], worker->engines[sides[1]] };
+    GameConfig config = { job->config->width, job->config->height, { entries[0]->strategy, entries[1]->strategy },
+                          engines[0] ? engines[0] : engines[1], worker->exact, NULL, NULL };
+
+    resetArena(&worker->arena);
+    Game *game = initializeGame(&config, seed, &worker->arena);
+    if (game == NULL) return -1;
+    game->player1Targeting.monteCarlo = engines[0];
+    game->player2Targeting.monteCarlo = engines[1];
+
+    GameBoard *targets[2] = { &game->player2Board, &game->player1Board };
+    Targeter *targeting[2] = { &game->player1Targeting, &game->player2Targeting };
+    long shots[2] = { 0, 0 };
+    int x, y;
+    for (int turn = 0; ; turn ^= 1) {
+        if (shots[turn]++ >= targets[turn]->cellCount) return -1;
+        if (entries[turn]->choose) {
+            entries[turn]->choose(entries[turn]->context, targets[turn], targeting[turn], &game->rng, &x, &y);
+        } else {
+            chooseComputerShot(targets[turn], targeting[turn], &game->rng, &x, &y);
+        }
+
+        // A chooser that shoots off the board or twice at a box is broken.
+        ShotResult result = shootAt(targets[turn], x, y);
+        if (result == SHOT_INVALID || result == SHOT_ALREADY_TARGETED) return -1;
+        observeShot(targeting[turn], x, y, result);
+        if (result == SHOT_SUNK) observeSunk(targeting[turn], boatAt(targets[turn], x, y));
+        if (isGameOver(targets[turn])) {
+            *winnerShots = shots[turn];
+            return turn;
+        }
+    }
+}
+
+static void playRange(void *context, int worker, long begin, long end) {
+    TournamentJob *job = (TournamentJob*)context;
+    TournamentWorker *mine = &job->workers[worker];
+    int chunksPerRound = TOURNAMENT_ROUND_PAIRS / TOURNAMENT_CHUNK_PAIRS;
+
+    for (long task = begin; task < end && !mine->failed; task++) {
+        int open = (int)(task / chunksPerRound);
+        const Matchup *matchup = &job->matchups[job->open[open]];
+        TournamentChunk *chunk = &job->chunks[task];
+        long first = matchup->pairs + task % chunksPerRound * TOURNAMENT_CHUNK_PAIRS;
+        long last = first + TOURNAMENT_CHUNK_PAIRS;
+        if (last > matchup->pairs + job->roundPairs[open]) last = matchup->pairs + job->roundPairs[open];
+
+        memset(chunk, 0, sizeof(TournamentChunk));
+        for (long pair = first; pair < last; pair++) {
+            uint64_t seed = streamSeed(job->config->seed, pair);
+            int points = 0;
+            // Same fleets, sides swapped: entry s of the matchup moves first in game s.
+            for (int s = 0; s < 2; s++) {
+                int sides[2] = { s == 0 ? matchup->first : matchup->second, s == 0 ? matchup->second : matchup->first };
+                long shots;
+                int winner = playTournamentGame(job, mine, sides, seed, &shots);
+                if (winner < 0) {
+                    mine->failed = true;
+                    return;
+                }
+                int entry = winner ^ s;     // 0 for the matchup's first entry
+                chunk->wins[entry]++;
+                chunk->winnerShots[entry] += shots;
+                if (entry == 0) points++;
+            }
+            chunk->halfPoints += points;
+            chunk->squares += points * points;
+        }
+    }
+}
+
+// Function to tell whether the interval around the mean score of `matchup`
+// leaves out 1/2.
+static bool isDecided(const Matchup *matchup, double z) {
+    if (matchup->pairs < 2) return false;
+    double pairs = (double)matchup->pairs;
+    double mean = matchup->halfPoints / (2 * pairs);
+    double variance = (matchup->squares / (4 * pairs) - mean * mean) * pairs / (pairs - 1);
+    double margin = z * sqrt(variance > 0 ? variance / pairs : 0);
+    return fabs(mean - 0.5) > margin;
+}
+
+// Function to play every matchup of the entries. The result must be released
+// with freeTournamentResult, even on failure.
+bool runTournament(const TournamentConfig *config, const TournamentEntry *entries, int count,
+                   TournamentResult *result) {
+    memset(result, 0, sizeof(TournamentResult));
+    if (count < 2) {
+        fprintf(stderr, "A tournament needs two strategies at least.\n");
+        return false;
+    }
+    result->matchupCount = count * (count - 1) / 2;
+    result->matchups = (Matchup*)calloc(result->matchupCount, sizeof(Matchup));
+    if (result->matchups == NULL) {
+        fprintf(stderr, "Memory allocation failed for tournament.\n");
+        return false;
+    }
+    int m = 0;
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            result->matchups[m].first = i;
+            result->matchups[m++].second = j;
+        }
+    }
+
+    ThreadPool *pool = createThreadPool(config->threads);
+    if (pool == NULL) return false;
+    int threads = threadPoolSize(pool);
+    int chunksPerRound = TOURNAMENT_ROUND_PAIRS / TOURNAMENT_CHUNK_PAIRS;
+    TournamentJob job = { config, entries, NULL, result->matchups, NULL, NULL, NULL };
+    job.workers = (TournamentWorker*)aligned_alloc(64, threads * sizeof(TournamentWorker));
+    job.open = (int*)malloc(result->matchupCount * sizeof(int));
+    job.roundPairs = (long*)malloc(result->matchupCount * sizeof(long));
+    job.chunks = (TournamentChunk*)malloc((size_t)result->matchupCount * chunksPerRound * sizeof(TournamentChunk));
+    bool ok = job.workers && job.open && job.roundPairs && job.chunks;
+    if (!ok) {
+        fprintf(stderr, "Memory allocation failed for tournament.\n");
+        threads = 0;
+    }
+
+    // Each worker has its own engines, sampling on its own thread only.
+    bool exact = false;
+    for (int e = 0; e < count; e++) exact |= entries[e].strategy == AI_EXACT;
+    for (int i = 0; i < threads; i++) {
+        TournamentWorker *worker = &job.workers[i];
+        initializeArena(&worker->arena, 0);
+        worker->failed = false;
+        worker->exact = exact ? createExactAnalysis(config->width, config->height) : NULL;
+        worker->engines = (MonteCarlo**)calloc(count, sizeof(MonteCarlo*));
+        if ((exact && worker->exact == NULL) || worker->engines == NULL) worker->failed = true;
+        for (int e = 0; worker->engines && e < count; e++) {
+            if (entries[e].strategy != AI_MONTE_CARLO) continue;
+            MonteCarloConfig monteCarlo = { 1, entries[e].samples, 0 };
+            worker->engines[e] = createMonteCarlo(&monteCarlo, config->width, config->height);
+            if (worker->engines[e] == NULL) worker->failed = true;
+        }
+        if (worker->failed) ok = false;
+    }
+
+    double start = nowSeconds();
+    while (ok) {
+        int open = 0;
+        for (m = 0; m < result->matchupCount; m++) {
+            Matchup *matchup = &result->matchups[m];
+            if (matchup->decided || matchup->pairs >= config->maxPairs) continue;
+            job.roundPairs[open] = config->maxPairs - matchup->pairs < TOURNAMENT_ROUND_PAIRS
+                                   ? config->maxPairs - matchup->pairs : TOURNAMENT_ROUND_PAIRS;
+            job.open[open++] = m;
+        }
+        if (open == 0) break;
+
+        runThreadPool(pool, (long)open * chunksPerRound, 1, playRange, &job);
+        for (int i = 0; i < threads; i++) {
+            if (job.workers[i].failed) ok = false;
+        }
+
+        // Merge the chunks in order, then look at the intervals.
+        for (int o = 0; o < open && ok; o++) {
+            Matchup *matchup = &result->matchups[job.open[o]];
+            for (int c = 0; c < chunksPerRound; c++) {
+                const TournamentChunk *chunk = &job.chunks[o * chunksPerRound + c];
+                matchup->halfPoints += chunk->halfPoints;
+                matchup->squares += chunk->squares;
+                for (int s = 0; s < 2; s++) {
+                    matchup->wins[s] += chunk->wins[s];
+                    matchup->winnerShots[s] += chunk->winnerShots[s];
+                }
+            }
+            matchup->pairs += job.roundPairs[o];
+            result->games += 2 * job.roundPairs[o];
+            if (matchup->pairs >= config->minPairs && isDecided(matchup, config->z)) matchup->decided = true;
+        }
+    }
+    result->seconds = nowSeconds() - start;
+
+    for (int i = 0; i < threads; i++) {
+        freeArena(&job.workers[i].arena);
+        freeExactAnalysis(job.workers[i].exact);
+        for (int e = 0; job.workers[i].engines && e < count; e++) freeMonteCarlo(job.workers[i].engines[e]);
+        free(job.workers[i].engines);
+    }
+    free(job.workers);
+    free(job.open);
+    free(job.roundPairs);
+    free(job.chunks);
+    freeThreadPool(pool);
+
+    if (!ok) fprintf(stderr, "Some tournament games could not be played.\n");
+    return ok;
+}
+
+void printTournamentResult(const TournamentResult *result, const TournamentConfig *config,
+                           const TournamentEntry *entries, int count, FILE *out) {
+    fprintf(out, "Tournament:     %d strategies, %d matchups, %ld games in %.3f s (%.0f games/s)\n",
+            count, result->matchupCount, result->games, result->seconds,
+            result->seconds > 0 ? result->games / result->seconds : 0.0);
+    fprintf(out, "%-16s %-16s %7s %8s %8s  %s\n", "first", "second", "pairs", "score", "+/-", "verdict");
+    for (int m = 0; m < result->matchupCount; m++) {
+        const Matchup *matchup = &result->matchups[m];
+        if (matchup->pairs == 0) continue;
+        double pairs = (double)matchup->pairs;
+        double mean = matchup->halfPoints / (2 * pairs);
+        double variance = pairs > 1 ? (matchup->squares / (4 * pairs) - mean * mean) * pairs / (pairs - 1) : 0;
+        double margin = config->z * sqrt(variance > 0 ? variance / pairs : 0);
+        const char *verdict = !matchup->decided ? "undecided"
+                            : mean > 0.5 ? entries[matchup->first].name : entries[matchup->second].name;
+        fprintf(out, "%-16s %-16s %7ld %7.2f%% %7.2f%%  %s\n", entries[matchup->first].name,
+                entries[matchup->second].name, matchup->pairs, 100 * mean, 100 * margin, verdict);
+    }
+
+    // Standings: games won over all matchups, and the shots those wins took.
+    fprintf(out, "%-16s %8s %8s %9s %14s\n", "strategy", "games", "wins", "win rate", "shots to win");
+    for (int e = 0; e < count; e++) {
+        long games = 0, wins = 0, shots = 0;
+        for (int m = 0; m < result->matchupCount; m++) {
+            const Matchup *matchup = &result->matchups[m];
+            int side = matchup->first == e ? 0 : matchup->second == e ? 1 : -1;
+            if (side < 0) continue;
+            games += 2 * matchup->pairs;
+            wins += matchup->wins[side];
+            shots += matchup->winnerShots[side];
+        }
+        fprintf(out, "%-16s %8ld %8ld %8.2f%% %14.2f\n", entries[e].name, games, wins,
+                games ? 100.0 * wins / games : 0.0, wins ? (double)shots / wins : 0.0);
+    }
+}
+
+void freeTournamentResult(TournamentResult *result) {
+    if (result) {
+        free(result->matchups);
+        result->matchups = NULL;
+    }
+}
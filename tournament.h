@@ -0,0 +1,70 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "game.h"
+
+// Round robin between shot strategies. Every matchup plays pairs of games:
+// pair k of every matchup is dealt the fleets of seed streamSeed(seed, k), and
+// its two games swap the sides, so that both strategies shoot at the same two
+// fleets and both move first once. A pair scores 1, 1/2 or 0 for the first
+// strategy of the matchup.
+//
+// Matchups play rounds of TOURNAMENT_ROUND_PAIRS pairs, all of them at once
+// on the thread pool. Once a matchup has played minPairs pairs it stops as
+// soon as the interval of `z` standard errors around its mean score leaves
+// out 1/2, or at maxPairs. A round only depends on the seed, so the results do
+// not depend on the thread count.
+#define TOURNAMENT_ROUND_PAIRS 64
+#define TOURNAMENT_CHUNK_PAIRS 8    // Pairs of one task of a round
+
+// Function choosing the next shot at `target`, from what `targeting` has seen.
+// The board is only there for the public part of it: its shots, its wrecks and
+// which of its boats are sunk.
+typedef void (*ShotChooser)(void *context, GameBoard *target, Targeter *targeting, Rng *rng, int *x, int *y);
+
+typedef struct {
+    const char *name;
+    AiStrategy strategy;    // What the targeter keeps track of
+    long samples;           // Fleets drawn per move by an AI_MONTE_CARLO targeter
+    ShotChooser choose;     // NULL for the chooser of `strategy`
+    void *context;
+} TournamentEntry;
+
+typedef struct {
+    int width;
+    int height;
+    int threads;    // Worker threads, the calling thread included
+    uint64_t seed;
+    long minPairs;  // Pairs a matchup plays before it may stop
+    long maxPairs;  // Pairs a matchup plays at most
+    double z;       // Half width of the confidence intervals, in standard errors
+} TournamentConfig;
+
+typedef struct {
+    int first;          // Entries facing each other
+    int second;
+    long pairs;
+    long halfPoints;    // Sum of the first entry's pair scores, in halves
+    long squares;       // Sum of their squares, for the variance
+    long wins[2];       // Games won by each entry
+    long winnerShots[2];    // Shots each entry needed in the games it won
+    bool decided;       // The interval left 1/2 out before maxPairs
+} Matchup;
+
+typedef struct {
+    int matchupCount;
+    Matchup *matchups;
+    long games;
+    double seconds;
+} TournamentResult;
+
+bool parseTournamentEntry(const char *name, long samples, TournamentEntry *entry);
+bool runTournament(const TournamentConfig *config, const TournamentEntry *entries, int count,
+                   TournamentResult *result);
+void printTournamentResult(const TournamentResult *result, const TournamentConfig *config,
+                           const TournamentEntry *entries, int count, FILE *out);
+void freeTournamentResult(TournamentResult *result);
+
+#endif // TOURNAMENT_H
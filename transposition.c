@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "transposition.h"
+
+// Data word of an entry: the cell in the low 32 bits, then the flags. A free
+// entry is all zero, a used one always has TRANSPOSITION_USED.
+#define TRANSPOSITION_USED ((uint64_t)1 << 32)
+#define TRANSPOSITION_MARKED ((uint64_t)1 << 33)    // Hit since the last sweep
+
+typedef struct {
+    uint64_t check;     // Key ^ data
+    uint64_t data;
+} TranspositionEntry;
+
+typedef struct {
+    _Alignas(64) TranspositionEntry ways[TRANSPOSITION_WAYS];
+} TranspositionBucket;
+
+struct TranspositionTable {
+    TranspositionBucket *buckets;
+    uint64_t mask;      // Buckets - 1
+};
+
+// Function to create a table of about `entries` entries, rounded up to a
+// power of two buckets.
+TranspositionTable *createTranspositionTable(long entries) {
+    TranspositionTable *table = (TranspositionTable*)malloc(sizeof(TranspositionTable));
+    uint64_t buckets = 1;
+    while (buckets * TRANSPOSITION_WAYS < (uint64_t)entries) buckets *= 2;
+    if (table == NULL
+        || (table->buckets = (TranspositionBucket*)aligned_alloc(64, buckets * sizeof(TranspositionBucket))) == NULL) {
+        fprintf(stderr, "Memory allocation failed for transposition table.\n");
+        free(table);
+        return NULL;
+    }
+    for (uint64_t i = 0; i < buckets; i++) {
+        for (int w = 0; w < TRANSPOSITION_WAYS; w++) {
+            table->buckets[i].ways[w].check = 0;
+            table->buckets[i].ways[w].data = 0;
+        }
+    }
+    table->mask = buckets - 1;
+    return table;
+}
+
+void freeTranspositionTable(TranspositionTable *table) {
+    if (table) {
+        free(table->buckets);
+        free(table);
+    }
+}
+
+static void readEntry(const TranspositionEntry *entry, uint64_t *check, uint64_t *data) {
+    *check = __atomic_load_n(&entry->check, __ATOMIC_RELAXED);
+    *data = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+}
+
+static void writeEntry(TranspositionEntry *entry, uint64_t key, uint64_t data) {
+    __atomic_store_n(&entry->data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->check, key ^ data, __ATOMIC_RELAXED);
+}
+
+// Function to find the shot kept for `key`. Returns false when there is none.
+bool probeTransposition(TranspositionTable *table, uint64_t key, int *cell) {
+    TranspositionBucket *bucket = &table->buckets[key & table->mask];
+    for (int w = 0; w < TRANSPOSITION_WAYS; w++) {
+        uint64_t check, data;
+        readEntry(&bucket->ways[w], &check, &data);
+        if ((data & TRANSPOSITION_USED) && (check ^ data) == key) {
+            if (!(data & TRANSPOSITION_MARKED)) writeEntry(&bucket->ways[w], key, data | TRANSPOSITION_MARKED);
+            *cell = (int)(uint32_t)data;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Function to keep the shot chosen for `key`, evicting an entry of its bucket
+// not used lately when the bucket is full.
+void storeTransposition(TranspositionTable *table, uint64_t key, int cell) {
+    TranspositionBucket *bucket = &table->buckets[key & table->mask];
+    uint64_t data = TRANSPOSITION_USED | (uint32_t)cell;
+    int victim = -1;
+
+    for (int w = 0; w < TRANSPOSITION_WAYS; w++) {
+        uint64_t check, old;
+        readEntry(&bucket->ways[w], &check, &old);
+        if (!(old & TRANSPOSITION_USED) || (check ^ old) == key) {
+            writeEntry(&bucket->ways[w], key, data);
+            return;
+        }
+    }
+
+    // The sweep starts at a way taken from the key, so that the hand of the
+    // clock needs no shared state; two sweeps give every entry its second chance.
+    int start = (int)(key >> 62) % TRANSPOSITION_WAYS;
+    for (int step = 0; step < 2 * TRANSPOSITION_WAYS && victim < 0; step++) {
+        TranspositionEntry *entry = &bucket->ways[(start + step) % TRANSPOSITION_WAYS];
+        uint64_t check, old;
+        readEntry(entry, &check, &old);
+        if (old & TRANSPOSITION_MARKED) {
+            writeEntry(entry, check ^ old, old & ~TRANSPOSITION_MARKED);
+        } else {
+            victim = (start + step) % TRANSPOSITION_WAYS;
+        }
+    }
+    writeEntry(&bucket->ways[victim < 0 ? start : victim], key, data);
+}
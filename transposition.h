@@ -0,0 +1,32 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "targeting.h"
+
+// Bounded table of the shots chosen in the positions met lately, keyed by the
+// Zobrist key of the targeter (see zobrist.h). A table may be shared by every
+// thread of a program without a lock.
+//
+// Entries are grouped in buckets of TRANSPOSITION_WAYS that fill one cache
+// line, the bucket of a key given by its low bits. Each entry is two words,
+// the key mixed with the data and the data, written with relaxed atomics; an
+// entry torn by concurrent writers no longer matches its key and reads as a
+// miss. A full bucket evicts with the clock algorithm: a hit marks its entry,
+// and the insertion sweeps the bucket clearing marks until it finds an entry
+// that was not used since the last sweep.
+//
+// A program that attaches a table breaks the AI's ties with a random stream
+// seeded from TRANSPOSITION_SEED and the position key, so that the shot stored
+// for a position is the one any game would have computed.
+#define TRANSPOSITION_WAYS 4
+#define TRANSPOSITION_ENTRIES (1 << 16)     // Default size of a table
+#define TRANSPOSITION_SEED 0x3c6ef372fe94f82bu
+
+TranspositionTable *createTranspositionTable(long entries);
+void freeTranspositionTable(TranspositionTable *table);
+bool probeTransposition(TranspositionTable *table, uint64_t key, int *cell);
+void storeTransposition(TranspositionTable *table, uint64_t key, int cell);
+
+#endif // TRANSPOSITION_H
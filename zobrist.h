@@ -0,0 +1,29 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+#include "rng.h"
+
+// Zobrist keys of what a targeter knows about the board it shoots at. The key
+// of a position is the exclusive or of the key of its setting (strategy, board
+// size, fleet) and of one key per box for every miss, open hit and sunk boat
+// box, so a shot updates it with an exclusive or or two.
+//
+// The keys are computed from a fixed seed rather than drawn into a table, so
+// they are the same for every board size and in every process: opening books
+// written by one program are read by the others.
+#define ZOBRIST_SEED 0x5a0b215742a7e5c3u
+
+typedef enum {
+    ZOBRIST_MISS,
+    ZOBRIST_HIT,        // Hit on a boat not sunk yet
+    ZOBRIST_SUNK,       // Box of a sunk boat
+    ZOBRIST_SETTING,    // Strategy, width, height
+    ZOBRIST_FLEET,      // Count of boats of one length
+} ZobristKind;
+
+static inline uint64_t zobristKey(ZobristKind kind, uint64_t index) {
+    return streamSeed(ZOBRIST_SEED + kind, index);
+}
+
+#endif // ZOBRIST_H